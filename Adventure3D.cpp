@@ -1,18 +1,40 @@
 // Adventure3D.cpp : Ce fichier contient la fonction 'main'. L'exécution du programme commence et se termine à cet endroit.
 //
 
+#include <chrono>
 #include <iostream>
 
 #include <pandaFramework.h>
 #include <pandaSystem.h>
 #include <buttonThrower.h>
+#include <graphicsPipeSelection.h>
+#include <load_prc_file.h>
 #include <mouseWatcher.h>
 #include <pgTop.h>
+#include <shader.h>
 #include "cOnscreenText.h"
 
 #include <imgui.h>
 
 #include "adventure_3d_game.hpp"
+#include "asset_pack.hpp"
+#include "benchmarks.hpp"
+#include "carousel_scene.hpp"
+#include "drop_importer.hpp"
+#include "event_bus.hpp"
+#include "frame_arena.hpp"
+#include "frame_scheduler.hpp"
+#include "game_events.hpp"
+#include "hot_reload.hpp"
+#include "input_recorder.hpp"
+#include "mesh_optimizer.hpp"
+#include "profiler.hpp"
+#include "robots_scene.hpp"
+#include "scene_benchmark.hpp"
+#include "scene_manager.hpp"
+#include "shader_cache.hpp"
+#include "startup_graph.hpp"
+#include "text_batch.hpp"
 
 //#include "world.h"
 
@@ -41,8 +63,6 @@ void setup_button(WindowFramework* window_framework, Adventure3D* panda3d_imgui_
 {
     if (auto bt = window_framework->get_mouse().find("kb-events"))
     {
-        auto ev_handler = EventHandler::get_global_event_handler();
-
         ButtonThrower* bt_node = DCAST(ButtonThrower, bt.node());
         std::string ev_name;
 
@@ -52,11 +72,11 @@ void setup_button(WindowFramework* window_framework, Adventure3D* panda3d_imgui_
             ev_name = "imgui-button-down";
             bt_node->set_button_down_event(ev_name);
         }
-        ev_handler->add_hook(ev_name, [](const Event* ev, void* user_data) {
-            const auto& key_name = ev->get_parameter(0).get_string_value();
-            const auto& button = ButtonRegistry::ptr()->get_button(key_name);
-            static_cast<Adventure3D*>(user_data)->on_button_down_or_up(button, true);
-            }, panda3d_imgui_helper);
+        EventBus::bridge<ButtonEvent>(ev_name, [](const Event* ev, ButtonEvent& event) {
+            event.button = ButtonRegistry::ptr()->get_button(ev->get_parameter(0).get_string_value());
+            event.down = true;
+            return true;
+            });
 
         ev_name = bt_node->get_button_up_event();
         if (ev_name.empty())
@@ -64,11 +84,11 @@ void setup_button(WindowFramework* window_framework, Adventure3D* panda3d_imgui_
             ev_name = "imgui-button-up";
             bt_node->set_button_up_event(ev_name);
         }
-        ev_handler->add_hook(ev_name, [](const Event* ev, void* user_data) {
-            const auto& key_name = ev->get_parameter(0).get_string_value();
-            const auto& button = ButtonRegistry::ptr()->get_button(key_name);
-            static_cast<Adventure3D*>(user_data)->on_button_down_or_up(button, false);
-            }, panda3d_imgui_helper);
+        EventBus::bridge<ButtonEvent>(ev_name, [](const Event* ev, ButtonEvent& event) {
+            event.button = ButtonRegistry::ptr()->get_button(ev->get_parameter(0).get_string_value());
+            event.down = false;
+            return true;
+            });
 
         ev_name = bt_node->get_keystroke_event();
         if (ev_name.empty())
@@ -76,13 +96,138 @@ void setup_button(WindowFramework* window_framework, Adventure3D* panda3d_imgui_
             ev_name = "imgui-keystroke";
             bt_node->set_keystroke_event(ev_name);
         }
-        ev_handler->add_hook(ev_name, [](const Event* ev, void* user_data) {
-            wchar_t keycode = ev->get_parameter(0).get_wstring_value()[0];
-            static_cast<Adventure3D*>(user_data)->on_keystroke(keycode);
+        EventBus::bridge<KeystrokeEvent>(ev_name, [](const Event* ev, KeystrokeEvent& event) {
+            event.keycode = ev->get_parameter(0).get_wstring_value()[0];
+            return true;
+            });
+
+        EventBus::subscribe<ButtonEvent>([](const ButtonEvent& event, void* user_data) {
+            static_cast<Adventure3D*>(user_data)->on_button_down_or_up(event.button, event.down);
+            }, panda3d_imgui_helper);
+        EventBus::subscribe<KeystrokeEvent>([](const KeystrokeEvent& event, void* user_data) {
+            static_cast<Adventure3D*>(user_data)->on_keystroke(event.keycode);
             }, panda3d_imgui_helper);
     }
 }
 
+void sysExit(const Event* eventPtr, void* dataPtr);
+
+void setup_input_recorder(WindowFramework* window_framework, int argc, char* argv[])
+{
+    InputRecorder* recorder = InputRecorder::get_global_ptr();
+    // Note: headless runs have no keyboard; replays throw the button events
+    // with the default names.
+    if (window_framework->get_graphics_window() != NULL)
+    {
+        recorder->attach(window_framework->get_mouse().find("kb-events"));
+    }
+
+    // "--record <file>" saves the session's input, "--replay <file>" plays
+    // it back at a fixed timestep (input-replay-dt), then quits.
+    for (int k = 1; k + 1 < argc; ++k)
+    {
+        if (strcmp(argv[k], "--record") == 0)
+        {
+            recorder->start_recording(Filename::from_os_specific(argv[k + 1]));
+        }
+        else if (strcmp(argv[k], "--replay") == 0 && recorder->start_replay(Filename::from_os_specific(argv[k + 1])))
+        {
+            EventHandler::get_global_event_handler()->add_hook(InputRecorder::REPLAY_DONE_EVENT_NAME, sysExit, NULL);
+        }
+    }
+}
+
+// "--headless" runs the game without a display, for CI and batch nodes:
+// the scenes update but nothing is rendered. "--headless offscreen"
+// renders to an offscreen software buffer instead.
+enum HeadlessMode
+{
+    HM_off,
+    HM_no_render,
+    HM_offscreen
+};
+
+HeadlessMode get_headless_mode(int argc, char* argv[])
+{
+    for (int k = 1; k < argc; ++k)
+    {
+        if (strcmp(argv[k], "--headless") == 0)
+        {
+            return k + 1 < argc && strcmp(argv[k + 1], "offscreen") == 0 ? HM_offscreen : HM_no_render;
+        }
+    }
+    return HM_off;
+}
+
+WindowFramework* open_headless_window(PandaFramework& framework, HeadlessMode mode)
+{
+    // Frames go as fast as the CPU allows.
+    load_prc_file_data("headless", "sync-video false");
+
+    PT(GraphicsPipe) pipe = GraphicsPipeSelection::get_global_ptr()->make_module_pipe("p3tinydisplay");
+    if (pipe == NULL)
+    {
+        nout << "ERROR: the tinydisplay module is needed for headless runs." << std::endl;
+        return NULL;
+    }
+
+    WindowFramework* window_framework = framework.open_window(WindowProperties::size(800, 600),
+                                                              GraphicsPipe::BF_refuse_window, pipe);
+    if (window_framework != NULL && mode == HM_no_render)
+    {
+        // The buffer is still there for the scenes, the camera and the 2d
+        // layers, but the engine skips its cull and draw.
+        window_framework->get_graphics_output()->set_active(false);
+    }
+    return window_framework;
+}
+
+struct HeadlessStepping
+{
+    PandaFramework* frameworkPtr;
+    int frames;
+    int steppedFrames;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Steps the game at a fixed 60 Hz of game time, whatever the real time,
+// and stops after "--frames <count>" frames (never by default), printing
+// the simulation throughput.
+void setup_headless_stepping(PandaFramework& framework, int argc, char* argv[])
+{
+    static HeadlessStepping stepping;
+    stepping.frameworkPtr = &framework;
+    stepping.frames = 0;
+    stepping.steppedFrames = 0;
+    stepping.start = std::chrono::steady_clock::now();
+    for (int k = 1; k + 1 < argc; ++k)
+    {
+        if (strcmp(argv[k], "--frames") == 0)
+        {
+            stepping.frames = atoi(argv[k + 1]);
+        }
+    }
+
+    ClockObject* clock = ClockObject::get_global_clock();
+    clock->set_mode(ClockObject::M_non_real_time);
+    clock->set_frame_rate(60);
+
+    PT(GenericAsyncTask) stepping_task = new GenericAsyncTask("headlessSteppingTask", [](GenericAsyncTask*, void* user_data) {
+        HeadlessStepping* stepping = static_cast<HeadlessStepping*>(user_data);
+        if (++stepping->steppedFrames == stepping->frames)
+        {
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stepping->start).count();
+            std::cout << "headless: " << stepping->steppedFrames << " frames in " << seconds << " s, "
+                      << stepping->steppedFrames / seconds << " frames/s" << std::endl;
+            stepping->frameworkPtr->set_exit_flag();
+            return AsyncTask::DS_done;
+        }
+        return AsyncTask::DS_cont;
+        }, &stepping);
+    stepping_task->set_sort(1000);
+    AsyncTaskManager::get_global_ptr()->add(stepping_task);
+}
+
 void setup_mouse(WindowFramework* window_framework)
 {
     window_framework->enable_keyboard();
@@ -146,29 +291,11 @@ void displayConsoleLog(const Event* eventPtr, void* dataPtr)
     return;
 }
 
-void changeScene(const Event* eventPtr, void* dataPtr)
+void sysExit(const Event* eventPtr, void* dataPtr)
 {
-    std::cout << "Change Scene" << std::endl;
-    framework.close_all_windows();
-    //framework.open_framework();
-    framework.set_window_title("Super Amandine3D - Scene 2");
-    // open the window
-    WindowFramework* window_framework = framework.open_window();
-    GraphicsWindow* window = window_framework->get_graphics_window();
-    // setup Panda3D mouse for pixel2d
-    setup_mouse(window_framework);
-
-
-    // use if the context is in different DLL.
-    //ImGui::SetCurrentContext(panda3d_imgui_helper.get_context());
-
-
-
-    //World world = World(window_framework);
-    //world.~World();
-    // do the main loop, equal to run() in python
-    framework.main_loop();
-    return;
+    // Not from the static destructors, once the window is gone.
+    ShaderCache::get_global_ptr()->set_gsg(NULL);
+    exit(0);
 }
 
 
@@ -179,16 +306,65 @@ int main(int argc, char* argv[])
 
     framework.open_framework();
 
+    // "pack-assets [directory] [pack]" builds the asset pack.
+    if (argc >= 2 && strcmp(argv[1], "pack-assets") == 0)
+    {
+        const bool built = AssetPack::build(argc >= 3 ? argv[2] : "models", argc >= 4 ? argv[3] : "models.pack");
+        framework.close_framework();
+        return built ? 0 : 1;
+    }
+    AssetPack::mount();
+
+    // "optimize-meshes [model...]" writes the optimized meshes.
+    if (argc >= 2 && strcmp(argv[1], "optimize-meshes") == 0)
+    {
+        const int status = MeshOptimizer::run(argc, argv);
+        framework.close_framework();
+        return status;
+    }
+
+    // "bench-scene" renders a scene, offscreen.
+    if (argc >= 2 && strcmp(argv[1], "bench-scene") == 0)
+    {
+        WindowFramework* buffer_framework = open_headless_window(framework, HM_offscreen);
+        const int status = buffer_framework != NULL ? run_scene_benchmark(buffer_framework, argc, argv) : 1;
+        framework.close_framework();
+        return status;
+    }
+
+    // "bench-<name> [arguments]" runs a benchmark instead of the game.
+    if (argc >= 2 && strncmp(argv[1], "bench-", 6) == 0)
+    {
+        const int status = run_benchmark(argc, argv);
+        framework.close_framework();
+        return status;
+    }
+
     // set the window title to My Panda3D Window
     framework.set_window_title("Super Amandine3D");
 
-    // open the window
-    WindowFramework* window_framework = framework.open_window();
+    // open the window, or a buffer when headless
+    const HeadlessMode headless_mode = get_headless_mode(argc, argv);
+    WindowFramework* window_framework = headless_mode == HM_off ?
+        framework.open_window() :
+        open_headless_window(framework, headless_mode);
+    if (window_framework == NULL)
+    {
+        framework.close_framework();
+        return 1;
+    }
+    // NULL when headless
     GraphicsWindow* window = window_framework->get_graphics_window();
+    ShaderCache::get_global_ptr()->set_gsg(window_framework->get_graphics_output()->get_gsg());
+    // Before any asset loads, so that the scenes get tracked.
+    HotReload::get_global_ptr()->start();
 
 
     // setup Panda3D mouse for pixel2d
-    setup_mouse(window_framework);
+    if (window != NULL)
+    {
+        setup_mouse(window_framework);
+    }
 
     // This creates the on screen title that is in every tutorial
     title.set_text("Mon premier jeu Panda3D");
@@ -197,71 +373,133 @@ int main(int argc, char* argv[])
     title.set_scale(0.07);
     title.reparent_to(window_framework->get_aspect_2d());
 
+    // HUD labels share a few Geoms instead of one node each.
+    TextBatch hud_batch(window_framework->get_aspect_2d(), "hud-batch");
+    title.set_batch(&hud_batch);
+
 
     // setup ImGUI for Panda3D
     Adventure3D panda3d_imgui_helper(window, window_framework->get_pixel_2d());
-    panda3d_imgui_helper.setup_style();
-    panda3d_imgui_helper.setup_geom();
-    panda3d_imgui_helper.setup_shader(Filename("shader"));
-    panda3d_imgui_helper.setup_font();
-    panda3d_imgui_helper.setup_event();
-    panda3d_imgui_helper.on_window_resized();
-    panda3d_imgui_helper.enable_file_drop();
+
+    // Every scene stays resident once loaded; switching only reparents
+    // its root under render, so the window and the GSG stay alive.
+    SceneManager scene_manager(window_framework);
+
+    // "carousels [count]" fills the carousel scene with a grid of them, for
+    // stress tests; the count can be changed later from its panel.
+    const bool many_carousels = argc >= 2 && strcmp(argv[1], "carousels") == 0;
+    const int carousel_count = many_carousels && argc >= 3 && strncmp(argv[2], "--", 2) != 0 ? atoi(argv[2]) : 1;
+    scene_manager.register_scene("carousel", std::unique_ptr<Scene>(new CarouselScene(carousel_count)));
+
+    // "robots [pairs]" starts with the boxing robots, optionally scaled up.
+    const bool start_with_robots = argc >= 2 && strcmp(argv[1], "robots") == 0;
+    const int robot_pairs = start_with_robots && argc >= 3 && strncmp(argv[2], "--", 2) != 0 ? atoi(argv[2]) : 1;
+    scene_manager.register_scene("robots", std::unique_ptr<Scene>(new RobotsScene(robot_pairs)));
+    const std::string start_scene = start_with_robots ? "robots" : "carousel";
+
+    // The startup steps run as a graph: font baking, shader loading and
+    // model loading overlap, while the steps touching the window, the
+    // events or render stay on the main thread.
+    StartupGraph startup;
+    PT(Shader) imgui_shader;
+    startup.add("imgui style", [&]() {
+        panda3d_imgui_helper.setup_style();
+        }, StartupGraph::A_main_thread);
+    const int imgui_geom = startup.add("imgui geom", [&]() {
+        panda3d_imgui_helper.setup_geom();
+        }, StartupGraph::A_main_thread);
+    const int imgui_shader_load = startup.add("imgui shader load", [&]() {
+        imgui_shader = Adventure3D::load_shader(Filename("shader"));
+        });
+    const int imgui_shader_apply = startup.add("imgui shader", [&]() {
+        panda3d_imgui_helper.setup_shader(imgui_shader);
+        }, StartupGraph::A_main_thread);
+    // Baked on a worker; no other step touches the font atlas.
+    startup.add("imgui font", [&]() {
+        panda3d_imgui_helper.setup_font();
+        });
+    startup.add("imgui input", [&]() {
+        panda3d_imgui_helper.setup_event();
+        panda3d_imgui_helper.on_window_resized();
+        panda3d_imgui_helper.enable_file_drop();
+        if (window == NULL)
+        {
+            GraphicsOutput* buffer = window_framework->get_graphics_output();
+            panda3d_imgui_helper.on_window_resized(LVecBase2(static_cast<float>(buffer->get_x_size()), static_cast<float>(buffer->get_y_size())));
+        }
+        }, StartupGraph::A_main_thread);
+    const int scene_load = startup.add("load " + start_scene, [&]() {
+        scene_manager.load(start_scene);
+        });
+    const int scene_enter = startup.add("enter " + start_scene, [&]() {
+        scene_manager.switch_to(start_scene);
+        }, StartupGraph::A_main_thread);
+    // setup_geom() sets the whole render state of the ImGui root, shader
+    // included.
+    startup.add_dependency(imgui_shader_apply, imgui_geom);
+    startup.add_dependency(imgui_shader_apply, imgui_shader_load);
+    startup.add_dependency(scene_enter, scene_load);
+    startup.run();
+    HotReload::get_global_ptr()->track_shader(panda3d_imgui_helper.get_root(),
+        Filename("shader") / "panda3d_imgui.vert.glsl", Filename("shader") / "panda3d_imgui.frag.glsl");
 
     // setup Panda3D task and key event
     setup_render(&panda3d_imgui_helper);
-    setup_button(window_framework, &panda3d_imgui_helper);
+    if (window != NULL)
+    {
+        setup_button(window_framework, &panda3d_imgui_helper);
+    }
 
-    EventHandler::get_global_event_handler()->add_hook("window-event", [](const Event*, void* user_data) {
+    EventBus::bridge<WindowEvent>("window-event", [](const Event* ev, WindowEvent& event) {
+        event.windowPtr = ev->get_num_parameters() > 0 ? DCAST(GraphicsWindow, ev->get_parameter(0).get_ptr()) : NULL;
+        return true;
+        });
+    EventBus::subscribe<WindowEvent>([](const WindowEvent&, void* user_data) {
         static_cast<Adventure3D*>(user_data)->on_window_resized();
         }, &panda3d_imgui_helper);
 
     // use if the context is in different DLL.
     //ImGui::SetCurrentContext(panda3d_imgui_helper.get_context());
 
-    EventHandler::get_global_event_handler()->add_hook(Adventure3D::NEW_FRAME_EVENT_NAME, [](const Event*) {
+    EventBus::subscribe<NewFrameEvent>([](const NewFrameEvent&, void*) {
         // draw my GUI
         on_imgui_new_frame();
         });
 
     window_framework->get_panda_framework()->define_key("m", "sysExit", displayConsoleLog, NULL);
-    window_framework->get_panda_framework()->define_key("n", "sysExit", changeScene, NULL);
-
-    std::cout << "Before main_loop()" << std::endl;
-
-    if (argc == 2 && strcmp(argv[1], "robots") == 0)
-    {
-        std::cout << argv[1] << std::endl;
-        //Robots robots = Robots(window_framework);
-        //robots.~Robots();
-        // do the main loop, equal to run() in python
-        framework.main_loop();
-    }
-    else
+    window_framework->get_panda_framework()->define_key("n", "changeScene", SceneManager::change_scene, &scene_manager);
+    window_framework->get_panda_framework()->define_key("escape", "sysExit", sysExit, NULL);
+    window_framework->get_panda_framework()->define_key("f3", "toggleProfiler", Profiler::toggle, NULL);
+    window_framework->get_panda_framework()->define_key(Adventure3D::DROPFILES_EVENT_NAME, "importDroppedFiles", DropImporter::on_files_dropped, &panda3d_imgui_helper);
+    DropImporter::get_global_ptr()->init(window_framework->get_render(), window_framework->get_camera_group());
+    Profiler::get_global_ptr()->init();
+
+    // Measure every frame against frame-budget-ms, not only those running
+    // deferred work.
+    FrameScheduler::get_global_ptr();
+    FrameArena::get_global_ptr();
+
+    if (headless_mode != HM_off)
     {
-        // Create an instance of our class
-        
-        // REMPLACER INSTANCIATION
-        
-        //World world = World(window_framework);
-        panda3d_imgui_helper.init_scene(window_framework);
-        
-        // FIN REMPLACEMENT INSTANCIATION
-        
-        //world.~World();
-        // do the main loop, equal to run() in python
-        framework.main_loop();
-
+        setup_headless_stepping(framework, argc, argv);
     }
 
+    // Last, so that a replay starts with everything else in place.
+    setup_input_recorder(window_framework, argc, argv);
 
+    std::cout << "Before main_loop()" << std::endl;
 
+    // Have the other scene ready by the time the player presses "n".
+    scene_manager.preload(start_with_robots ? "carousel" : "robots");
+    startup.report_after_first_frame();
 
-
+    // do the main loop, equal to run() in python
+    framework.main_loop();
 
     std::cout << "After main_loop()" << std::endl;
 
     // close the window framework
+    ShaderCache::get_global_ptr()->set_gsg(NULL);
     framework.close_framework();
 
 
@@ -25,14 +25,11 @@
 #ifndef WORLD_H_
 #define WORLD_H_
 
-#include "cLerpFunctionInterval.h"
-#include "cLerpNodePathInterval.h"
-#include "cMetaInterval.h"
-
 #pragma once
 
+#include <memory>
+
 #include <nodePath.h>
-using std::vector;
 
 class Texture;
 class ButtonMap;
@@ -44,7 +41,6 @@ struct ImGuiContext;
 class Adventure3D
 {
 public:
-    static constexpr const char* NEW_FRAME_EVENT_NAME = "imgui-new-frame";
     static constexpr const char* SETUP_CONTEXT_EVENT_NAME = "imgui-setup-context";
     static constexpr const char* DROPFILES_EVENT_NAME = "imgui-dropfiles";
 
@@ -63,9 +59,12 @@ public:
     void setup_geom();
     void setup_shader(const Filename& shader_dir_path);
     void setup_shader(Shader* shader);
+    /** Load the ImGui shader, from any thread. */
+    static PT(Shader) load_shader(const Filename& shader_dir_path);
     void setup_font();
     void setup_font(const char* font_filename, float font_size);
     void setup_event();
+    /** Accept files dropped on the window. Windows only: elsewhere, see DropImporter. */
     void enable_file_drop();
 
     void on_window_resized();
@@ -84,10 +83,8 @@ public:
 
     /** Get mouse position when files are dropped. */
     const LVecBase2& get_dropped_point() const;
-    void init_scene(WindowFramework* windowFrameworkPtr);
 
 private:
-    typedef CLerpFunctionInterval<double> DoubleLerpFunctionInterval;
     void setup_font_texture();
     NodePath create_geomnode(const GeomVertexData* vdata);
 
@@ -112,55 +109,7 @@ private:
     std::vector<Filename> dropped_files_;
     LVecBase2 dropped_point_;
 
-    // Game World attributes
-
-    enum LightId
-    {
-        L_light1,
-        L_light2
-    };
-
-    enum BlinkId
-    {
-        B_blink_on,
-        B_blink_off
-    };
-
-    enum PandaId
-    {
-        P_panda1,
-        P_panda2,
-        P_panda3,
-        P_panda4,
-        P_pandas
-    };
-
-    void load_models();
-    void setup_lights();
-    void start_carousel();
-    template<int pandaId> static void oscillate_panda(const double& rad, void* dataPtr);
-
     Adventure3D(); // to prevent use of the default constructor
-    template<int lightId, int blinkId> static void call_blink_lights(void* dataPtr);
-    void blink_lights(LightId lightId, BlinkId blinkId);
-    static AsyncTask::DoneStatus step_interval_manager(GenericAsyncTask* taskPtr, void* dataPtr);
-
-    PT(WindowFramework) m_windowFrameworkPtr;
-    PT(Texture) m_lightOffTexPtr;
-    PT(Texture) m_lightOnTexPtr;
-    PT(CLerpNodePathInterval) m_carouselSpinIntervalPtr;
-    PT(CMetaInterval) m_lightBlinkIntervalPtr;
-    vector<PT(DoubleLerpFunctionInterval)> m_moveIntervalPtrVec;
-    vector<DoubleLerpFunctionInterval::LerpFunc*> m_lerpFuncPtrVec;
-    NodePath m_titleNp;
-    NodePath m_carouselNp;
-    NodePath m_lights1Np;
-    NodePath m_lights2Np;
-    NodePath m_envNp;
-    vector<NodePath> m_pandasNp;
-    vector<NodePath> m_modelsNp;
-    static void sys_exit(const Event* eventPtr, void* dataPtr);
-    static void removeNode(const Event* eventPtr, void* dataPtr);
 };
 
 // ************************************************************************************************
@@ -0,0 +1,155 @@
+/*
+ * alloc_stats.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <memoryHook.h>
+
+#include "alloc_stats.hpp"
+
+#ifdef ADVENTURE3D_ALLOC_STATS
+
+namespace
+{
+    std::atomic<size_t> allocations(0);
+    std::atomic<size_t> bytes(0);
+    std::atomic<size_t> pandaAllocations(0);
+    std::atomic<size_t> pandaBytes(0);
+
+    // Panda's hook, counting. Frees go to the hook it copies, whichever
+    // hook allocated the memory.
+    class CountingMemoryHook : public MemoryHook
+    {
+    public:
+        CountingMemoryHook(const MemoryHook& copy)
+            : MemoryHook(copy)
+        {
+        }
+
+        void* heap_alloc_single(size_t size) override
+        {
+            count(size);
+            return MemoryHook::heap_alloc_single(size);
+        }
+
+        void* heap_alloc_array(size_t size) override
+        {
+            count(size);
+            return MemoryHook::heap_alloc_array(size);
+        }
+
+        void* heap_realloc_array(void* ptr, size_t size) override
+        {
+            count(size);
+            return MemoryHook::heap_realloc_array(ptr, size);
+        }
+
+    private:
+        static void count(size_t size)
+        {
+            pandaAllocations.fetch_add(1, std::memory_order_relaxed);
+            pandaBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    };
+
+    void* counted_alloc(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+bool AllocStats::is_enabled()
+{
+    return true;
+}
+
+AllocStats::Counts AllocStats::get_counts()
+{
+    Counts counts;
+    counts.allocations = allocations.load(std::memory_order_relaxed);
+    counts.bytes = bytes.load(std::memory_order_relaxed);
+    counts.pandaAllocations = pandaAllocations.load(std::memory_order_relaxed);
+    counts.pandaBytes = pandaBytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void AllocStats::count_panda_allocations()
+{
+    static CountingMemoryHook* hookPtr = NULL;
+    if (hookPtr == NULL)
+    {
+        // Note: never deleted, Panda may free through it until exit.
+        hookPtr = new CountingMemoryHook(*memory_hook);
+        memory_hook = hookPtr;
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* ptr = counted_alloc(size);
+    if (ptr == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_alloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#else
+
+bool AllocStats::is_enabled()
+{
+    return false;
+}
+
+AllocStats::Counts AllocStats::get_counts()
+{
+    return Counts();
+}
+
+void AllocStats::count_panda_allocations()
+{
+}
+
+#endif
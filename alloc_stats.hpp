@@ -0,0 +1,46 @@
+/*
+ * alloc_stats.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * AllocStats module: counts the calls to the global operator new, so that
+ * benchmarks can report the allocations done by a piece of code. The
+ * counters are relaxed atomics: the replacement costs an increment.
+ *
+ * Benchmark builds only: the replacement is compiled in with
+ * ADVENTURE3D_ALLOC_STATS defined. Otherwise the game keeps the default
+ * allocator, is_enabled() is false and the counts stay at 0.
+ *
+ * Panda objects (nodes, render states...) allocate through Panda's own
+ * memory hook instead; count_panda_allocations() wraps that hook so they
+ * are counted too, apart. Objects recycled by Panda's deleted chains only
+ * show up when a chain grows.
+ */
+
+#ifndef ALLOC_STATS_HPP_
+#define ALLOC_STATS_HPP_
+
+#include <cstddef>
+
+namespace AllocStats
+{
+    struct Counts
+    {
+        size_t allocations = 0;
+        size_t bytes = 0;
+        size_t pandaAllocations = 0;    // since count_panda_allocations()
+        size_t pandaBytes = 0;
+    };
+
+    bool is_enabled();
+
+    // Since the start of the program.
+    Counts get_counts();
+
+    // Counts the allocations of Panda's memory hook from now on. Main
+    // thread, once, before the code to measure; does nothing unless
+    // enabled.
+    void count_panda_allocations();
+}
+
+#endif /* ALLOC_STATS_HPP_ */
@@ -0,0 +1,81 @@
+/*
+ * animation_cache.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <animBundleNode.h>
+#include <loader.h>
+
+#include "animation_cache.hpp"
+
+AnimationCache* AnimationCache::get_global_ptr()
+{
+    static AnimationCache cache;
+    return &cache;
+}
+
+AnimationCache::AnimationCache()
+{
+}
+
+AnimBundle* AnimationCache::load_clip(const Filename& filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ClipMap::const_iterator it = m_clips.find(filename);
+    if (it != m_clips.end())
+    {
+        return it->second;
+    }
+
+    PT(AnimBundle) animBundlePtr;
+    PT(PandaNode) nodePtr = Loader::get_global_ptr()->load_sync(filename);
+    if (nodePtr != NULL)
+    {
+        animBundlePtr = AnimBundleNode::find_anim_bundle(nodePtr);
+    }
+    if (animBundlePtr == NULL)
+    {
+        nout << "ERROR: no animation found in " << filename << "." << std::endl;
+    }
+
+    // Note: failures are cached too, so a missing clip is reported once.
+    m_clips[filename] = animBundlePtr;
+    return animBundlePtr;
+}
+
+PT(AnimControl) AnimationCache::bind_clip(PartBundle* partBundlePtr, const Filename& filename)
+{
+    // preconditions
+    if (partBundlePtr == NULL)
+    {
+        nout << "ERROR: parameter partBundlePtr cannot be NULL." << std::endl;
+        return NULL;
+    }
+
+    AnimBundle* animBundlePtr = load_clip(filename);
+    if (animBundlePtr == NULL)
+    {
+        return NULL;
+    }
+
+    // The clips were exported with their own bundle name and carry a few
+    // extra tables (ik handles, morphs) the skeleton doesn't have.
+    return partBundlePtr->bind_anim(animBundlePtr,
+        PartGroup::HMF_ok_wrong_root_name |
+        PartGroup::HMF_ok_anim_extra |
+        PartGroup::HMF_ok_part_extra);
+}
+
+int AnimationCache::get_num_clips() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_clips.size());
+}
+
+void AnimationCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_clips.clear();
+}
@@ -0,0 +1,46 @@
+/*
+ * animation_cache.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * AnimationCache module: loads each animation clip once and shares the
+ * resulting AnimBundle between every character that plays it. Only the
+ * AnimControl (the per-instance play head) is created per binding.
+ */
+
+#ifndef ANIMATION_CACHE_HPP_
+#define ANIMATION_CACHE_HPP_
+
+#include <map>
+#include <mutex>
+
+#include <animBundle.h>
+#include <animControl.h>
+#include <filename.h>
+#include <partBundle.h>
+
+class AnimationCache
+{
+public:
+    static AnimationCache* get_global_ptr();
+
+    // Returns the clip, loading it on first use. Safe to call from the
+    // scene loader thread.
+    AnimBundle* load_clip(const Filename& filename);
+
+    // Binds a cached clip to a character's bundle.
+    PT(AnimControl) bind_clip(PartBundle* partBundlePtr, const Filename& filename);
+
+    int get_num_clips() const;
+    void clear();
+
+private:
+    AnimationCache();
+
+    typedef std::map<Filename, PT(AnimBundle)> ClipMap;
+
+    mutable std::mutex m_mutex;
+    ClipMap m_clips;
+};
+
+#endif /* ANIMATION_CACHE_HPP_ */
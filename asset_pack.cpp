@@ -0,0 +1,486 @@
+/*
+ * asset_pack.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#if defined(__WIN32__) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <configVariableString.h>
+#include <virtualFileSystem.h>
+
+#include "asset_pack.hpp"
+
+namespace
+{
+    ConfigVariableString asset_pack
+    ("asset-pack", "models.pack",
+     PRC_DESC("Asset pack mounted at startup, if it exists. Built with "
+              "\"Adventure3D pack-assets\"."));
+
+    ConfigVariableString asset_pack_mount_point
+    ("asset-pack-mount-point", "models",
+     PRC_DESC("Directory of the virtual file system the asset pack shows "
+              "its files in."));
+
+    // The header is the magic, the version and the number of entries. Each
+    // entry is its offset, size, hash and timestamp on 8 bytes, then the
+    // length of its path on 4 bytes and the path.
+    const char PACK_MAGIC[4] = { 'A', '3', 'D', 'P' };
+    const unsigned int PACK_VERSION = 1;
+    const unsigned long long CONTENT_ALIGNMENT = 16;
+
+    // Authoring files, which the game never loads.
+    const char* const SOURCE_EXTENSIONS[] = { "mb", "ma", "blend", "max", "psd" };
+
+    unsigned long long hash_bytes(const std::string& bytes)
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (char c : bytes)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    unsigned long long align_offset(unsigned long long offset)
+    {
+        return (offset + CONTENT_ALIGNMENT - 1) & ~(CONTENT_ALIGNMENT - 1);
+    }
+
+    template<typename T>
+    void write_value(std::ostream& output, T value)
+    {
+        output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    bool read_value(const char*& cursor, const char* end, T& value)
+    {
+        if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(T)))
+        {
+            return false;
+        }
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    bool is_source(const Filename& filename)
+    {
+        const std::string extension = filename.get_extension();
+        return std::find(std::begin(SOURCE_EXTENSIONS), std::end(SOURCE_EXTENSIONS), extension) != std::end(SOURCE_EXTENSIONS);
+    }
+
+    // Paths relative to `dir', '/' separated.
+    void list_files(const Filename& dir, const std::string& prefix, std::vector<std::string>& paths)
+    {
+        vector_string names;
+        dir.scan_directory(names);
+        for (const std::string& name : names)
+        {
+            const Filename filename(dir, name);
+            if (filename.is_directory())
+            {
+                list_files(filename, prefix + name + "/", paths);
+            }
+            else if (!is_source(filename))
+            {
+                paths.push_back(prefix + name);
+            }
+        }
+    }
+
+    // Reads a range of the mapping in place.
+    class MappedStreamBuf : public std::streambuf
+    {
+    public:
+        MappedStreamBuf(const char* data, size_t size)
+        {
+            char* begin = const_cast<char*>(data);
+            setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+        {
+            char* base = dir == std::ios_base::beg ? eback() : (dir == std::ios_base::cur ? gptr() : egptr());
+            if ((which & std::ios_base::in) == 0 || offset < eback() - base || offset > egptr() - base)
+            {
+                return pos_type(off_type(-1));
+            }
+            setg(eback(), base + offset, egptr());
+            return pos_type(gptr() - eback());
+        }
+
+        pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+        {
+            return seekoff(off_type(position), std::ios_base::beg, which);
+        }
+
+        std::streamsize showmanyc() override
+        {
+            return egptr() - gptr();
+        }
+    };
+
+    class MappedStream : public std::istream
+    {
+    public:
+        MappedStream(const char* data, size_t size)
+            : std::istream(NULL),
+            m_buffer(data, size)
+        {
+            rdbuf(&m_buffer);
+        }
+
+    private:
+        MappedStreamBuf m_buffer;
+    };
+}
+
+PT(AssetPack) AssetPack::open(const Filename& packFile)
+{
+    PT(AssetPack) packPtr = new AssetPack;
+    if (!packPtr->map(packFile) || !packPtr->read_contents())
+    {
+        return NULL;
+    }
+    return packPtr;
+}
+
+bool AssetPack::mount()
+{
+    const Filename packFile = Filename::from_os_specific(asset_pack);
+    if (packFile.empty() || !packFile.exists())
+    {
+        return false;
+    }
+
+    PT(AssetPack) packPtr = open(packFile);
+    if (packPtr == NULL)
+    {
+        nout << "ERROR: " << packFile << " is not an asset pack." << std::endl;
+        return false;
+    }
+    // Mounted last, so it is searched before the real directory.
+    if (!VirtualFileSystem::get_global_ptr()->mount(packPtr, asset_pack_mount_point.get_value(), 0))
+    {
+        nout << "ERROR: unable to mount " << packFile << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool AssetPack::build(const Filename& dir, const Filename& packFile)
+{
+    // preconditions
+    if (!dir.is_directory())
+    {
+        nout << "ERROR: " << dir << " is not a directory." << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> paths;
+    list_files(dir, "", paths);
+    std::sort(paths.begin(), paths.end());
+
+    // Contents are stored once, whatever the number of paths having them.
+    std::vector<std::string> contents;
+    std::multimap<unsigned long long, size_t> contentsByHash;
+    std::vector<size_t> contentOfPath;
+    std::vector<time_t> timestamps;
+    unsigned long long totalSize = 0;
+    for (const std::string& path : paths)
+    {
+        const Filename filename(dir, path);
+        std::ifstream input(filename.to_os_specific().c_str(), std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        if (input.bad())
+        {
+            nout << "ERROR: unable to read " << filename << "." << std::endl;
+            return false;
+        }
+        totalSize += bytes.size();
+        timestamps.push_back(filename.get_timestamp());
+
+        const unsigned long long hash = hash_bytes(bytes);
+        size_t content = contents.size();
+        auto range = contentsByHash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (contents[it->second] == bytes)
+            {
+                content = it->second;
+                break;
+            }
+        }
+        if (content == contents.size())
+        {
+            contentsByHash.insert(std::make_pair(hash, content));
+            contents.push_back(std::move(bytes));
+        }
+        contentOfPath.push_back(content);
+    }
+
+    unsigned long long offset = sizeof(PACK_MAGIC) + 2 * sizeof(unsigned int);
+    for (const std::string& path : paths)
+    {
+        offset += 4 * sizeof(unsigned long long) + sizeof(unsigned int) + path.size();
+    }
+    std::vector<unsigned long long> offsets;
+    for (const std::string& bytes : contents)
+    {
+        offset = align_offset(offset);
+        offsets.push_back(offset);
+        offset += bytes.size();
+    }
+
+    std::ofstream output(packFile.to_os_specific().c_str(), std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        nout << "ERROR: unable to create " << packFile << "." << std::endl;
+        return false;
+    }
+    output.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+    write_value(output, PACK_VERSION);
+    write_value(output, static_cast<unsigned int>(paths.size()));
+    for (size_t k = 0; k < paths.size(); ++k)
+    {
+        const std::string& bytes = contents[contentOfPath[k]];
+        write_value(output, offsets[contentOfPath[k]]);
+        write_value(output, static_cast<unsigned long long>(bytes.size()));
+        write_value(output, hash_bytes(bytes));
+        write_value(output, static_cast<unsigned long long>(timestamps[k]));
+        write_value(output, static_cast<unsigned int>(paths[k].size()));
+        output.write(paths[k].data(), paths[k].size());
+    }
+    for (size_t k = 0; k < contents.size(); ++k)
+    {
+        while (static_cast<unsigned long long>(output.tellp()) < offsets[k])
+        {
+            output.put('\0');
+        }
+        output.write(contents[k].data(), contents[k].size());
+    }
+    if (!output)
+    {
+        nout << "ERROR: unable to write " << packFile << "." << std::endl;
+        return false;
+    }
+
+    std::cout << "pack-assets: " << paths.size() << " files, " << contents.size() << " distinct, "
+              << totalSize << " bytes packed in " << static_cast<unsigned long long>(output.tellp())
+              << " bytes to " << packFile << std::endl;
+    return true;
+}
+
+AssetPack::AssetPack()
+    : m_data(NULL),
+    m_size(0)
+{
+}
+
+AssetPack::~AssetPack()
+{
+    if (m_data != NULL)
+    {
+#if defined(__WIN32__) || defined(_WIN32)
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+}
+
+bool AssetPack::has_file(const Filename& file) const
+{
+    return find_entry(file) != NULL || is_directory(file);
+}
+
+bool AssetPack::is_directory(const Filename& file) const
+{
+    const std::string& path = file.get_fullpath();
+    if (path.empty())
+    {
+        return true;
+    }
+    const std::string prefix = path + "/";
+    EntryMap::const_iterator it = m_entries.lower_bound(prefix);
+    return it != m_entries.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool AssetPack::is_regular_file(const Filename& file) const
+{
+    return find_entry(file) != NULL;
+}
+
+bool AssetPack::read_file(const Filename& file, bool do_uncompress, vector_uchar& result) const
+{
+    const std::string extension = file.get_extension();
+    if (do_uncompress && (extension == "pz" || extension == "gz"))
+    {
+        return VirtualFileMount::read_file(file, do_uncompress, result);
+    }
+
+    const Entry* entryPtr = find_entry(file);
+    if (entryPtr == NULL)
+    {
+        return false;
+    }
+    const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(m_data + entryPtr->offset);
+    result.assign(dataPtr, dataPtr + entryPtr->size);
+    return true;
+}
+
+std::istream* AssetPack::open_read_file(const Filename& file) const
+{
+    const Entry* entryPtr = find_entry(file);
+    if (entryPtr == NULL)
+    {
+        return NULL;
+    }
+    return new MappedStream(m_data + entryPtr->offset, static_cast<size_t>(entryPtr->size));
+}
+
+std::streamsize AssetPack::get_file_size(const Filename& file, std::istream* stream) const
+{
+    return get_file_size(file);
+}
+
+std::streamsize AssetPack::get_file_size(const Filename& file) const
+{
+    const Entry* entryPtr = find_entry(file);
+    return entryPtr != NULL ? static_cast<std::streamsize>(entryPtr->size) : 0;
+}
+
+time_t AssetPack::get_timestamp(const Filename& file) const
+{
+    const Entry* entryPtr = find_entry(file);
+    return entryPtr != NULL ? entryPtr->timestamp : 0;
+}
+
+bool AssetPack::scan_directory(vector_string& contents, const Filename& dir) const
+{
+    if (!is_directory(dir))
+    {
+        return false;
+    }
+
+    const std::string prefix = dir.get_fullpath().empty() ? std::string() : dir.get_fullpath() + "/";
+    for (EntryMap::const_iterator it = m_entries.lower_bound(prefix);
+         it != m_entries.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+    {
+        // Paths are sorted: the files of a subdirectory follow each other.
+        const std::string name = it->first.substr(prefix.size(), it->first.find('/', prefix.size()) - prefix.size());
+        if (contents.empty() || contents.back() != name)
+        {
+            contents.push_back(name);
+        }
+    }
+    return true;
+}
+
+void AssetPack::output(std::ostream& out) const
+{
+    out << m_packFile << " (" << m_entries.size() << " files)";
+}
+
+bool AssetPack::map(const Filename& packFile)
+{
+    m_packFile = packFile;
+#if defined(__WIN32__) || defined(_WIN32)
+    HANDLE file = CreateFileW(packFile.to_os_specific_w().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0 ?
+        CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    // The view keeps the file and the mapping open.
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return false;
+    }
+    m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(packFile.to_os_specific().c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat status;
+    void* dataPtr = fstat(fd, &status) == 0 && status.st_size > 0 ?
+        mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    // The mapping keeps the file open.
+    close(fd);
+    if (dataPtr == MAP_FAILED)
+    {
+        return false;
+    }
+    m_data = static_cast<const char*>(dataPtr);
+    m_size = static_cast<size_t>(status.st_size);
+#endif
+    return m_data != NULL;
+}
+
+bool AssetPack::read_contents()
+{
+    const char* cursor = m_data;
+    const char* const end = m_data + m_size;
+    unsigned int version = 0;
+    unsigned int numEntries = 0;
+    if (m_size < sizeof(PACK_MAGIC) || memcmp(cursor, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0)
+    {
+        return false;
+    }
+    cursor += sizeof(PACK_MAGIC);
+    if (!read_value(cursor, end, version) || version != PACK_VERSION || !read_value(cursor, end, numEntries))
+    {
+        return false;
+    }
+
+    for (unsigned int k = 0; k < numEntries; ++k)
+    {
+        Entry entry;
+        unsigned long long timestamp = 0;
+        unsigned int pathLength = 0;
+        if (!read_value(cursor, end, entry.offset) || !read_value(cursor, end, entry.size) ||
+            !read_value(cursor, end, entry.hash) || !read_value(cursor, end, timestamp) ||
+            !read_value(cursor, end, pathLength) || end - cursor < pathLength ||
+            entry.offset > m_size || entry.size > m_size - entry.offset)
+        {
+            m_entries.clear();
+            return false;
+        }
+        entry.timestamp = static_cast<time_t>(timestamp);
+        m_entries[std::string(cursor, pathLength)] = entry;
+        cursor += pathLength;
+    }
+    return true;
+}
+
+const AssetPack::Entry* AssetPack::find_entry(const Filename& file) const
+{
+    EntryMap::const_iterator it = m_entries.find(file.get_fullpath());
+    return it != m_entries.end() ? &it->second : NULL;
+}
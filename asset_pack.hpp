@@ -0,0 +1,81 @@
+/*
+ * asset_pack.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * AssetPack module: packs a directory of assets in one file, and mounts
+ * that file in the virtual file system in place of the directory. The
+ * pack is memory-mapped: opening a file of it costs no system call, and
+ * its streams read straight from the mapping.
+ *
+ * The pack starts with a table of contents (path, timestamp, offset, size
+ * and FNV-1a hash of every file), then the contents, each stored once:
+ * files with the same bytes share them. It is built with
+ *
+ *    Adventure3D pack-assets [directory=models] [pack=models.pack]
+ *
+ * and mounted at startup, over asset-pack-mount-point, if the asset-pack
+ * file exists. Loose files the pack doesn't have stay visible.
+ */
+
+#ifndef ASSET_PACK_HPP_
+#define ASSET_PACK_HPP_
+
+#include <map>
+#include <string>
+
+#include <filename.h>
+#include <virtualFileMount.h>
+
+class AssetPack : public VirtualFileMount
+{
+public:
+    // Returns NULL if `packFile' can't be mapped or isn't a pack.
+    static PT(AssetPack) open(const Filename& packFile);
+
+    // Mounts asset-pack if it exists. Main thread, before any loading.
+    static bool mount();
+
+    // Packs the files below `dir', sources excepted. Prints what it did.
+    static bool build(const Filename& dir, const Filename& packFile);
+
+    virtual ~AssetPack();
+
+    // VirtualFileMount
+    bool has_file(const Filename& file) const override;
+    bool is_directory(const Filename& file) const override;
+    bool is_regular_file(const Filename& file) const override;
+    bool read_file(const Filename& file, bool do_uncompress, vector_uchar& result) const override;
+    std::istream* open_read_file(const Filename& file) const override;
+    std::streamsize get_file_size(const Filename& file, std::istream* stream) const override;
+    std::streamsize get_file_size(const Filename& file) const override;
+    time_t get_timestamp(const Filename& file) const override;
+    bool scan_directory(vector_string& contents, const Filename& dir) const override;
+    void output(std::ostream& out) const override;
+
+private:
+    struct Entry
+    {
+        unsigned long long offset;
+        unsigned long long size;
+        unsigned long long hash;
+        time_t timestamp;
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+
+    AssetPack();
+
+    bool map(const Filename& packFile);
+    bool read_contents();
+    const Entry* find_entry(const Filename& file) const;
+
+    AssetPack(const AssetPack&); // to prevent copies
+
+    Filename m_packFile;
+    const char* m_data;
+    size_t m_size;
+    EntryMap m_entries;                 // by path, '/' separated
+};
+
+#endif /* ASSET_PACK_HPP_ */
@@ -0,0 +1,427 @@
+/*
+ * benchmarks.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <character.h>
+#include <loader.h>
+#include <nodePathCollection.h>
+#include <thread.h>
+
+#include "alloc_stats.hpp"
+#include "animation_cache.hpp"
+#include "cOnscreenText.h"
+#include "job_system.hpp"
+#include "cpu_skinning.hpp"
+#include "spatial_hash.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    typedef std::chrono::steady_clock BenchClock;
+
+    double seconds_since(BenchClock::time_point start)
+    {
+        return std::chrono::duration<double>(BenchClock::now() - start).count();
+    }
+
+    int int_arg(int argc, char* argv[], int index, int defaultValue)
+    {
+        return argc > index ? std::atoi(argv[index]) : defaultValue;
+    }
+
+    // bench-skinning [robots] [iterations]
+    // Skins the robot model posed on a new frame of its punch clip every
+    // iteration, first with Panda's stock CPU path, then with CpuSkinning.
+    int run_skinning_benchmark(int argc, char* argv[])
+    {
+        const int robotCount = int_arg(argc, argv, 2, 100);
+        const int iterations = int_arg(argc, argv, 3, 100);
+
+        NodePath robotNp(Loader::get_global_ptr()->load_sync("./models/robot"));
+        if (robotNp.is_empty())
+        {
+            std::cerr << "Unable to load ./models/robot" << std::endl;
+            return 1;
+        }
+
+        struct BenchRobot
+        {
+            NodePath np;
+            PT(Character) characterPtr;
+            PT(AnimControl) controlPtr;
+        };
+
+        NodePath rootNp("bench-skinning");
+        std::vector<BenchRobot> robots(robotCount);
+        for (auto& robot : robots)
+        {
+            robot.np = robotNp.copy_to(rootNp);
+            robot.characterPtr = DCAST(Character, robot.np.find("**/+Character").node());
+            robot.controlPtr = AnimationCache::get_global_ptr()->bind_clip(
+                robot.characterPtr->get_bundle(0), "./models/robot_left_punch");
+        }
+
+        // Posing is common to both paths, keep it out of the measures.
+        double poseSeconds = 0;
+        auto pose_all = [&](int iteration) {
+            BenchClock::time_point start = BenchClock::now();
+            for (auto& robot : robots)
+            {
+                robot.controlPtr->pose(iteration % robot.controlPtr->get_num_frames());
+                robot.characterPtr->update();
+            }
+            poseSeconds += seconds_since(start);
+        };
+
+        // Stock path: what Panda does at render time with animated vertices.
+        std::vector<CPT(GeomVertexData)> animatedData;
+        long long vertexCount = 0;
+        for (auto& robot : robots)
+        {
+            NodePathCollection geomNodes = robot.np.find_all_matches("**/+GeomNode");
+            for (int k = 0, k_end = geomNodes.get_num_paths(); k < k_end; ++k)
+            {
+                GeomNode* geomNodePtr = DCAST(GeomNode, geomNodes.get_path(k).node());
+                for (int g = 0, g_end = geomNodePtr->get_num_geoms(); g < g_end; ++g)
+                {
+                    CPT(GeomVertexData) vdataPtr = geomNodePtr->get_geom(g)->get_vertex_data();
+                    if (vdataPtr->get_transform_blend_table() != NULL)
+                    {
+                        animatedData.push_back(vdataPtr);
+                        vertexCount += vdataPtr->get_num_rows();
+                    }
+                }
+            }
+        }
+
+        Thread* currentThreadPtr = Thread::get_current_thread();
+        poseSeconds = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            pose_all(iteration);
+            for (const auto& vdataPtr : animatedData)
+            {
+                vdataPtr->animate_vertices(true, currentThreadPtr);
+            }
+        }
+        const double stockSeconds = seconds_since(start) - poseSeconds;
+
+        // Kernel path.
+        std::vector<std::unique_ptr<CpuSkinner>> skinners;
+        std::vector<CpuSkinner*> skinnerPtrs;
+        long long skinnedCount = 0;
+        for (auto& robot : robots)
+        {
+            NodePathCollection geomNodes = robot.np.find_all_matches("**/+GeomNode");
+            for (int k = 0, k_end = geomNodes.get_num_paths(); k < k_end; ++k)
+            {
+                std::unique_ptr<CpuSkinner> skinner(new CpuSkinner(DCAST(GeomNode, geomNodes.get_path(k).node())));
+                if (skinner->is_valid())
+                {
+                    skinnedCount += skinner->get_num_vertices();
+                    skinnerPtrs.push_back(skinner.get());
+                    skinners.push_back(std::move(skinner));
+                }
+            }
+        }
+
+        poseSeconds = 0;
+        start = BenchClock::now();
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            pose_all(iteration);
+            CpuSkinning::skin_all(skinnerPtrs);
+        }
+        const double kernelSeconds = seconds_since(start) - poseSeconds;
+
+        const double stockRate = vertexCount * iterations / stockSeconds;
+        const double kernelRate = skinnedCount * iterations / kernelSeconds;
+        std::cout << "robots: " << robotCount << ", iterations: " << iterations
+                  << ", vertices per robot: " << (robotCount > 0 ? vertexCount / robotCount : 0) << std::endl;
+        std::cout << "stock:  " << stockRate / 1e6 << " Mvertices/s" << std::endl;
+        std::cout << "kernel: " << kernelRate / 1e6 << " Mvertices/s ("
+                  << SkinningKernel::get_isa_name() << ", "
+                  << CpuSkinning::get_num_threads() << " threads), x"
+                  << kernelRate / stockRate << std::endl;
+        return 0;
+    }
+
+    // Runs `frames' frames of punches between `robotCount' robots laid out
+    // in pairs like RobotsScene does: every frame all the shapes move, and
+    // both arms of every robot are checked against the heads.
+    double run_collision_frames(SpatialHash& collisions, int robotCount, int frames, int& hitCount)
+    {
+        const unsigned int headLayer = 1;
+        const unsigned int armLayer = 2;
+        const float ringSpacing = 20;
+        const int side = static_cast<int>(std::ceil(std::sqrt(robotCount * 0.5)));
+
+        struct BenchRobot
+        {
+            LPoint3f pos;
+            LVector3f forward;
+            int headProxy;
+            int armProxies[2];
+        };
+
+        std::vector<BenchRobot> robots(robotCount);
+        for (int robotId = 0; robotId < robotCount; ++robotId)
+        {
+            const int pairId = robotId / 2;
+            const float sign = (robotId & 1) ? -1.0f : 1.0f;
+            BenchRobot& robot = robots[robotId];
+            robot.pos = LPoint3f((pairId % side) * ringSpacing, (pairId / side) * ringSpacing, 4) +
+                        LVector3f(-1.25f, -1.25f, 0) * sign;
+            robot.forward = LVector3f(0.707f, 0.707f, 0) * sign;
+            robot.headProxy = collisions.add_sphere(robot.pos + LVector3f(0, 0, 3), 1.1f, headLayer, robotId);
+            for (int arm = 0; arm < 2; ++arm)
+            {
+                robot.armProxies[arm] = collisions.add_capsule(robot.pos, robot.pos, 0.5f, armLayer, robotId);
+            }
+        }
+
+        std::vector<int> hits;
+        hitCount = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            for (int robotId = 0; robotId < robotCount; ++robotId)
+            {
+                // Each arm swings back and forth towards the opponent, out
+                // of phase with the other arm and the other robots.
+                BenchRobot& robot = robots[robotId];
+                for (int arm = 0; arm < 2; ++arm)
+                {
+                    const float reach = 1.5f + 1.5f * std::sin(0.1f * frame + robotId + arm * 3.14159f);
+                    const LPoint3f elbow = robot.pos + LVector3f(0, 0, 2.5f) + robot.forward * 0.5f;
+                    collisions.move_capsule(robot.armProxies[arm], elbow, elbow + robot.forward * reach);
+                }
+            }
+            for (int robotId = 0; robotId < robotCount; ++robotId)
+            {
+                hits.clear();
+                collisions.query(robots[robotId].armProxies[0], headLayer, hits);
+                collisions.query(robots[robotId].armProxies[1], headLayer, hits);
+                hitCount += static_cast<int>(hits.size());
+            }
+        }
+        return seconds_since(start);
+    }
+
+    // bench-collision [robots] [frames] [naive]
+    // Punch hit detection between many robots, with the spatial hash and,
+    // when `naive' is 1, with a single cell, which checks every pair.
+    int run_collision_benchmark(int argc, char* argv[])
+    {
+        const int robotCount = int_arg(argc, argv, 2, 1000);
+        const int frames = int_arg(argc, argv, 3, 300);
+        const bool naive = int_arg(argc, argv, 4, 0) != 0;
+
+        SpatialHash collisions(4);
+        int hitCount = 0;
+        const double seconds = run_collision_frames(collisions, robotCount, frames, hitCount);
+        const SpatialHash::Stats& stats = collisions.get_stats();
+
+        std::cout << "robots: " << robotCount << ", frames: " << frames
+                  << ", proxies: " << collisions.get_num_proxies() << std::endl;
+        std::cout << "queries/frame: " << stats.queries / frames
+                  << ", candidates/frame: " << stats.candidates / frames
+                  << ", hits/frame: " << hitCount / frames
+                  << ", relinks/frame: " << stats.relinks / frames << std::endl;
+        std::cout << "spatial hash: " << seconds * 1000 / frames << " ms/frame" << std::endl;
+
+        if (naive)
+        {
+            SpatialHash oneCell(1e6f, 0);
+            int naiveHitCount = 0;
+            const double naiveSeconds = run_collision_frames(oneCell, robotCount, frames, naiveHitCount);
+            std::cout << "pairwise:     " << naiveSeconds * 1000 / frames << " ms/frame, x"
+                      << naiveSeconds / seconds << (naiveHitCount == hitCount ? "" : " (hits differ!)") << std::endl;
+        }
+        return 0;
+    }
+
+    void print_text_copy_result(const char* name, int copies, double seconds,
+                                const AllocStats::Counts& before)
+    {
+        const AllocStats::Counts after = AllocStats::get_counts();
+        std::cout << name << double(after.allocations - before.allocations) / copies << " allocations/op, "
+                  << double(after.bytes - before.bytes) / copies << " bytes/op, "
+                  << double(after.pandaAllocations - before.pandaAllocations) / copies << " Panda allocations/op, "
+                  << double(after.pandaBytes - before.pandaBytes) / copies << " Panda bytes/op, "
+                  << seconds * 1e6 / copies << " us/op" << std::endl;
+    }
+
+    // bench-text-copy [copies]
+    // Copies an onscreen text: shared copies, copies modified afterwards
+    // (which own their text node, as every copy used to) and moves.
+    int run_text_copy_benchmark(int argc, char* argv[])
+    {
+        const int copies = int_arg(argc, argv, 2, 10000);
+        if (!AllocStats::is_enabled())
+        {
+            std::cout << "Note: built without ADVENTURE3D_ALLOC_STATS, the allocations read 0." << std::endl;
+        }
+        AllocStats::count_panda_allocations();
+
+        NodePath rootNp("bench-text-copy");
+        COnscreenText source("source", COnscreenText::TS_screen_title);
+        source.set_text("Adventure 3D");
+        source.reparent_to(rootNp);
+
+        std::vector<COnscreenText> texts;
+        texts.reserve(copies);
+        std::vector<COnscreenText> movedTexts;
+        movedTexts.reserve(copies);
+
+        AllocStats::Counts before = AllocStats::get_counts();
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < copies; ++i)
+        {
+            texts.push_back(source);
+        }
+        print_text_copy_result("shared copy:   ", copies, seconds_since(start), before);
+
+        before = AllocStats::get_counts();
+        start = BenchClock::now();
+        for (int i = 0; i < copies; ++i)
+        {
+            texts[i].set_fg(Colorf(1, 1, 1, 1));
+        }
+        print_text_copy_result("copy on write: ", copies, seconds_since(start), before);
+
+        before = AllocStats::get_counts();
+        start = BenchClock::now();
+        for (int i = 0; i < copies; ++i)
+        {
+            movedTexts.push_back(std::move(texts[i]));
+        }
+        print_text_copy_result("move:          ", copies, seconds_since(start), before);
+        return 0;
+    }
+
+    // bench-jobs [items] [iterations] [threads]
+    // JobSystem scaling from 1 to `threads' threads (all hardware threads
+    // by default): a parallel_for over `items' floats, then a JobGraph of
+    // 64 chains of 16 jobs each.
+    int run_jobs_benchmark(int argc, char* argv[])
+    {
+        const int itemCount = int_arg(argc, argv, 2, 1000000);
+        const int iterations = int_arg(argc, argv, 3, 20);
+        const int maxThreads = int_arg(argc, argv, 4, std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+        const int CHAINS = 64;
+        const int CHAIN_LENGTH = 16;
+
+        std::vector<float> items(itemCount);
+        std::vector<float> chainSums(CHAINS);
+        JobGraph graph;
+        for (int chain = 0; chain < CHAINS; ++chain)
+        {
+            int previous = -1;
+            for (int link = 0; link < CHAIN_LENGTH; ++link)
+            {
+                const int job = graph.add([&chainSums, chain, link]() {
+                    float sum = chainSums[chain];
+                    for (int k = 0; k < 2000; ++k)
+                    {
+                        sum = std::sqrt(sum + k + link);
+                    }
+                    chainSums[chain] = sum;
+                });
+                if (previous >= 0)
+                {
+                    graph.add_dependency(job, previous);
+                }
+                previous = job;
+            }
+        }
+
+        JobSystem* jobSystemPtr = JobSystem::get_global_ptr();
+        double forBaseline = 0;
+        double graphBaseline = 0;
+        std::vector<int> threadCounts;
+        for (int threads = 1; threads < maxThreads; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+
+        for (int threads : threadCounts)
+        {
+            jobSystemPtr->set_num_threads(threads);
+
+            BenchClock::time_point start = BenchClock::now();
+            for (int iteration = 0; iteration < iterations; ++iteration)
+            {
+                jobSystemPtr->parallel_for(0, itemCount, 16384, [&](int first, int last) {
+                    for (int i = first; i < last; ++i)
+                    {
+                        items[i] = std::sqrt(static_cast<float>(i + iteration)) * std::sin(0.001f * i);
+                    }
+                });
+            }
+            const double forSeconds = seconds_since(start) / iterations;
+
+            start = BenchClock::now();
+            for (int iteration = 0; iteration < iterations; ++iteration)
+            {
+                graph.run();
+            }
+            const double graphSeconds = seconds_since(start) / iterations;
+
+            if (threads == 1)
+            {
+                forBaseline = forSeconds;
+                graphBaseline = graphSeconds;
+            }
+            std::cout << threads << " threads: parallel_for " << forSeconds * 1000 << " ms (x"
+                      << forBaseline / forSeconds << "), graph " << graphSeconds * 1000 << " ms (x"
+                      << graphBaseline / graphSeconds << ")" << std::endl;
+        }
+
+        jobSystemPtr->set_num_threads(0);
+        return 0;
+    }
+}
+
+int run_benchmark(int argc, char* argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "bench-skinning") == 0)
+    {
+        return run_skinning_benchmark(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench-collision") == 0)
+    {
+        return run_collision_benchmark(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench-text-copy") == 0)
+    {
+        return run_text_copy_benchmark(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench-jobs") == 0)
+    {
+        return run_jobs_benchmark(argc, argv);
+    }
+
+    std::cerr << "Unknown benchmark " << (argc >= 2 ? argv[1] : "") << std::endl;
+    std::cerr << "Available: bench-skinning [robots] [iterations]" << std::endl;
+    std::cerr << "           bench-collision [robots] [frames] [naive]" << std::endl;
+    std::cerr << "           bench-text-copy [copies]" << std::endl;
+    std::cerr << "           bench-jobs [items] [iterations] [threads]" << std::endl;
+    std::cerr << "           bench-scene <carousel|robots> [frames] [count] [--json <file>] [--csv <file>]" << std::endl;
+    return 1;
+}
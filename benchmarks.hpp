@@ -0,0 +1,20 @@
+/*
+ * benchmarks.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * Benchmarks module: command line benchmarks, run instead of the game as
+ *
+ *    Adventure3D bench-<name> [arguments]
+ *
+ * Each one prints its results on the standard output and returns the
+ * process exit status.
+ */
+
+#ifndef BENCHMARKS_HPP_
+#define BENCHMARKS_HPP_
+
+// Runs the benchmark named by argv[1]. The framework must be open.
+int run_benchmark(int argc, char* argv[]);
+
+#endif /* BENCHMARKS_HPP_ */
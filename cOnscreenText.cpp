@@ -5,25 +5,74 @@
  *      Author: dri
  */
 
+#include <cwctype>
+#include <type_traits>
+
+#include <boundingSphere.h>
+#include <cullTraverser.h>
+#include <cullTraverserData.h>
+#include <geometricBoundingVolume.h>
+#include <lightReMutex.h>
+#include <lightReMutexHolder.h>
+#include <shaderAttrib.h>
+#include <transformState.h>
+
 #include "cOnscreenText.h"
+#include "sdf_text.hpp"
+#include "text_batch.hpp"
+#include "text_layout_cache.hpp"
 
 const float COnscreenText::MARGIN = 0.1;
 const float COnscreenText::SHADOW = 0.4;
 
    // COnscreenText is implemented using the `Pimpl idiom' technique
 // where the `implementation' part is done within struct TextNodeProxy.
-struct COnscreenText::TextNodeProxy : public TextNode
+struct COnscreenText::TextNodeProxy : public TextNode, public TextBatch::Label
    {
    TextNodeProxy(const string& name, COnscreenText::TextStyle style);
    TextNodeProxy(const TextNodeProxy& other);
    virtual ~TextNodeProxy();
    void update_transform_mat();
+   void invalidate_layout(bool styleChanged);
+   void update_layout();
+   void add_segment(const std::wstring& text, float x, float width, float alignFactor);
+   static bool ends_with_space(const std::wstring& text);
+   void update_font_shader();
+   void choose_font();
+   virtual bool cull_callback(CullTraverser* trav, CullTraverserData& data);
+   virtual void compute_internal_bounds(CPT(BoundingVolume)& internalBounds,
+                                        int& internalVertices,
+                                        int pipelineStage,
+                                        Thread* currentThread) const;
+   bool is_batched() const;
+   virtual const TextNode* get_properties() const;
+   virtual LMatrix4f get_placement() const;
+   virtual bool is_visible() const;
+   virtual void on_batch_destroyed();
+   static const int MAX_SEGMENTS;
    LVecBase2f m_scale;
    LVecBase2f m_pos;
    float m_roll;
    float m_wordwrap;
+   Colorf m_outline;
+   float m_outlineWidth;
+   PT(PandaNode) m_layoutRoot;   // places the text on screen
+   PT(PandaNode) m_alignNode;    // aligns the laid out segments
+   std::wstring m_layoutText;
+   float m_layoutWidth;
+   bool m_layoutDirty;
+   bool m_styleDirty;
+   bool m_appendable;
+   bool m_fontChosen;            // the default font or set_font()'s
+   mutable LightReMutex m_layoutLock; // TextNode's own lock is private
+   TextBatch* m_batchPtr;        // draws the text instead of us, if any
+   int m_batchLabel;
+   int m_owners;                 // COnscreenText sharing this proxy
    };
 
+// Appends beyond this many segments lay the whole text out again.
+const int COnscreenText::TextNodeProxy::MAX_SEGMENTS = 16;
+
 // TextNodeProxy constructor
 // Algorithm follows Python version, mostly.
 // Called from COnscreenText constructor
@@ -33,8 +82,22 @@ COnscreenText::TextNodeProxy::TextNodeProxy(const string& name,
      m_scale(0, 0),
      m_pos(0, 0),
      m_roll(0),
-     m_wordwrap(0)
-   {
+     m_wordwrap(0),
+     m_outline(0, 0, 0, 0),
+     m_outlineWidth(0),
+     m_layoutRoot(new PandaNode("layout")),
+     m_alignNode(new PandaNode("align")),
+     m_layoutWidth(0),
+     m_layoutDirty(true),
+     m_styleDirty(true),
+     m_appendable(false),
+     m_fontChosen(false),
+     m_batchPtr(NULL),
+     m_batchLabel(-1),
+     m_owners(1)
+   {
+   m_layoutRoot->add_child(m_alignNode);
+
    // Choose the default parameters according to the selected style.
    Colorf fg(0, 0, 0, 0);
    Colorf bg(0, 0, 0, 0);
@@ -119,6 +182,9 @@ COnscreenText::TextNodeProxy::TextNodeProxy(const string& name,
       set_frame_as_margin(MARGIN, MARGIN, MARGIN, MARGIN);
       }
 
+   // Note: the distance field font is chosen with the first text
+   // (see choose_font()), texts may be constructed before main().
+
    update_transform_mat();
    }
 
@@ -130,33 +196,291 @@ COnscreenText::TextNodeProxy::TextNodeProxy(const TextNodeProxy& other)
      m_scale(other.m_scale),
      m_pos(other.m_pos),
      m_roll(other.m_roll),
-     m_wordwrap(other.m_wordwrap)
-   {
-   // empty
+     m_wordwrap(other.m_wordwrap),
+     m_outline(other.m_outline),
+     m_outlineWidth(other.m_outlineWidth),
+     m_layoutRoot(new PandaNode("layout")),
+     m_alignNode(new PandaNode("align")),
+     m_layoutWidth(0),
+     m_layoutDirty(true),
+     m_styleDirty(true),
+     m_appendable(false),
+     m_fontChosen(other.m_fontChosen),
+     m_batchPtr(NULL),
+     m_batchLabel(-1),
+     m_owners(1)
+   {
+   m_layoutRoot->add_child(m_alignNode);
+   m_layoutRoot->set_transform(other.m_layoutRoot->get_transform());
+
+   // Copies join the batch of the original.
+   if(other.m_batchPtr != NULL)
+      {
+      m_batchPtr = other.m_batchPtr;
+      m_batchLabel = m_batchPtr->add_label(this);
+      }
    }
 
 // TextNodeProxy destructor
 COnscreenText::TextNodeProxy::~TextNodeProxy()
    {
-   // Empty
+   if(m_batchPtr != NULL)
+      {
+      m_batchPtr->remove_label(m_batchLabel);
+      }
    }
 
 // Create a transform for the text for our scale and position.
 // We'd rather do it here, on the text itself, rather than on
 // our NodePath, so we have one fewer transforms in the scene
 // graph.
+// Note: the transform goes on the layout root rather than in
+// TextNode::set_transform(), which would lay the whole text
+// out again each time the text moves.
 void COnscreenText::TextNodeProxy::update_transform_mat()
    {
    LMatrix4f mat =
          LMatrix4f::scale_mat(m_scale.get_x(), 1, m_scale.get_y()) *
          LMatrix4f::rotate_mat(m_roll, LVecBase3f(0, -1, 0)) *
          LMatrix4f::translate_mat(m_pos.get_x(), 0, m_pos.get_y());
-   set_transform(mat);
+   m_layoutRoot->set_transform(TransformState::make_mat(mat));
+   mark_internal_bounds_stale();
+   if(m_batchPtr != NULL)
+      {
+      m_batchPtr->mark_dirty(m_batchLabel);
+      }
+   }
+
+// Flag the layout for regeneration. Nothing is laid out before
+// the text is culled, so several changes within a frame cost a
+// single layout.
+// styleChanged: true when the change affects the look of the
+//               text already laid out, false for text changes.
+void COnscreenText::TextNodeProxy::invalidate_layout(bool styleChanged)
+   {
+   m_layoutDirty = true;
+   m_styleDirty = m_styleDirty || styleChanged;
+   mark_internal_bounds_stale();
+   if(m_batchPtr != NULL)
+      {
+      m_batchPtr->mark_dirty(m_batchLabel);
+      }
+   }
+
+// Bring the layout up to date with the text. Text that only
+// grew since the last layout gets the new suffix laid out
+// after the existing segments; anything else is laid out again,
+// from the TextLayoutCache when the same text was seen recently.
+void COnscreenText::TextNodeProxy::update_layout()
+   {
+   LightReMutexHolder holder(m_layoutLock);
+   if(!m_layoutDirty)
+      {
+      return;
+      }
+   m_layoutDirty = false;
+
+   const std::wstring text = get_wtext();
+   float alignFactor = 0;
+   if(get_align() == A_center)
+      {
+      alignFactor = 0.5f;
+      }
+   else if(get_align() == A_right)
+      {
+      alignFactor = 1;
+      }
+
+   if(!m_styleDirty &&
+      m_appendable &&
+      m_alignNode->get_num_children() < MAX_SEGMENTS &&
+      text.size() > m_layoutText.size() &&
+      text.compare(0, m_layoutText.size(), m_layoutText) == 0 &&
+      text.find(L'\n', m_layoutText.size()) == std::wstring::npos &&
+      (alignFactor == 0 || !ends_with_space(text)))
+      {
+      const std::wstring suffix = text.substr(m_layoutText.size());
+      const float width = calc_width(suffix);
+      add_segment(suffix, m_layoutWidth, width, alignFactor);
+      m_layoutWidth += width;
+      m_layoutText = text;
+      m_alignNode->set_transform(TransformState::make_pos(LVecBase3f(-alignFactor * m_layoutWidth, 0, 0)));
+      return;
+      }
+
+   m_alignNode->remove_all_children();
+   m_layoutText = text;
+   m_styleDirty = false;
+
+   // Segments can only be appended to a single line of text
+   // without a card or a frame around it.
+   m_appendable = !has_wordwrap() &&
+                  !has_card() &&
+                  !has_frame() &&
+                  (get_align() == A_left || get_align() == A_center || get_align() == A_right) &&
+                  text.find(L'\n') == std::wstring::npos &&
+                  (alignFactor == 0 || !ends_with_space(text));
+   if(m_appendable)
+      {
+      m_layoutWidth = calc_width(text);
+      add_segment(text, 0, m_layoutWidth, alignFactor);
+      m_alignNode->set_transform(TransformState::make_pos(LVecBase3f(-alignFactor * m_layoutWidth, 0, 0)));
+      }
+   else
+      {
+      m_layoutWidth = 0;
+      m_alignNode->add_child(TextLayoutCache::get_global_ptr()->get_layout(this, text));
+      m_alignNode->set_transform(TransformState::make_identity());
+      }
+   }
+
+// TextNode leaves trailing whitespace out when it centers or
+// right-aligns a line, but calc_width() counts it: segments of
+// such text would be misplaced.
+bool COnscreenText::TextNodeProxy::ends_with_space(const std::wstring& text)
+   {
+   return !text.empty() && std::iswspace(text.back());
+   }
+
+// Add a segment of text starting at `x' from the left of the
+// whole line. The segment is laid out with the text alignment,
+// hence the shift to put its left side at `x'.
+void COnscreenText::TextNodeProxy::add_segment(const std::wstring& text,
+                                               float x,
+                                               float width,
+                                               float alignFactor)
+   {
+   PT(PandaNode) segment = new PandaNode("segment");
+   segment->set_transform(TransformState::make_pos(LVecBase3f(x + alignFactor * width, 0, 0)));
+   segment->add_child(TextLayoutCache::get_global_ptr()->get_layout(this, text));
+   m_alignNode->add_child(segment);
+   }
+
+// Draw distance field fonts with their shader, with our
+// outline; other fonts need none.
+void COnscreenText::TextNodeProxy::update_font_shader()
+   {
+   if(SdfText::is_sdf_font(get_font()))
+      {
+      set_attrib(m_outlineWidth > 0 ?
+            SdfText::make_shader_attrib(m_outline, m_outlineWidth) :
+            SdfText::make_shader_attrib());
+      }
+   else
+      {
+      clear_attrib(ShaderAttrib::get_class_slot());
+      }
+   }
+
+// Every text shares the distance field font, if one is set up
+// and no other font was set. Done with the first text rather
+// than in the constructor: global texts may be constructed
+// before the config variable naming the font.
+void COnscreenText::TextNodeProxy::choose_font()
+   {
+   if(m_fontChosen)
+      {
+      return;
+      }
+   m_fontChosen = true;
+
+   TextFont* sdfFontPtr = SdfText::get_default_font();
+   if(sdfFontPtr != NULL)
+      {
+      set_font(sdfFontPtr);
+      update_font_shader();
+      invalidate_layout(true);
+      }
+   }
+
+// Reimplementation of TextNode::cull_callback drawing our own
+// layout instead of the TextNode internal geometry.
+bool COnscreenText::TextNodeProxy::cull_callback(CullTraverser* trav,
+                                                 CullTraverserData& data)
+   {
+   if(is_batched())
+      {
+      return true;
+      }
+
+   update_layout();
+   CullTraverserData next_data(data, m_layoutRoot);
+   trav->traverse(next_data);
+
+   // Now continue to render everything else below this node.
+   return true;
+   }
+
+// Reimplementation of TextNode::compute_internal_bounds.
+// Bounds are needed during cull before cull_callback is called,
+// so the layout is brought up to date here too, casting the
+// constness away and holding the layout lock like TextNode does.
+void COnscreenText::TextNodeProxy::compute_internal_bounds(CPT(BoundingVolume)& internalBounds,
+                                                           int& internalVertices,
+                                                           int pipelineStage,
+                                                           Thread* currentThread) const
+   {
+   if(is_batched())
+      {
+      internalBounds = new BoundingSphere;
+      internalVertices = 0;
+      return;
+      }
+
+   LightReMutexHolder holder(m_layoutLock);
+   ((TextNodeProxy*)this)->update_layout();
+
+   PT(BoundingVolume) bounds = m_layoutRoot->get_bounds(currentThread)->make_copy();
+   DCAST(GeometricBoundingVolume, bounds.p())->xform(m_layoutRoot->get_transform(currentThread)->get_mat());
+   internalBounds = bounds;
+   internalVertices = m_layoutRoot->get_nested_vertices(currentThread);
+   }
+
+// Whether the text is drawn by a TextBatch rather than by us.
+bool COnscreenText::TextNodeProxy::is_batched() const
+   {
+   return m_batchPtr != NULL && TextBatch::can_batch(this);
+   }
+
+// Implementation of TextBatch::Label::get_properties.
+const TextNode* COnscreenText::TextNodeProxy::get_properties() const
+   {
+   return this;
+   }
+
+// Implementation of TextBatch::Label::get_placement.
+LMatrix4f COnscreenText::TextNodeProxy::get_placement() const
+   {
+   return m_layoutRoot->get_transform()->get_mat();
+   }
+
+// Implementation of TextBatch::Label::is_visible.
+// The text is drawn while it is in the scene graph of the batch
+// and neither it nor an ancestor is hidden, whichever NodePath
+// hid or moved it. Shared copies follow the first parent.
+bool COnscreenText::TextNodeProxy::is_visible() const
+   {
+   if(m_batchPtr == NULL)
+      {
+      return false;
+      }
+   NodePath path = NodePath::any_path(const_cast<TextNodeProxy*>(this));
+   return !path.is_hidden() &&
+          path.get_top() == m_batchPtr->get_root().get_top();
+   }
+
+// Implementation of TextBatch::Label::on_batch_destroyed.
+// The text is drawn by us again.
+void COnscreenText::TextNodeProxy::on_batch_destroyed()
+   {
+   m_batchPtr = NULL;
+   m_batchLabel = -1;
+   mark_internal_bounds_stale();
    }
 
 // COnscreenText constructor
 // Creates a NodePath that allocates a new TextNode which is initialized with `style'.
-// You should use NodePath::reparent_to() to insert the onscreen text into the aspect 2d
+// You should use reparent_to() to insert the onscreen text into the aspect 2d
 // of the scene graph.
 // style: one of the pre-canned style parameters defined at the
 //        head of this file.  This sets up the default values for
@@ -170,46 +494,109 @@ COnscreenText::COnscreenText(const string& name,
    }
 
 // COnscreenText copy constructor.
+// The copy shares the TextNodeProxy of `other' until one of
+// them is modified (see copy_on_write()). Meanwhile the copy is
+// a light node instancing the proxy, parented like `other'.
 COnscreenText::COnscreenText(const COnscreenText& other)
-   : m_textNode(new TextNodeProxy(*other.m_textNode))
+   : m_textNode(other.m_textNode)
+   {
+   ++m_textNode->m_owners;
+   PT(PandaNode) instance = new PandaNode(m_textNode->get_name());
+   instance->add_child(m_textNode);
+   duplicate_parenting(other, instance);
+   }
+
+// COnscreenText move constructor.
+// Takes over the node of `other', which is left empty.
+COnscreenText::COnscreenText(COnscreenText&& other) noexcept
+   : NodePath(std::move(other)),
+     m_textNode(std::move(other.m_textNode))
    {
-   duplicate_parenting(other);
+   // Note: NodePath may lack a move constructor and copy instead.
+   other.NodePath::clear();
+   other.m_textNode = NULL;
    }
 
+// std::vector grows by moving only what can't throw.
+static_assert(std::is_nothrow_move_constructible<COnscreenText>::value,
+              "COnscreenText copies when a vector of them grows");
+
 // COnscreenText assignment operator.
 COnscreenText& COnscreenText::operator=(const COnscreenText& other)
    {
-   COnscreenText(other).swap(*this);
-   duplicate_parenting(other);
+   if(this != &other)
+      {
+      *this = COnscreenText(other);
+      }
    return *this;
    }
 
-// Duplicate parenting of the `other' node
-void COnscreenText::duplicate_parenting(const COnscreenText& other)
+// COnscreenText move assignment operator.
+COnscreenText& COnscreenText::operator=(COnscreenText&& other) noexcept
+   {
+   if(this != &other)
+      {
+      cleanup();
+      NodePath::operator=(std::move(other));
+      m_textNode = std::move(other.m_textNode);
+      other.NodePath::clear();
+      other.m_textNode = NULL;
+      }
+   return *this;
+   }
+
+// Parent `node' like the `other' node
+void COnscreenText::duplicate_parenting(const COnscreenText& other, PandaNode* node)
    {
    if(other.get_parent().is_empty())
       {
-      NodePath::operator=(NodePath(m_textNode));
+      NodePath::operator=(NodePath(node));
       }
    else
       {
       NodePath::operator=(
-            other.get_parent().attach_new_node(m_textNode, other.get_sort()));
+            other.get_parent().attach_new_node(node, other.get_sort()));
       }
    }
 
-// Swap `this' data with the `other'
-void COnscreenText::swap(COnscreenText& other)
+// Give `this' its own TextNodeProxy before modifying it, if it
+// is still shared with copies.
+void COnscreenText::copy_on_write()
    {
-   PT(TextNodeProxy) p = m_textNode;
-   m_textNode = other.m_textNode;
-   other.m_textNode = p;
+   if(m_textNode->m_owners == 1)
+      {
+      return;
+      }
+
+   --m_textNode->m_owners;
+   PT(TextNodeProxy) textNode = new TextNodeProxy(*m_textNode);
+   if(node() == m_textNode)
+      {
+      // We are the original: the copies keep instancing the old
+      // proxy, we take the new one in its place.
+      NodePath parent = get_parent();
+      int sort = get_sort();
+      NodePath::detach_node();
+      NodePath::operator=(parent.is_empty() ?
+            NodePath(textNode) :
+            parent.attach_new_node(textNode, sort));
+      }
+   else
+      {
+      node()->remove_child(m_textNode);
+      node()->add_child(textNode);
+      }
+   m_textNode = textNode;
    }
 
 // Free memory and the scene graph.
 void COnscreenText::cleanup()
    {
-   m_textNode = NULL;
+   if(m_textNode != NULL)
+      {
+      --m_textNode->m_owners;
+      m_textNode = NULL;
+      }
    remove_node();
    }
 
@@ -219,13 +606,38 @@ COnscreenText::~COnscreenText()
    cleanup();
    }
 
+// Have `batchPtr' draw the text, along with the other labels
+// of the batch, or draw it ourselves again when NULL. Word
+// wrapped, carded or framed text is always drawn by us.
+// Note: batched text is placed in the space of the batch root,
+// wherever this NodePath is.
+void COnscreenText::set_batch(TextBatch* batchPtr)
+   {
+   copy_on_write();
+   if(m_textNode->m_batchPtr != NULL)
+      {
+      m_textNode->m_batchPtr->remove_label(m_textNode->m_batchLabel);
+      }
+   m_textNode->m_batchPtr = batchPtr;
+   m_textNode->m_batchLabel = batchPtr != NULL ? batchPtr->add_label(m_textNode) : -1;
+   m_textNode->invalidate_layout(false);
+   }
+
+// Returns the batch drawing the text, if any.
+TextBatch* COnscreenText::get_batch() const
+   {
+   return m_textNode->m_batchPtr;
+   }
+
 // Reimplementation of TextNode::set_card_decal.
 // decal: if this is true, the text is decalled onto its
 //        background card.  Useful when the text will be parented
 //        into the 3-D scene graph.
 void COnscreenText::set_decal(bool decal)
    {
+   copy_on_write();
    m_textNode->set_card_decal(decal);
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::get_card_decal.
@@ -238,7 +650,11 @@ bool COnscreenText::get_decal() const
 // fontPtr: the font to use for the text.
 void COnscreenText::set_font(TextFont* fontPtr)
    {
+   copy_on_write();
+   m_textNode->m_fontChosen = true;
    m_textNode->set_font(fontPtr);
+   m_textNode->update_font_shader();
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::get_font.
@@ -250,20 +666,28 @@ TextFont* COnscreenText::get_font() const
 // Reimplementation of TextNode::clear_text.
 void COnscreenText::clear_text()
    {
+   copy_on_write();
    m_textNode->clear_text();
+   m_textNode->invalidate_layout(false);
    }
 
 // Reimplementation of TextNode::set_text.
 // text: the actual text to display.
 void COnscreenText::set_text(const string& text)
    {
+   copy_on_write();
+   m_textNode->choose_font();
    m_textNode->set_text(text);
+   m_textNode->invalidate_layout(false);
    }
 
 // Reimplementation of TextNode::append_text.
 void COnscreenText::append_text(const string& text)
    {
+   copy_on_write();
+   m_textNode->choose_font();
    m_textNode->append_text(text);
+   m_textNode->invalidate_layout(false);
    }
 
 // Reimplementation of TextNode::get_text.
@@ -294,6 +718,7 @@ void COnscreenText::set_pos(float x, float y)
 // pos: the x, y position of the text on the screen.
 void COnscreenText::set_pos(const LVecBase2f& pos)
    {
+   copy_on_write();
    m_textNode->m_pos = pos;
    m_textNode->update_transform_mat();
    }
@@ -308,6 +733,7 @@ const LVecBase2f& COnscreenText::get_pos() const
 // Rotate the onscreen text around the screen's normal
 void COnscreenText::set_roll(float roll)
    {
+   copy_on_write();
    m_textNode->m_roll = roll;
    m_textNode->update_transform_mat();
    }
@@ -334,6 +760,7 @@ void COnscreenText::set_scale(float scaleX, float scaleY)
 
 void COnscreenText::set_scale(const LVecBase2f& scale)
    {
+   copy_on_write();
    m_textNode->m_scale = scale;
    m_textNode->update_transform_mat();
    }
@@ -350,6 +777,7 @@ const LVecBase2f& COnscreenText::get_scale() const
 //           to specify no automatic word wrapping.
 void COnscreenText::set_wordwrap(float wordwrap)
    {
+   copy_on_write();
    m_textNode->m_wordwrap = wordwrap;
    if(wordwrap != 0)
       {
@@ -359,6 +787,7 @@ void COnscreenText::set_wordwrap(float wordwrap)
       {
       m_textNode->clear_wordwrap();
       }
+   m_textNode->invalidate_layout(true);
    }
 
 // Returns the text wordwrapping distance.
@@ -371,7 +800,9 @@ float COnscreenText::get_wordwrap() const
 // fg: the (r, g, b, a) foreground color of the text.
 void COnscreenText::set_fg(const Colorf& fg)
    {
+   copy_on_write();
    m_textNode->set_text_color(fg);
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::set_card_color
@@ -380,6 +811,7 @@ void COnscreenText::set_fg(const Colorf& fg)
 //     behind the text and set to the given color.
 void COnscreenText::set_bg(const Colorf& bg)
    {
+   copy_on_write();
    if(bg[3] != 0)
       {
       // If we have a background color, create a card.
@@ -391,6 +823,7 @@ void COnscreenText::set_bg(const Colorf& bg)
       // Otherwise, remove the card.
       m_textNode->clear_card();
       }
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of both TextNode::set_shadow_color and TextNode::set_shadow.
@@ -399,6 +832,7 @@ void COnscreenText::set_bg(const Colorf& bg)
 //         is created and placed behind the text.
 void COnscreenText::set_shadow(const Colorf& shadow)
    {
+   copy_on_write();
    if(shadow[3] != 0)
       {
       // If we have a shadow color, create a shadow.
@@ -410,12 +844,15 @@ void COnscreenText::set_shadow(const Colorf& shadow)
       // Otherwise, remove the shadow.
       m_textNode->clear_shadow();
       }
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::set_shadow.
 void COnscreenText::set_shadow_offset(const LVecBase2f& offset)
    {
+   copy_on_write();
    m_textNode->set_shadow(offset);
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::set_frame_color
@@ -424,6 +861,7 @@ void COnscreenText::set_shadow_offset(const LVecBase2f& offset)
 //        created around the text.
 void COnscreenText::set_frame(const Colorf& frame)
    {
+   copy_on_write();
    if(frame[3] != 0)
       {
       // If we have a frame color, create a frame.
@@ -435,13 +873,31 @@ void COnscreenText::set_frame(const Colorf& frame)
       // Otherwise, remove the frame.
       m_textNode->clear_frame();
       }
+   m_textNode->invalidate_layout(true);
+   }
+
+// Outline the glyphs of a distance field font (see sdf_text.hpp);
+// other fonts are drawn without.
+// outline: the (r, g, b, a) color of the outline.  If the fourth
+//          value, a, is zero, the outline is removed.
+// width: the thickness of the outline, from 0 to 0.5 of the
+//        distance field range.
+void COnscreenText::set_outline(const Colorf& outline, float width)
+   {
+   copy_on_write();
+   m_textNode->m_outline = outline;
+   m_textNode->m_outlineWidth = outline[3] != 0 ? width : 0;
+   m_textNode->update_font_shader();
+   m_textNode->invalidate_layout(false);
    }
 
 // Reimplementation of TextNode::set_align
 // align: one of TextNode::A_Left, TextNode::A_right, or TextNode::A_center.
 void COnscreenText::set_align(TextNode::Alignment align)
    {
-   return m_textNode->set_align(align);
+   copy_on_write();
+   m_textNode->set_align(align);
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::set_draw_order
@@ -451,8 +907,10 @@ void COnscreenText::set_align(TextNode::Alignment align)
 //            2.
 void COnscreenText::set_draw_order(int drawOrder)
    {
+   copy_on_write();
    m_textNode->set_bin("fixed");
    m_textNode->set_draw_order(drawOrder);
+   m_textNode->invalidate_layout(true);
    }
 
 // Reimplementation of TextNode::generate returning an independent
@@ -461,12 +919,16 @@ void COnscreenText::set_draw_order(int drawOrder)
 // in a lighter node.
 NodePath COnscreenText::generate() const
    {
+   // The text transform is not part of the TextNode, see
+   // update_transform_mat().
+   PT(PandaNode) text = m_textNode->generate();
+   text->set_transform(m_textNode->m_layoutRoot->get_transform());
    if(get_parent().is_empty())
       {
-      return NodePath(m_textNode->generate());
+      return NodePath(text);
       }
    else
       {
-      return get_parent().attach_new_node(m_textNode->generate(), get_sort());
+      return get_parent().attach_new_node(text, get_sort());
       }
    }
@@ -16,6 +16,8 @@
 
 #define Colorf LColorf
 
+class TextBatch;
+
 using std::string;
 using std::endl;
 
@@ -38,12 +40,17 @@ class COnscreenText : public NodePath
 
    COnscreenText(const string& name, TextStyle style = TS_plain);
    COnscreenText(const COnscreenText& other);
+   COnscreenText(COnscreenText&& other) noexcept;
    ~COnscreenText();
 
    COnscreenText& operator=(const COnscreenText& other);
+   COnscreenText& operator=(COnscreenText&& other) noexcept;
 
    void cleanup();
 
+   void set_batch(TextBatch* batchPtr);
+   TextBatch* get_batch() const;
+
    void set_decal(bool decal);
    bool get_decal() const;
 
@@ -77,6 +84,7 @@ class COnscreenText : public NodePath
    void set_shadow(const Colorf& shadow);
    void set_shadow_offset(const LVecBase2f& offset);
    void set_frame(const Colorf& frame);
+   void set_outline(const Colorf& outline, float width = 0.15);
 
    void set_align(TextNode::Alignment align);
    void set_draw_order(int drawOrder);
@@ -85,8 +93,8 @@ class COnscreenText : public NodePath
 
    private:
 
-   void swap(COnscreenText& other);
-   void duplicate_parenting(const COnscreenText& other);
+   void duplicate_parenting(const COnscreenText& other, PandaNode* node);
+   void copy_on_write();
 
    static const float MARGIN;
    static const float SHADOW;
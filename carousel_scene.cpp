@@ -0,0 +1,400 @@
+/*
+ * carousel_scene.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <asyncTaskManager.h>
+#include <clockObject.h>
+#include <loader.h>
+#include <pandaFramework.h>
+#include <sceneGraphAnalyzer.h>
+
+#include "imgui.h"
+#include "texturePool.h"
+#include "ambientLight.h"
+#include "directionalLight.h"
+#include "carousel_scene.hpp"
+#include "event_bus.hpp"
+#include "game_events.hpp"
+#include "hot_reload.hpp"
+#include "mesh_optimizer.hpp"
+#include "profiler.hpp"
+
+static const double PI = 3.14159265;
+static const int MAX_CAROUSELS = 400;
+static const double READOUT_PERIOD = 0.5;
+
+const float CarouselScene::GRID_SPACING = 5;
+
+namespace
+{
+    Profiler::Section load_models_section("App:Carousel:Load models");
+    Profiler::Section update_section("App:Carousel:Update");
+}
+
+// Load a model synchronously and return it as an unparented NodePath.
+// Safe to call from the scene loader thread.
+static NodePath load_model(const Filename& filename)
+{
+    PT(PandaNode) nodePtr = Loader::get_global_ptr()->load_sync(MeshOptimizer::get_optimized_filename(filename));
+    if (nodePtr == NULL)
+    {
+        nout << "ERROR: unable to load " << filename << "." << endl;
+        return NodePath();
+    }
+    NodePath np(nodePtr);
+    MeshOptimizer::setup_decoding(np);
+    HotReload::get_global_ptr()->track_model(np, filename);
+    return np;
+}
+
+CarouselScene::CarouselScene(int count)
+    : m_count(std::max(1, std::min(count, MAX_CAROUSELS))),
+    m_env(0),
+    m_time(0),
+    m_showPanel(count > 1)
+{
+}
+
+CarouselScene::~CarouselScene()
+{
+    // The task and the panel hold a pointer to this scene, make sure they
+    // stop firing.
+    if (m_updateTaskPtr != NULL)
+    {
+        m_updateTaskPtr->remove();
+    }
+    EventBus::unsubscribe<NewFrameEvent>(on_new_frame, this);
+}
+
+void CarouselScene::load(WindowFramework* windowFrameworkPtr, NodePath root)
+{
+    m_rootNp = root;
+
+    // Load and position our models
+    load_models();
+    // Add some basic lighting
+    setup_lights();
+    // Put everything in its starting place; the carousels move once the
+    // scene is entered
+    m_entities.update(m_time);
+}
+
+void CarouselScene::enter(WindowFramework* windowFrameworkPtr)
+{
+    // Set the background color
+    windowFrameworkPtr->get_display_region_3d()->set_clear_color(Colorf(0.6, 0.6, 1, 1));
+    // Allow manual positioning of the camera
+    // Note: in that state by default in C++
+    m_cameraNp = windowFrameworkPtr->get_camera_group();
+    // Set the cameras' position and orientation, far enough for the grid
+    layout();
+
+    // Put the carousels into motion, from where we left off if we come back
+    m_updateTaskPtr = new GenericAsyncTask("carouselUpdateTask", update_carousel, this);
+    AsyncTaskManager::get_global_ptr()->add(m_updateTaskPtr);
+
+    windowFrameworkPtr->get_panda_framework()->define_key("o", "removeNode", removeNode, this);
+    windowFrameworkPtr->get_panda_framework()->define_key("f4", "toggleCarouselPanel", toggle_panel, this);
+    EventBus::subscribe<NewFrameEvent>(on_new_frame, this);
+}
+
+void CarouselScene::exit(WindowFramework* windowFrameworkPtr)
+{
+    EventBus::unsubscribe<NewFrameEvent>(on_new_frame, this);
+    EventHandler::get_global_event_handler()->remove_hook("o", removeNode, this);
+    EventHandler::get_global_event_handler()->remove_hook("f4", toggle_panel, this);
+    m_cameraNp = NodePath();
+
+    // Keep everything loaded, just stop the carousels until we come back.
+    if (m_updateTaskPtr != NULL)
+    {
+        m_updateTaskPtr->remove();
+        m_updateTaskPtr = NULL;
+    }
+}
+
+void CarouselScene::set_count(int count)
+{
+    count = std::max(1, std::min(count, MAX_CAROUSELS));
+    while (static_cast<int>(m_carousels.size()) < count)
+    {
+        add_carousel();
+    }
+    while (static_cast<int>(m_carousels.size()) > count)
+    {
+        remove_carousel();
+    }
+    m_count = count;
+    layout();
+}
+
+int CarouselScene::get_count() const
+{
+    return static_cast<int>(m_carousels.size());
+}
+
+void CarouselScene::removeNode(const Event* eventPtr, void* dataPtr)
+{
+    CarouselScene* scenePtr = static_cast<CarouselScene*>(dataPtr);
+    // The first carousel goes, pandas and lights included; the others keep
+    // their place in the grid.
+    if (scenePtr->m_carousels.empty())
+    {
+        return;
+    }
+    for (auto it = scenePtr->m_carousels.front().rbegin(); it != scenePtr->m_carousels.front().rend(); ++it)
+    {
+        scenePtr->m_entities.destroy(*it);
+    }
+    scenePtr->m_carousels.erase(scenePtr->m_carousels.begin());
+    scenePtr->m_count = static_cast<int>(scenePtr->m_carousels.size());
+}
+
+void CarouselScene::toggle_panel(const Event* eventPtr, void* dataPtr)
+{
+    CarouselScene* scenePtr = static_cast<CarouselScene*>(dataPtr);
+    scenePtr->m_showPanel = !scenePtr->m_showPanel;
+}
+
+// Creates an entity for `np', parented to `parent', with its transform as
+// its current one.
+Entity CarouselScene::add_model(const NodePath& np, const NodePath& parent)
+{
+    Entity entity = m_entities.create();
+    EntityStore::Model model;
+    model.np = np;
+    if (!model.np.is_empty())
+    {
+        model.np.reparent_to(parent);
+    }
+    m_entities.get_models().add(entity, model);
+    EntityStore::Transform transform;
+    transform.pos = np.get_pos();
+    transform.hpr = np.get_hpr();
+    transform.scale = np.get_scale();
+    m_entities.get_transforms().add(entity, transform);
+    return entity;
+}
+
+void CarouselScene::load_models()
+{
+    Profiler::Timer timer(load_models_section);
+
+    // Load the textures for the lights. One texture is for the "on" state,
+    // the other is for the "off" state.
+    m_lightOffTexPtr = TexturePool::load_texture("./models/carousel_lights_off.jpg");
+    m_lightOnTexPtr = TexturePool::load_texture("./models/carousel_lights_on.jpg");
+
+    for (int k = 0; k < m_count; ++k)
+    {
+        add_carousel();
+    }
+
+    // Load the environment (Sky sphere and ground plane)
+    m_envNp = load_model("./models/env");
+    m_env = add_model(m_envNp, m_rootNp);
+
+    layout();
+}
+
+void CarouselScene::add_carousel()
+{
+    std::vector<Entity> entities;
+
+    // Load the carousel base, attached to the scene root. It turns a full
+    // circle every 20 seconds.
+    NodePath carouselNp = load_model("./models/carousel_base");
+    Entity carousel = add_model(carouselNp, m_rootNp);
+    EntityStore::Spinner spinner;
+    spinner.baseHpr = LVecBase3f::zero();
+    spinner.rate = LVecBase3f(360.0 / 20, 0, 0);
+    m_entities.get_spinners().add(carousel, spinner);
+    entities.push_back(carousel);
+
+    // Load the modeled lights that are on the outer rim of the carousel
+    // (not Panda lights)
+    // There are 2 groups of lights. At any given time, one group will have the
+    // "on" texture and the other will have the "off" texture: they blink
+    // every 0.1 second, the 2nd half a period behind the 1st.
+    for (int i = 0; i < 2; ++i)
+    {
+        Entity lights = add_model(load_model("./models/carousel_lights"), carouselNp);
+        // We need to rotate the 2nd so it doesn't overlap with the 1st set.
+        m_entities.get_transforms().get(lights)->hpr = LVecBase3f(i * 36, 0, 0);
+        EntityStore::Blinker blinker;
+        blinker.textures[0] = m_lightOnTexPtr;
+        blinker.textures[1] = m_lightOffTexPtr;
+        blinker.period = 0.2;
+        blinker.phase = i * 0.1;
+        m_entities.get_blinkers().add(lights, blinker);
+        entities.push_back(lights);
+    }
+
+    for (int i = 0; i < NUM_PANDAS; ++i)
+    {
+        // A dummy node attached to the carousel for each panda. The Z value of
+        // its position is the base height of the pandas, and the headings put
+        // each panda in its own position around the carousel.
+        string nodeName("panda");
+        nodeName += i;
+        Entity panda = add_model(NodePath(nodeName), carouselNp);
+        m_entities.get_transforms().get(panda)->pos = LPoint3f(0, 0, 1.3);
+        m_entities.get_transforms().get(panda)->hpr = LVecBase3f(i * 90, 0, 0);
+        entities.push_back(panda);
+
+        // Load the actual panda model, and parent it to its dummy node. It
+        // moves up and down like the horses of a carousel, close to a sine
+        // wave, at the distance from the center the carousel was modeled
+        // for in Maya.
+        NodePath pandaNp = m_entities.get_models().get(panda)->np;
+        Entity model = add_model(load_model("./models/carousel_panda"), pandaNp);
+        EntityStore::Oscillator oscillator;
+        oscillator.basePos = LPoint3f(0, .85, 0);
+        oscillator.amplitude = LVecBase3f(0, 0, 0.2);
+        oscillator.period = 3;
+        oscillator.phase = PI * (i % 2);
+        m_entities.get_oscillators().add(model, oscillator);
+        entities.push_back(model);
+    }
+
+    m_carousels.push_back(entities);
+}
+
+void CarouselScene::remove_carousel()
+{
+    // Children first, the base last, with its node.
+    for (auto it = m_carousels.back().rbegin(); it != m_carousels.back().rend(); ++it)
+    {
+        m_entities.destroy(*it);
+    }
+    m_carousels.pop_back();
+}
+
+int CarouselScene::get_grid_side() const
+{
+    return static_cast<int>(std::ceil(std::sqrt(static_cast<float>(std::max(1, m_count)))));
+}
+
+// Puts the carousels in a square grid centered on the origin, grows the
+// environment around it and, while the scene is active, backs the camera
+// off to see all of it.
+void CarouselScene::layout()
+{
+    const int side = get_grid_side();
+    const float center = (side - 1) * GRID_SPACING / 2;
+    for (int k = 0; k < static_cast<int>(m_carousels.size()); ++k)
+    {
+        EntityStore::Transform* transformPtr = m_entities.get_transforms().get(m_carousels[k].front());
+        transformPtr->pos = LPoint3f((k % side) * GRID_SPACING - center, (k / side) * GRID_SPACING - center, 0);
+        transformPtr->dirty = true;
+    }
+
+    EntityStore::Transform* envTransformPtr = m_entities.get_transforms().get(m_env);
+    if (envTransformPtr != NULL)
+    {
+        envTransformPtr->scale = LVecBase3f(7.0f * side);
+        envTransformPtr->dirty = true;
+    }
+
+    if (!m_cameraNp.is_empty())
+    {
+        m_cameraNp.set_pos_hpr(0, -8 * side, 2.5 * side, 0, -9, 0);
+    }
+}
+
+void CarouselScene::draw_panel()
+{
+    if (!m_showPanel)
+    {
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(320, 220), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Carousels", &m_showPanel))
+    {
+        int count = m_count;
+        if (ImGui::SliderInt("carousels", &count, 1, MAX_CAROUSELS))
+        {
+            set_count(count);
+        }
+
+        update_readout();
+        const EntityStore::Stats stats = m_entities.get_stats();
+        ImGui::Text("pandas %d, light rings %d", get_count() * NUM_PANDAS, get_count() * 2);
+        ImGui::Text("scene nodes %d", m_readout.nodes);
+        ImGui::Text("Geoms %d (draw calls before culling)", m_readout.geoms);
+        ImGui::Text("vertices %d", m_readout.vertices);
+        ImGui::Text("entities %d, animated %d", stats.numEntities,
+            m_entities.get_oscillators().size() + m_entities.get_spinners().size() + m_entities.get_blinkers().size());
+        ImGui::Text("transforms committed %d, states %d", stats.syncedTransforms, stats.transformStates);
+
+        ClockObject* clockPtr = ClockObject::get_global_clock();
+        const double averageFrameRate = clockPtr->get_average_frame_rate();
+        ImGui::Text("frame %.2f ms, average %.2f ms (%.1f fps)", 1000 * clockPtr->get_dt(),
+            averageFrameRate > 0 ? 1000 / averageFrameRate : 0.0, averageFrameRate);
+    }
+    ImGui::End();
+}
+
+// Walking the whole scene graph is itself a cost that grows with the
+// count, so it is done every READOUT_PERIOD only.
+void CarouselScene::update_readout()
+{
+    const double now = ClockObject::get_global_clock()->get_real_time();
+    if (m_readout.lastUpdate >= 0 && now - m_readout.lastUpdate < READOUT_PERIOD)
+    {
+        return;
+    }
+    m_readout.lastUpdate = now;
+
+    SceneGraphAnalyzer analyzer;
+    analyzer.add_node(m_rootNp.node());
+    m_readout.nodes = analyzer.get_num_nodes();
+    m_readout.geoms = analyzer.get_num_geoms();
+    m_readout.vertices = analyzer.get_num_vertices();
+}
+
+// Panda Lighting
+void CarouselScene::setup_lights()
+{
+    // Create some lights and add them to the scene. By setting the lights on
+    // the scene root they affect the entire scene, and they go away with it
+    // when another scene is active.
+    // Check out the lighting tutorial for more information on lights
+    PT(AmbientLight) ambientLightPtr = new AmbientLight("ambientLight");
+    if (ambientLightPtr != NULL)
+    {
+        ambientLightPtr->set_color(Colorf(0.4, 0.4, 0.35, 1));
+        m_rootNp.set_light(m_rootNp.attach_new_node(ambientLightPtr));
+    }
+    PT(DirectionalLight) directionalLightPtr = new DirectionalLight("directionalLight");
+    if (directionalLightPtr != NULL)
+    {
+        directionalLightPtr->set_direction(LVecBase3f(0, 8, -2.5));
+        directionalLightPtr->set_color(Colorf(0.9, 0.8, 0.9, 1));
+        m_rootNp.set_light(m_rootNp.attach_new_node(directionalLightPtr));
+    }
+
+    // Explicitly set the environment to not be lit
+    m_envNp.set_light_off();
+}
+
+AsyncTask::DoneStatus CarouselScene::update_carousel(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    Profiler::Timer timer(update_section);
+
+    CarouselScene* scenePtr = static_cast<CarouselScene*>(dataPtr);
+    scenePtr->m_time += ClockObject::get_global_clock()->get_dt();
+    scenePtr->m_entities.update(scenePtr->m_time);
+    return AsyncTask::DS_cont;
+}
+
+void CarouselScene::on_new_frame(const NewFrameEvent& event, void* dataPtr)
+{
+    static_cast<CarouselScene*>(dataPtr)->draw_panel();
+}
@@ -0,0 +1,88 @@
+/*
+ * carousel_scene.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * CarouselScene module: the carousel from the Panda3D tutorials, with its
+ * pandas, blinking lights and environment, packaged as a resident Scene.
+ * Its objects are entities of an EntityStore, updated by a task while the
+ * scene is active.
+ *
+ * For stress tests the scene holds any number of carousels, each with its
+ * own pandas and lights, in a square grid: "carousels [count]" on the
+ * command line, or the "Carousels" panel (F4), which also shows the size of
+ * the scene and the frame time as the count changes.
+ */
+
+#ifndef CAROUSEL_SCENE_HPP_
+#define CAROUSEL_SCENE_HPP_
+
+#include <vector>
+
+#include <genericAsyncTask.h>
+
+#include "entity_store.hpp"
+#include "scene_manager.hpp"
+
+struct NewFrameEvent;
+
+class CarouselScene : public Scene
+{
+public:
+    CarouselScene(int count = 1);
+    virtual ~CarouselScene();
+
+    virtual void load(WindowFramework* windowFrameworkPtr, NodePath root);
+    virtual void enter(WindowFramework* windowFrameworkPtr);
+    virtual void exit(WindowFramework* windowFrameworkPtr);
+
+    // Adds or removes carousels, then lays the grid out again. Main thread
+    // once the scene is loaded.
+    void set_count(int count);
+    int get_count() const;
+
+private:
+    static const int NUM_PANDAS = 4;
+    // Between the centers of neighbor carousels.
+    static const float GRID_SPACING;
+
+    // The scene as the panel shows it, refreshed twice a second.
+    struct Readout
+    {
+        int nodes = 0;
+        int geoms = 0;                      // draw calls before culling
+        int vertices = 0;
+        double lastUpdate = -1;
+    };
+
+    void load_models();
+    void setup_lights();
+    void add_carousel();
+    void remove_carousel();
+    void layout();
+    int get_grid_side() const;
+    Entity add_model(const NodePath& np, const NodePath& parent);
+    void draw_panel();
+    void update_readout();
+    static AsyncTask::DoneStatus update_carousel(GenericAsyncTask* taskPtr, void* dataPtr);
+    static void on_new_frame(const NewFrameEvent& event, void* dataPtr);
+
+    int m_count;
+    NodePath m_rootNp;
+    NodePath m_cameraNp;
+    EntityStore m_entities;
+    // The entities of each carousel, its base first.
+    std::vector<std::vector<Entity>> m_carousels;
+    Entity m_env;
+    NodePath m_envNp;
+    PT(Texture) m_lightOffTexPtr;
+    PT(Texture) m_lightOnTexPtr;
+    double m_time;                          // the carousels', paused on exit
+    PT(GenericAsyncTask) m_updateTaskPtr;
+    Readout m_readout;
+    bool m_showPanel;
+    static void removeNode(const Event* eventPtr, void* dataPtr);
+    static void toggle_panel(const Event* eventPtr, void* dataPtr);
+};
+
+#endif /* CAROUSEL_SCENE_HPP_ */
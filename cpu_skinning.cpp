@@ -0,0 +1,545 @@
+/*
+ * cpu_skinning.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SKINNING_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define SKINNING_SSE
+#endif
+
+#include <configVariableString.h>
+#include <geom.h>
+#include <geomVertexReader.h>
+#include <transformBlendTable.h>
+
+#include "cpu_skinning.hpp"
+#include "frame_arena.hpp"
+#include "job_system.hpp"
+
+namespace
+{
+    ConfigVariableString cpu_skinning
+    ("cpu-skinning", "auto",
+     PRC_DESC("Set to \"on\" to skin animated models with the vectorized "
+              "CPU kernel, \"off\" to leave it to Panda, or \"auto\" to use "
+              "the kernel only for software rendering and headless runs."));
+
+    // Writes `count' skinned vertices, given in SoA form, to a strided array.
+    inline void store_lanes(const float* x, const float* y, const float* z, int count,
+                            unsigned char* out, int stride)
+    {
+        for (int lane = 0; lane < count; ++lane)
+        {
+            float* v = reinterpret_cast<float*>(out + lane * stride);
+            v[0] = x[lane];
+            v[1] = y[lane];
+            v[2] = z[lane];
+        }
+    }
+}
+
+// ************************************************************************************************
+
+void SkinningMesh::resize(int numVertices)
+{
+    this->numVertices = numVertices;
+    const int padded = (numVertices + LANE_PADDING - 1) / LANE_PADDING * LANE_PADDING;
+    px.assign(padded, 0.0f);
+    py.assign(padded, 0.0f);
+    pz.assign(padded, 0.0f);
+    nx.assign(padded, 0.0f);
+    ny.assign(padded, 0.0f);
+    nz.assign(padded, 0.0f);
+    for (int k = 0; k < MAX_INFLUENCES; ++k)
+    {
+        joints[k].assign(padded, 0);
+        weights[k].assign(padded, 0.0f);
+    }
+}
+
+void SkinningKernel::skin_scalar(const SkinningMesh& mesh,
+                                 const SkinningMatrix* matrices,
+                                 int begin,
+                                 int end,
+                                 const SkinningOutput& output)
+{
+    for (int i = begin; i < end; ++i)
+    {
+        // Blend the joint matrices first, then transform once.
+        float b[12] = { 0 };
+        for (int k = 0; k < SkinningMesh::MAX_INFLUENCES; ++k)
+        {
+            const float w = mesh.weights[k][i];
+            if (w == 0.0f)
+            {
+                continue;
+            }
+            const float* m = matrices[mesh.joints[k][i]].m;
+            for (int e = 0; e < 12; ++e)
+            {
+                b[e] += w * m[e];
+            }
+        }
+
+        const float x = mesh.px[i], y = mesh.py[i], z = mesh.pz[i];
+        float* pos = reinterpret_cast<float*>(output.positions + i * output.positionStride);
+        pos[0] = x * b[0] + y * b[1] + z * b[2] + b[3];
+        pos[1] = x * b[4] + y * b[5] + z * b[6] + b[7];
+        pos[2] = x * b[8] + y * b[9] + z * b[10] + b[11];
+
+        if (output.normals != nullptr)
+        {
+            const float nx = mesh.nx[i], ny = mesh.ny[i], nz = mesh.nz[i];
+            float* normal = reinterpret_cast<float*>(output.normals + i * output.normalStride);
+            normal[0] = nx * b[0] + ny * b[1] + nz * b[2];
+            normal[1] = nx * b[4] + ny * b[5] + nz * b[6];
+            normal[2] = nx * b[8] + ny * b[9] + nz * b[10];
+        }
+    }
+}
+
+#if defined(SKINNING_AVX2)
+
+void SkinningKernel::skin(const SkinningMesh& mesh,
+                          const SkinningMatrix* matrices,
+                          int begin,
+                          int end,
+                          const SkinningOutput& output)
+{
+    const float* base = matrices[0].m;
+    alignas(32) float x[8], y[8], z[8];
+
+    for (int i = begin; i < end; i += 8)
+    {
+        __m256 b[12];
+        for (int e = 0; e < 12; ++e)
+        {
+            b[e] = _mm256_setzero_ps();
+        }
+
+        for (int k = 0; k < SkinningMesh::MAX_INFLUENCES; ++k)
+        {
+            const __m256 w = _mm256_loadu_ps(&mesh.weights[k][i]);
+            // Offsets of the 8 joint matrices, in floats.
+            const __m256i offsets = _mm256_mullo_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&mesh.joints[k][i])),
+                _mm256_set1_epi32(12));
+            for (int e = 0; e < 12; ++e)
+            {
+                const __m256 m = _mm256_i32gather_ps(base + e, offsets, 4);
+                b[e] = _mm256_add_ps(b[e], _mm256_mul_ps(w, m));
+            }
+        }
+
+        const int count = std::min(8, end - i);
+
+        const __m256 vx = _mm256_loadu_ps(&mesh.px[i]);
+        const __m256 vy = _mm256_loadu_ps(&mesh.py[i]);
+        const __m256 vz = _mm256_loadu_ps(&mesh.pz[i]);
+        for (int c = 0; c < 3; ++c)
+        {
+            __m256 r = _mm256_add_ps(_mm256_mul_ps(vx, b[4 * c]), _mm256_mul_ps(vy, b[4 * c + 1]));
+            r = _mm256_add_ps(r, _mm256_add_ps(_mm256_mul_ps(vz, b[4 * c + 2]), b[4 * c + 3]));
+            _mm256_store_ps(c == 0 ? x : c == 1 ? y : z, r);
+        }
+        store_lanes(x, y, z, count, output.positions + i * output.positionStride, output.positionStride);
+
+        if (output.normals != nullptr)
+        {
+            const __m256 nx = _mm256_loadu_ps(&mesh.nx[i]);
+            const __m256 ny = _mm256_loadu_ps(&mesh.ny[i]);
+            const __m256 nz = _mm256_loadu_ps(&mesh.nz[i]);
+            for (int c = 0; c < 3; ++c)
+            {
+                __m256 r = _mm256_add_ps(_mm256_mul_ps(nx, b[4 * c]), _mm256_mul_ps(ny, b[4 * c + 1]));
+                r = _mm256_add_ps(r, _mm256_mul_ps(nz, b[4 * c + 2]));
+                _mm256_store_ps(c == 0 ? x : c == 1 ? y : z, r);
+            }
+            store_lanes(x, y, z, count, output.normals + i * output.normalStride, output.normalStride);
+        }
+    }
+}
+
+const char* SkinningKernel::get_isa_name()
+{
+    return "AVX2";
+}
+
+#elif defined(SKINNING_SSE)
+
+void SkinningKernel::skin(const SkinningMesh& mesh,
+                          const SkinningMatrix* matrices,
+                          int begin,
+                          int end,
+                          const SkinningOutput& output)
+{
+    alignas(16) float x[4], y[4], z[4];
+
+    for (int i = begin; i < end; i += 4)
+    {
+        __m128 b[12];
+        for (int e = 0; e < 12; ++e)
+        {
+            b[e] = _mm_setzero_ps();
+        }
+
+        for (int k = 0; k < SkinningMesh::MAX_INFLUENCES; ++k)
+        {
+            const __m128 w = _mm_loadu_ps(&mesh.weights[k][i]);
+            const int32_t* joints = &mesh.joints[k][i];
+
+            // Each column of the 4 joint matrices is transposed so that one
+            // register holds the same matrix element for the 4 vertices.
+            for (int c = 0; c < 3; ++c)
+            {
+                __m128 m0 = _mm_loadu_ps(matrices[joints[0]].m + 4 * c);
+                __m128 m1 = _mm_loadu_ps(matrices[joints[1]].m + 4 * c);
+                __m128 m2 = _mm_loadu_ps(matrices[joints[2]].m + 4 * c);
+                __m128 m3 = _mm_loadu_ps(matrices[joints[3]].m + 4 * c);
+                _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+                b[4 * c] = _mm_add_ps(b[4 * c], _mm_mul_ps(w, m0));
+                b[4 * c + 1] = _mm_add_ps(b[4 * c + 1], _mm_mul_ps(w, m1));
+                b[4 * c + 2] = _mm_add_ps(b[4 * c + 2], _mm_mul_ps(w, m2));
+                b[4 * c + 3] = _mm_add_ps(b[4 * c + 3], _mm_mul_ps(w, m3));
+            }
+        }
+
+        const int count = std::min(4, end - i);
+
+        const __m128 vx = _mm_loadu_ps(&mesh.px[i]);
+        const __m128 vy = _mm_loadu_ps(&mesh.py[i]);
+        const __m128 vz = _mm_loadu_ps(&mesh.pz[i]);
+        for (int c = 0; c < 3; ++c)
+        {
+            __m128 r = _mm_add_ps(_mm_mul_ps(vx, b[4 * c]), _mm_mul_ps(vy, b[4 * c + 1]));
+            r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(vz, b[4 * c + 2]), b[4 * c + 3]));
+            _mm_store_ps(c == 0 ? x : c == 1 ? y : z, r);
+        }
+        store_lanes(x, y, z, count, output.positions + i * output.positionStride, output.positionStride);
+
+        if (output.normals != nullptr)
+        {
+            const __m128 nx = _mm_loadu_ps(&mesh.nx[i]);
+            const __m128 ny = _mm_loadu_ps(&mesh.ny[i]);
+            const __m128 nz = _mm_loadu_ps(&mesh.nz[i]);
+            for (int c = 0; c < 3; ++c)
+            {
+                __m128 r = _mm_add_ps(_mm_mul_ps(nx, b[4 * c]), _mm_mul_ps(ny, b[4 * c + 1]));
+                r = _mm_add_ps(r, _mm_mul_ps(nz, b[4 * c + 2]));
+                _mm_store_ps(c == 0 ? x : c == 1 ? y : z, r);
+            }
+            store_lanes(x, y, z, count, output.normals + i * output.normalStride, output.normalStride);
+        }
+    }
+}
+
+const char* SkinningKernel::get_isa_name()
+{
+    return "SSE";
+}
+
+#else
+
+void SkinningKernel::skin(const SkinningMesh& mesh,
+                          const SkinningMatrix* matrices,
+                          int begin,
+                          int end,
+                          const SkinningOutput& output)
+{
+    skin_scalar(mesh, matrices, begin, end, output);
+}
+
+const char* SkinningKernel::get_isa_name()
+{
+    return "scalar";
+}
+
+#endif
+
+// ************************************************************************************************
+
+CpuSkinner::CpuSkinner(GeomNode* geomNodePtr)
+    : m_numVertices(0),
+    m_numChunks(0)
+{
+    // Joint 0 is the identity, for vertices that have no influence at all.
+    SkinningMatrix identity = { { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0 } };
+    m_joints.push_back(NULL);
+    m_matrices.push_back(identity);
+
+    for (int g = 0, g_end = geomNodePtr->get_num_geoms(); g < g_end; ++g)
+    {
+        CPT(GeomVertexData) vdataPtr = geomNodePtr->get_geom(g)->get_vertex_data();
+        if (vdataPtr->get_transform_blend_table() == NULL)
+        {
+            continue;
+        }
+
+        // Geoms sharing the same vertex data share the same target.
+        int targetId = 0;
+        while (targetId < static_cast<int>(m_targets.size()) && m_targets[targetId].sourcePtr != vdataPtr)
+        {
+            ++targetId;
+        }
+        if (targetId == static_cast<int>(m_targets.size()))
+        {
+            m_targets.emplace_back();
+            m_targets.back().sourcePtr = vdataPtr;
+            if (!setup_target(m_targets.back()))
+            {
+                m_targets.pop_back();
+                continue;
+            }
+        }
+
+        geomNodePtr->modify_geom(g)->set_vertex_data(m_targets[targetId].skinnedPtr);
+    }
+
+    for (auto& target : m_targets)
+    {
+        target.firstChunk = m_numChunks;
+        m_numChunks += (target.mesh.numVertices + CpuSkinning::CHUNK_SIZE - 1) / CpuSkinning::CHUNK_SIZE;
+        m_numVertices += target.mesh.numVertices;
+    }
+}
+
+bool CpuSkinner::setup_target(Target& target)
+{
+    const GeomVertexData* sourcePtr = target.sourcePtr;
+    const GeomVertexFormat* formatPtr = sourcePtr->get_format();
+
+    // The kernel only writes 3 float32 positions and normals; anything
+    // else stays with Panda's stock path.
+    const GeomVertexColumn* vertexColumnPtr = formatPtr->get_column(InternalName::get_vertex());
+    if (vertexColumnPtr == NULL || vertexColumnPtr->get_numeric_type() != GeomEnums::NT_float32 ||
+        vertexColumnPtr->get_num_components() < 3)
+    {
+        return false;
+    }
+    const GeomVertexColumn* normalColumnPtr = formatPtr->get_column(InternalName::get_normal());
+    if (normalColumnPtr != NULL && (normalColumnPtr->get_numeric_type() != GeomEnums::NT_float32 ||
+        normalColumnPtr->get_num_components() < 3))
+    {
+        normalColumnPtr = NULL;
+    }
+
+    // Static copy of the vertex data: same columns, no animation.
+    PT(GeomVertexFormat) staticFormatPtr = new GeomVertexFormat(*formatPtr);
+    staticFormatPtr->set_animation(GeomVertexAnimationSpec());
+    CPT(GeomVertexData) convertedPtr = sourcePtr->convert_to(GeomVertexFormat::register_format(staticFormatPtr));
+    target.skinnedPtr = new GeomVertexData(*convertedPtr);
+    target.skinnedPtr->clear_transform_blend_table();
+
+    const GeomVertexFormat* skinnedFormatPtr = target.skinnedPtr->get_format();
+    target.positionArray = skinnedFormatPtr->get_array_with(InternalName::get_vertex());
+    target.positionOffset = skinnedFormatPtr->get_column(InternalName::get_vertex())->get_start();
+    target.normalArray = -1;
+    target.normalOffset = 0;
+    if (normalColumnPtr != NULL)
+    {
+        target.normalArray = skinnedFormatPtr->get_array_with(InternalName::get_normal());
+        target.normalOffset = skinnedFormatPtr->get_column(InternalName::get_normal())->get_start();
+    }
+
+    // Rest pose and influences, in SoA form.
+    const TransformBlendTable* blendTablePtr = sourcePtr->get_transform_blend_table();
+    const int numVertices = sourcePtr->get_num_rows();
+    SkinningMesh& mesh = target.mesh;
+    mesh.resize(numVertices);
+
+    GeomVertexReader vertexReader(sourcePtr, InternalName::get_vertex());
+    GeomVertexReader normalReader(sourcePtr, InternalName::get_normal());
+    GeomVertexReader blendReader(sourcePtr, InternalName::get_transform_blend());
+    for (int i = 0; i < numVertices; ++i)
+    {
+        const LVecBase3f& v = vertexReader.get_data3f();
+        mesh.px[i] = v[0];
+        mesh.py[i] = v[1];
+        mesh.pz[i] = v[2];
+        if (normalColumnPtr != NULL)
+        {
+            const LVecBase3f& n = normalReader.get_data3f();
+            mesh.nx[i] = n[0];
+            mesh.ny[i] = n[1];
+            mesh.nz[i] = n[2];
+        }
+
+        const TransformBlend& blend = blendTablePtr->get_blend(blendReader.get_data1i());
+        const int numTransforms = blend.get_num_transforms();
+        if (numTransforms == 0)
+        {
+            mesh.weights[0][i] = 1.0f;
+            continue;
+        }
+
+        // Keep the heaviest influences; they are renormalized below.
+        int order[16];
+        const int kept = std::min(numTransforms, 16);
+        for (int t = 0; t < kept; ++t)
+        {
+            order[t] = t;
+        }
+        std::sort(order, order + kept, [&](int a, int b) { return blend.get_weight(a) > blend.get_weight(b); });
+
+        const int influences = std::min(kept, static_cast<int>(SkinningMesh::MAX_INFLUENCES));
+        float total = 0.0f;
+        for (int k = 0; k < influences; ++k)
+        {
+            total += blend.get_weight(order[k]);
+        }
+        for (int k = 0; k < influences; ++k)
+        {
+            mesh.joints[k][i] = find_joint(blend.get_transform(order[k]));
+            mesh.weights[k][i] = total > 0.0f ? blend.get_weight(order[k]) / total : 0.0f;
+        }
+    }
+
+    return true;
+}
+
+int CpuSkinner::find_joint(const VertexTransform* transformPtr)
+{
+    for (int j = 1, j_end = static_cast<int>(m_joints.size()); j < j_end; ++j)
+    {
+        if (m_joints[j] == transformPtr)
+        {
+            return j;
+        }
+    }
+    m_joints.push_back(transformPtr);
+    m_matrices.push_back(m_matrices[0]);
+    return static_cast<int>(m_joints.size()) - 1;
+}
+
+bool CpuSkinner::is_valid() const
+{
+    return !m_targets.empty();
+}
+
+int CpuSkinner::get_num_vertices() const
+{
+    return m_numVertices;
+}
+
+int CpuSkinner::get_num_chunks() const
+{
+    return m_numChunks;
+}
+
+void CpuSkinner::begin_frame()
+{
+    // Panda matrices transform row vectors (v' = v * M), so the columns
+    // the kernel wants are the columns of M.
+    LMatrix4f mat;
+    for (int j = 1, j_end = static_cast<int>(m_joints.size()); j < j_end; ++j)
+    {
+        m_joints[j]->get_matrix(mat);
+        float* m = m_matrices[j].m;
+        for (int c = 0; c < 3; ++c)
+        {
+            m[4 * c] = mat(0, c);
+            m[4 * c + 1] = mat(1, c);
+            m[4 * c + 2] = mat(2, c);
+            m[4 * c + 3] = mat(3, c);
+        }
+    }
+
+    for (auto& target : m_targets)
+    {
+        target.positionHandlePtr = target.skinnedPtr->modify_array_handle(target.positionArray);
+        target.output.positions = target.positionHandlePtr->get_write_pointer() + target.positionOffset;
+        target.output.positionStride = target.skinnedPtr->get_format()->get_array(target.positionArray)->get_stride();
+
+        target.output.normals = nullptr;
+        if (target.normalArray >= 0)
+        {
+            target.normalHandlePtr = target.normalArray == target.positionArray
+                ? target.positionHandlePtr
+                : target.skinnedPtr->modify_array_handle(target.normalArray);
+            target.output.normals = target.normalHandlePtr->get_write_pointer() + target.normalOffset;
+            target.output.normalStride = target.skinnedPtr->get_format()->get_array(target.normalArray)->get_stride();
+        }
+    }
+}
+
+void CpuSkinner::skin_chunk(int chunk)
+{
+    int targetId = static_cast<int>(m_targets.size()) - 1;
+    while (m_targets[targetId].firstChunk > chunk)
+    {
+        --targetId;
+    }
+
+    const Target& target = m_targets[targetId];
+    const int begin = (chunk - target.firstChunk) * CpuSkinning::CHUNK_SIZE;
+    const int end = std::min(begin + CpuSkinning::CHUNK_SIZE, target.mesh.numVertices);
+    SkinningKernel::skin(target.mesh, m_matrices.data(), begin, end, target.output);
+}
+
+void CpuSkinner::end_frame()
+{
+    for (auto& target : m_targets)
+    {
+        target.positionHandlePtr = NULL;
+        target.normalHandlePtr = NULL;
+        target.output.positions = nullptr;
+        target.output.normals = nullptr;
+    }
+}
+
+// ************************************************************************************************
+
+bool CpuSkinning::should_use(GraphicsStateGuardianBase* gsgPtr)
+{
+    const std::string& mode = cpu_skinning.get_value();
+    if (mode == "on")
+    {
+        return true;
+    }
+    if (mode == "off")
+    {
+        return false;
+    }
+    // "auto": without a GSG, or with the software renderer, Panda would
+    // skin on the CPU anyway, so use the faster kernel.
+    return gsgPtr == NULL || gsgPtr->get_type().get_name().find("Tiny") != std::string::npos;
+}
+
+void CpuSkinning::skin_all(const std::vector<CpuSkinner*>& skinners)
+{
+    // First chunk of each skinner in the flattened list of chunks.
+    FrameVector<int> firstChunks;
+    firstChunks.reserve(skinners.size());
+    int numChunks = 0;
+    for (CpuSkinner* skinnerPtr : skinners)
+    {
+        skinnerPtr->begin_frame();
+        firstChunks.push_back(numChunks);
+        numChunks += skinnerPtr->get_num_chunks();
+    }
+
+    JobSystem::get_global_ptr()->parallel_for(0, numChunks, 1, [&](int firstChunk, int lastChunk) {
+        for (int chunk = firstChunk; chunk < lastChunk; ++chunk)
+        {
+            const int s = static_cast<int>(std::upper_bound(firstChunks.begin(), firstChunks.end(), chunk) - firstChunks.begin()) - 1;
+            skinners[s]->skin_chunk(chunk - firstChunks[s]);
+        }
+    });
+
+    for (CpuSkinner* skinnerPtr : skinners)
+    {
+        skinnerPtr->end_frame();
+    }
+}
+
+int CpuSkinning::get_num_threads()
+{
+    return JobSystem::get_global_ptr()->get_num_threads();
+}
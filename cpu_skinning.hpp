@@ -0,0 +1,142 @@
+/*
+ * cpu_skinning.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * CpuSkinning module: a vectorized replacement for Panda's generic CPU
+ * vertex animation, meant for software (tinydisplay) and headless runs
+ * where there is no GPU to do the skinning.
+ *
+ * The rest pose of a mesh is kept in SoA form (SkinningMesh) and blended by
+ * up to 4 joint matrices per vertex, 8 vertices at a time with AVX2 or 4 at
+ * a time with SSE, falling back to scalar code elsewhere. The vertex range
+ * of every mesh is split in chunks spread over the JobSystem threads.
+ */
+
+#ifndef CPU_SKINNING_HPP_
+#define CPU_SKINNING_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <geomNode.h>
+#include <geomVertexData.h>
+#include <graphicsStateGuardianBase.h>
+#include <vertexTransform.h>
+
+// Joint matrix in the layout the kernel wants: three columns of four
+// floats, so that x' = x * m[0] + y * m[1] + z * m[2] + m[3], and so on
+// with m[4..7] for y' and m[8..11] for z'.
+struct SkinningMatrix
+{
+    float m[12];
+};
+
+struct SkinningMesh
+{
+    static const int MAX_INFLUENCES = 4;
+    // Vertex arrays are padded to a multiple of this, with null weights.
+    static const int LANE_PADDING = 8;
+
+    void resize(int numVertices);
+
+    int numVertices = 0;
+    std::vector<float> px, py, pz;
+    std::vector<float> nx, ny, nz;
+    std::vector<int32_t> joints[MAX_INFLUENCES];
+    std::vector<float> weights[MAX_INFLUENCES];
+};
+
+// Strided destination of the skinned vertices, usually a vertex array.
+struct SkinningOutput
+{
+    unsigned char* positions = nullptr;
+    int positionStride = 0;
+    unsigned char* normals = nullptr;     // may be null
+    int normalStride = 0;
+};
+
+class SkinningKernel
+{
+public:
+    // Skins vertices [begin, end) of `mesh'. `begin' must be a multiple of
+    // SkinningMesh::LANE_PADDING.
+    static void skin(const SkinningMesh& mesh,
+                     const SkinningMatrix* matrices,
+                     int begin,
+                     int end,
+                     const SkinningOutput& output);
+
+    static void skin_scalar(const SkinningMesh& mesh,
+                            const SkinningMatrix* matrices,
+                            int begin,
+                            int end,
+                            const SkinningOutput& output);
+
+    // Name of the instruction set skin() was compiled for.
+    static const char* get_isa_name();
+};
+
+// Takes over the skinning of the animated geometry of one GeomNode: its
+// geoms are pointed to static copies of their vertex data, which are
+// filled by the kernel instead of GeomVertexData::animate_vertices().
+class CpuSkinner
+{
+public:
+    CpuSkinner(GeomNode* geomNodePtr);
+
+    bool is_valid() const;
+    int get_num_vertices() const;
+
+    // Main thread: snapshot the joint matrices and open the vertex arrays.
+    void begin_frame();
+    // Any thread: skin one chunk of vertices.
+    void skin_chunk(int chunk);
+    int get_num_chunks() const;
+    // Main thread: release the vertex arrays.
+    void end_frame();
+
+private:
+    struct Target
+    {
+        CPT(GeomVertexData) sourcePtr;
+        PT(GeomVertexData) skinnedPtr;
+        SkinningMesh mesh;
+        int positionArray;
+        int positionOffset;
+        int normalArray;
+        int normalOffset;
+        PT(GeomVertexArrayDataHandle) positionHandlePtr;
+        PT(GeomVertexArrayDataHandle) normalHandlePtr;
+        SkinningOutput output;
+        int firstChunk;
+    };
+
+    bool setup_target(Target& target);
+    int find_joint(const VertexTransform* transformPtr);
+
+    std::vector<CPT(VertexTransform)> m_joints;
+    std::vector<SkinningMatrix> m_matrices;
+    std::vector<Target> m_targets;
+    int m_numVertices;
+    int m_numChunks;
+};
+
+class CpuSkinning
+{
+public:
+    // Vertices handed to a job at a time.
+    static const int CHUNK_SIZE = 1024;
+
+    // Whether skinned models should go through CpuSkinner rather than
+    // Panda's stock path, according to the cpu-skinning config variable
+    // ("auto" picks it for software rendering and when there is no GSG).
+    static bool should_use(GraphicsStateGuardianBase* gsgPtr);
+
+    // Skin all the given meshes, spreading the work over the job threads.
+    static void skin_all(const std::vector<CpuSkinner*>& skinners);
+
+    static int get_num_threads();
+};
+
+#endif /* CPU_SKINNING_HPP_ */
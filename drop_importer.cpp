@@ -0,0 +1,379 @@
+/*
+ * drop_importer.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <fstream>
+
+#include <asyncTaskManager.h>
+#include <cardMaker.h>
+#include <configVariableInt.h>
+#include <configVariableString.h>
+#include <loader.h>
+#include <loaderFileTypeRegistry.h>
+#include <pnmFileTypeRegistry.h>
+#include <string_utils.h>
+#include <transparencyAttrib.h>
+
+#include "imgui.h"
+#include "adventure_3d_game.hpp"
+#include "drop_importer.hpp"
+#include "event_bus.hpp"
+#include "game_events.hpp"
+
+namespace
+{
+    ConfigVariableInt drop_import_threads
+    ("drop-import-threads", 2,
+     PRC_DESC("Number of threads decoding the files dropped on the window."));
+
+    ConfigVariableString drop_dir
+    ("drop-dir", "drop",
+     PRC_DESC("Files saved in this directory are imported as if dropped on "
+              "the window. Empty to disable."));
+
+    const char* const DROP_IMPORT_TASK_CHAIN_NAME = "dropImporter";
+    const double SCAN_PERIOD = 0.5;         // s
+    const size_t READ_CHUNK_SIZE = 1 << 20;
+    // Models are scaled to this radius, images to this half height.
+    const float IMPORT_SIZE = 1.5f;
+
+    const char* get_state_name(int state)
+    {
+        static const char* const names[] = { "queued", "reading", "decoding", "ready", "done", "failed" };
+        return names[state];
+    }
+}
+
+DropImporter* DropImporter::get_global_ptr()
+{
+    static DropImporter importer;
+    return &importer;
+}
+
+DropImporter::DropImporter()
+    : m_numAttached(0),
+    m_showPanel(false),
+    m_firstScan(true)
+{
+}
+
+void DropImporter::init(NodePath parent, NodePath camera)
+{
+    // preconditions
+    if (parent.is_empty() || camera.is_empty())
+    {
+        nout << "ERROR: parameters parent and camera cannot be empty." << std::endl;
+        return;
+    }
+    if (m_frameTaskPtr != NULL)
+    {
+        return;
+    }
+
+    m_parentNp = parent;
+    m_cameraNp = camera;
+
+    AsyncTaskManager* taskMgrPtr = AsyncTaskManager::get_global_ptr();
+    AsyncTaskChain* chainPtr = taskMgrPtr->make_task_chain(DROP_IMPORT_TASK_CHAIN_NAME);
+    chainPtr->set_num_threads(std::max(1, static_cast<int>(drop_import_threads)));
+    chainPtr->set_frame_sync(false);
+
+    // Results are attached before the scene tasks of the frame run.
+    m_frameTaskPtr = new GenericAsyncTask("dropImporterTask", frame_task, this);
+    m_frameTaskPtr->set_sort(-800);
+    taskMgrPtr->add(m_frameTaskPtr);
+
+    EventBus::subscribe<NewFrameEvent>(on_new_frame, this);
+
+    m_dropDir = Filename::from_os_specific(drop_dir);
+    if (!m_dropDir.empty() && m_dropDir.is_directory())
+    {
+        m_scanTaskPtr = new GenericAsyncTask("dropDirScanTask", scan_task, this);
+        m_scanTaskPtr->set_task_chain(DROP_IMPORT_TASK_CHAIN_NAME);
+        taskMgrPtr->add(m_scanTaskPtr);
+    }
+}
+
+void DropImporter::import(const std::vector<Filename>& filenames)
+{
+    if (m_frameTaskPtr == NULL)
+    {
+        nout << "ERROR: DropImporter::init() was not called." << std::endl;
+        return;
+    }
+
+    AsyncTaskManager* taskMgrPtr = AsyncTaskManager::get_global_ptr();
+    for (const Filename& filename : filenames)
+    {
+        std::shared_ptr<Import> import = std::make_shared<Import>();
+        import->filename = filename;
+        import->state = S_queued;
+        import->progress = 0;
+        import->scale = 1;
+        m_imports.push_back(import);
+
+        PT(GenericAsyncTask) taskPtr = new GenericAsyncTask("drop-import-" + filename.get_basename(), decode_task, import.get());
+        taskPtr->set_task_chain(DROP_IMPORT_TASK_CHAIN_NAME);
+        taskMgrPtr->add(taskPtr);
+    }
+    m_showPanel = true;
+}
+
+int DropImporter::get_num_in_flight() const
+{
+    int count = 0;
+    for (const std::shared_ptr<Import>& import : m_imports)
+    {
+        if (import->state < S_ready)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void DropImporter::on_files_dropped(const Event* eventPtr, void* dataPtr)
+{
+    const Adventure3D* helperPtr = static_cast<const Adventure3D*>(dataPtr);
+    get_global_ptr()->import(helperPtr->get_dropped_files());
+}
+
+void DropImporter::decode(Import& import)
+{
+    std::string extension = downcase(import.filename.get_extension());
+    if (extension == "pz" || extension == "gz")
+    {
+        extension = downcase(Filename(import.filename.get_fullpath_wo_extension()).get_extension());
+    }
+    const bool isModel = LoaderFileTypeRegistry::get_global_ptr()->get_type_from_extension(extension) != NULL;
+    const bool isImage = PNMFileTypeRegistry::get_global_ptr()->get_type_from_extension(extension) != NULL;
+    if (!isModel && !isImage)
+    {
+        import.error = "unknown file type";
+        import.state = S_failed;
+        return;
+    }
+
+    import.state = S_reading;
+    if (!read_ahead(import))
+    {
+        import.error = "unable to read the file";
+        import.state = S_failed;
+        return;
+    }
+
+    import.state = S_decoding;
+    LPoint3 minPoint;
+    LPoint3 maxPoint;
+    if (isModel)
+    {
+        LoaderOptions options(LoaderOptions::LF_report_errors | LoaderOptions::LF_no_ram_cache);
+        import.nodePtr = Loader::get_global_ptr()->load_sync(import.filename, options);
+        if (import.nodePtr != NULL && NodePath(import.nodePtr).calc_tight_bounds(minPoint, maxPoint))
+        {
+            const PN_stdfloat radius = (maxPoint - minPoint).length() / 2;
+            import.scale = radius > 0 ? IMPORT_SIZE / radius : 1;
+        }
+    }
+    else
+    {
+        import.texturePtr = new Texture(import.filename.get_basename());
+        if (!import.texturePtr->read(import.filename))
+        {
+            import.texturePtr = NULL;
+        }
+    }
+
+    import.progress = 1;
+    if (import.nodePtr == NULL && import.texturePtr == NULL)
+    {
+        import.error = "unable to decode the file";
+        import.state = S_failed;
+        return;
+    }
+    import.state = S_ready;
+}
+
+bool DropImporter::read_ahead(Import& import)
+{
+    // The loaders read the file in one call: reading it first, chunk by
+    // chunk, gives a progress and leaves it in the OS cache for them.
+    std::ifstream input(import.filename.to_os_specific().c_str(), std::ios::binary | std::ios::ate);
+    if (!input)
+    {
+        return false;
+    }
+    const std::streamoff size = input.tellg();
+    input.seekg(0);
+
+    std::vector<char> buffer(READ_CHUNK_SIZE);
+    std::streamoff read = 0;
+    while (read < size)
+    {
+        input.read(buffer.data(), buffer.size());
+        if (input.gcount() <= 0)
+        {
+            break;
+        }
+        read += input.gcount();
+        import.progress = 0.5f * static_cast<float>(read) / static_cast<float>(size);
+    }
+    return read == size;
+}
+
+void DropImporter::attach(Import& import)
+{
+    NodePath np;
+    if (import.nodePtr != NULL)
+    {
+        np = NodePath(import.nodePtr);
+        np.set_scale(import.scale);
+    }
+    else
+    {
+        const PN_stdfloat aspect = static_cast<PN_stdfloat>(import.texturePtr->get_x_size()) /
+                                   std::max(1, import.texturePtr->get_y_size());
+        CardMaker cardMaker(import.filename.get_basename());
+        cardMaker.set_frame(-aspect * IMPORT_SIZE, aspect * IMPORT_SIZE, -IMPORT_SIZE, IMPORT_SIZE);
+        np = NodePath(cardMaker.generate());
+        np.set_texture(import.texturePtr);
+        np.set_two_sided(true);
+        if (Texture::has_alpha(import.texturePtr->get_format()))
+        {
+            np.set_transparency(TransparencyAttrib::M_alpha);
+        }
+    }
+
+    // In front of the camera, side by side.
+    const PN_stdfloat offset = (m_numAttached % 5 - 2) * 2 * IMPORT_SIZE;
+    np.reparent_to(m_parentNp);
+    np.set_pos(m_cameraNp, LPoint3(offset, 12, 0));
+    np.set_hpr(m_cameraNp, LVecBase3(0, 0, 0));
+    ++m_numAttached;
+
+    import.nodePtr = NULL;
+    import.texturePtr = NULL;
+}
+
+void DropImporter::scan_drop_dir()
+{
+    vector_string names;
+    if (!m_dropDir.scan_directory(names))
+    {
+        return;
+    }
+
+    std::vector<Filename> dropped;
+    std::map<std::string, time_t> scanned;
+    for (const std::string& name : names)
+    {
+        const Filename filename(m_dropDir, name);
+        if (filename.is_directory())
+        {
+            continue;
+        }
+        const time_t timestamp = filename.get_timestamp();
+        scanned[name] = timestamp;
+
+        // The files there at startup were imported by an earlier run.
+        if (m_firstScan)
+        {
+            m_imported[name] = timestamp;
+            continue;
+        }
+        // Still being written if it changed since the last scan.
+        std::map<std::string, time_t>::const_iterator it = m_scanned.find(name);
+        if (it != m_scanned.end() && it->second == timestamp)
+        {
+            std::map<std::string, time_t>::const_iterator imported = m_imported.find(name);
+            if (imported == m_imported.end() || imported->second != timestamp)
+            {
+                m_imported[name] = timestamp;
+                dropped.push_back(filename);
+            }
+        }
+    }
+    m_scanned.swap(scanned);
+    m_firstScan = false;
+
+    if (!dropped.empty())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dropped.insert(m_dropped.end(), dropped.begin(), dropped.end());
+    }
+}
+
+void DropImporter::draw_panel()
+{
+    if (!m_showPanel)
+    {
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(360, 200), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Imports", &m_showPanel))
+    {
+        char overlay[64];
+        for (const std::shared_ptr<Import>& import : m_imports)
+        {
+            const State state = import->state;
+            ImGui::Text("%s", import->filename.get_basename().c_str());
+            snprintf(overlay, sizeof(overlay), "%s", state == S_failed ? import->error.c_str() : get_state_name(state));
+            ImGui::ProgressBar(state == S_failed ? 0.0f : import->progress.load(), ImVec2(-1, 0), overlay);
+        }
+
+        if (ImGui::Button("Clear finished"))
+        {
+            m_imports.erase(std::remove_if(m_imports.begin(), m_imports.end(), [](const std::shared_ptr<Import>& import) {
+                return import->state == S_attached || import->state == S_failed;
+                }), m_imports.end());
+        }
+    }
+    ImGui::End();
+}
+
+AsyncTask::DoneStatus DropImporter::decode_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    decode(*static_cast<Import*>(dataPtr));
+    return AsyncTask::DS_done;
+}
+
+AsyncTask::DoneStatus DropImporter::scan_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<DropImporter*>(dataPtr)->scan_drop_dir();
+    taskPtr->set_delay(SCAN_PERIOD);
+    return AsyncTask::DS_again;
+}
+
+AsyncTask::DoneStatus DropImporter::frame_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    DropImporter* importerPtr = static_cast<DropImporter*>(dataPtr);
+
+    std::vector<Filename> dropped;
+    {
+        std::lock_guard<std::mutex> lock(importerPtr->m_mutex);
+        dropped.swap(importerPtr->m_dropped);
+    }
+    if (!dropped.empty())
+    {
+        importerPtr->import(dropped);
+    }
+
+    for (const std::shared_ptr<Import>& import : importerPtr->m_imports)
+    {
+        if (import->state == S_ready)
+        {
+            importerPtr->attach(*import);
+            import->state = S_attached;
+        }
+    }
+    return AsyncTask::DS_cont;
+}
+
+void DropImporter::on_new_frame(const NewFrameEvent& event, void* dataPtr)
+{
+    static_cast<DropImporter*>(dataPtr)->draw_panel();
+}
@@ -0,0 +1,111 @@
+/*
+ * drop_importer.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * DropImporter module: imports the model and image files dropped on the
+ * window without freezing the game. Each file is read and decoded by a
+ * task of its own task chain (drop-import-threads threads), which reports
+ * its progress to an ImGui panel; the result is attached in front of the
+ * camera at the start of a later frame, a model as is, an image on a card.
+ *
+ * Files come from the window (WM_DROPFILES on Windows, see
+ * Adventure3D::enable_file_drop()) or, where the window gives none, from
+ * the drop-dir directory: a file copied or saved there is imported once it
+ * stops changing.
+ */
+
+#ifndef DROP_IMPORTER_HPP_
+#define DROP_IMPORTER_HPP_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <filename.h>
+#include <genericAsyncTask.h>
+#include <nodePath.h>
+#include <texture.h>
+
+class Event;
+struct NewFrameEvent;
+
+class DropImporter
+{
+public:
+    static DropImporter* get_global_ptr();
+
+    // Models and cards go under `parent', placed in front of `camera'.
+    // Starts watching drop-dir. Main thread.
+    void init(NodePath parent, NodePath camera);
+
+    // Main thread.
+    void import(const std::vector<Filename>& filenames);
+
+    int get_num_in_flight() const;
+
+    // Hooked to Adventure3D::DROPFILES_EVENT_NAME, with the Adventure3D
+    // as data.
+    static void on_files_dropped(const Event* eventPtr, void* dataPtr);
+
+private:
+    enum State
+    {
+        S_queued,
+        S_reading,
+        S_decoding,
+        S_ready,
+        S_attached,
+        S_failed
+    };
+
+    // Shared with the task decoding it, which sets everything but
+    // `attached' and publishes with `state'.
+    struct Import
+    {
+        Filename filename;
+        std::atomic<State> state;
+        std::atomic<float> progress;    // 0 to 1
+        PT(PandaNode) nodePtr;
+        PT(Texture) texturePtr;
+        float scale;                    // of the model, to a common size
+        std::string error;
+    };
+
+    DropImporter();
+
+    void attach(Import& import);
+    void scan_drop_dir();
+    void draw_panel();
+
+    static void decode(Import& import);
+    static bool read_ahead(Import& import);
+    static AsyncTask::DoneStatus decode_task(GenericAsyncTask* taskPtr, void* dataPtr);
+    static AsyncTask::DoneStatus scan_task(GenericAsyncTask* taskPtr, void* dataPtr);
+    static AsyncTask::DoneStatus frame_task(GenericAsyncTask* taskPtr, void* dataPtr);
+    static void on_new_frame(const NewFrameEvent& event, void* dataPtr);
+
+    DropImporter(const DropImporter&); // to prevent copies
+
+    NodePath m_parentNp;
+    NodePath m_cameraNp;
+    std::vector<std::shared_ptr<Import>> m_imports;     // main thread
+    int m_numAttached;
+    bool m_showPanel;
+    PT(GenericAsyncTask) m_frameTaskPtr;
+    PT(GenericAsyncTask) m_scanTaskPtr;
+
+    // Scan task only.
+    Filename m_dropDir;
+    std::map<std::string, time_t> m_scanned;    // as of the last scan
+    std::map<std::string, time_t> m_imported;
+    bool m_firstScan;
+
+    std::mutex m_mutex;                         // guards m_dropped
+    std::vector<Filename> m_dropped;            // found by the scan task
+};
+
+#endif /* DROP_IMPORTER_HPP_ */
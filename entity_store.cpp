@@ -0,0 +1,208 @@
+/*
+ * entity_store.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "entity_store.hpp"
+#include "hot_reload.hpp"
+
+static const double PI = 3.14159265;
+
+EntityStore::EntityStore()
+    : m_numEntities(0),
+    m_syncedTransforms(0),
+    m_transformStates(0)
+{
+}
+
+Entity EntityStore::create()
+{
+    Entity entity;
+    if (!m_freeEntities.empty())
+    {
+        entity = m_freeEntities.back();
+        m_freeEntities.pop_back();
+        m_alive[entity] = true;
+    }
+    else
+    {
+        entity = static_cast<Entity>(m_alive.size());
+        m_alive.push_back(true);
+    }
+    ++m_numEntities;
+    return entity;
+}
+
+void EntityStore::destroy(Entity entity)
+{
+    // preconditions
+    if (entity >= m_alive.size() || !m_alive[entity])
+    {
+        nout << "ERROR: entity " << entity << " doesn't exist." << std::endl;
+        return;
+    }
+
+    Model* modelPtr = m_models.get(entity);
+    if (modelPtr != NULL && !modelPtr->np.is_empty())
+    {
+        HotReload::get_global_ptr()->untrack(modelPtr->np);
+        modelPtr->np.remove_node();
+    }
+    m_transforms.remove(entity);
+    m_models.remove(entity);
+    m_oscillators.remove(entity);
+    m_spinners.remove(entity);
+    m_blinkers.remove(entity);
+
+    m_alive[entity] = false;
+    m_freeEntities.push_back(entity);
+    --m_numEntities;
+}
+
+void EntityStore::update(double time)
+{
+    oscillate(time);
+    spin(time);
+    blink(time);
+    commit_transforms();
+}
+
+EntityStore::Stats EntityStore::get_stats() const
+{
+    Stats stats;
+    stats.numEntities = m_numEntities;
+    stats.syncedTransforms = m_syncedTransforms;
+    stats.transformStates = m_transformStates;
+    return stats;
+}
+
+void EntityStore::oscillate(double time)
+{
+    for (int i = 0; i < m_oscillators.size(); ++i)
+    {
+        const Oscillator& oscillator = m_oscillators[i];
+        Transform* transformPtr = m_transforms.get(m_oscillators.get_entity(i));
+        if (transformPtr == NULL)
+        {
+            continue;
+        }
+        const double angle = 2 * PI * time / oscillator.period + oscillator.phase;
+        transformPtr->pos = oscillator.basePos + oscillator.amplitude * static_cast<float>(sin(angle));
+        transformPtr->dirty = true;
+    }
+}
+
+void EntityStore::spin(double time)
+{
+    for (int i = 0; i < m_spinners.size(); ++i)
+    {
+        const Spinner& spinner = m_spinners[i];
+        Transform* transformPtr = m_transforms.get(m_spinners.get_entity(i));
+        if (transformPtr == NULL)
+        {
+            continue;
+        }
+        // Note: wrapped so the angles keep their precision on long runs.
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            transformPtr->hpr[axis] = static_cast<float>(fmod(spinner.baseHpr[axis] + spinner.rate[axis] * time, 360.0));
+        }
+        transformPtr->dirty = true;
+    }
+}
+
+void EntityStore::blink(double time)
+{
+    for (int i = 0; i < m_blinkers.size(); ++i)
+    {
+        Blinker& blinker = m_blinkers[i];
+        Model* modelPtr = m_models.get(m_blinkers.get_entity(i));
+        if (modelPtr == NULL || modelPtr->np.is_empty())
+        {
+            continue;
+        }
+        const double cycle = fmod(time + blinker.phase, blinker.period);
+        const int shown = cycle < blinker.period / 2 ? 0 : 1;
+        if (shown != blinker.shown)
+        {
+            modelPtr->np.set_texture(blinker.textures[shown]);
+            blinker.shown = shown;
+        }
+    }
+}
+
+void EntityStore::commit_transforms()
+{
+    // The dirty transforms, sorted by value: equal ones end up side by
+    // side and share one state. The vectors are members so that their
+    // capacity carries over and a pass doesn't allocate.
+    m_commits.clear();
+    for (int i = 0; i < m_transforms.size(); ++i)
+    {
+        Transform& transform = m_transforms[i];
+        if (!transform.dirty)
+        {
+            continue;
+        }
+        Model* modelPtr = m_models.get(m_transforms.get_entity(i));
+        if (modelPtr == NULL || modelPtr->np.is_empty())
+        {
+            continue;
+        }
+        transform.dirty = false;
+
+        Commit commit;
+        commit.key = {
+            transform.pos[0], transform.pos[1], transform.pos[2],
+            transform.hpr[0], transform.hpr[1], transform.hpr[2],
+            transform.scale[0], transform.scale[1], transform.scale[2] };
+        commit.nodePtr = modelPtr->np.node();
+        commit.transform = i;
+        m_commits.push_back(commit);
+    }
+    std::sort(m_commits.begin(), m_commits.end(), [](const Commit& a, const Commit& b) { return a.key < b.key; });
+
+    Thread* currentThreadPtr = Thread::get_current_thread();
+    m_nextStates.clear();
+    m_syncedTransforms = 0;
+    CPT(TransformState) statePtr;
+    for (size_t k = 0; k < m_commits.size(); ++k)
+    {
+        const Commit& commit = m_commits[k];
+
+        // One state per distinct transform; TransformState::make_*() locks
+        // and hashes into Panda's global cache for each call. The states of
+        // the last pass are reused for the transforms that take the same
+        // values again.
+        if (k == 0 || commit.key != m_commits[k - 1].key)
+        {
+            auto it = std::lower_bound(m_states.begin(), m_states.end(), commit.key,
+                                       [](const State& state, const TransformKey& key) { return state.first < key; });
+            if (it != m_states.end() && it->first == commit.key)
+            {
+                statePtr = it->second;
+            }
+            else
+            {
+                const Transform& transform = m_transforms[commit.transform];
+                statePtr = TransformState::make_pos_hpr_scale(transform.pos, transform.hpr, transform.scale);
+            }
+            m_nextStates.push_back(State(commit.key, statePtr));
+        }
+
+        // States are unique, so the same pointer is the same transform: the
+        // node and its ancestors' bounds stay as they are.
+        if (commit.nodePtr->get_transform(currentThreadPtr) == statePtr)
+        {
+            continue;
+        }
+        commit.nodePtr->set_transform(statePtr, currentThreadPtr);
+        ++m_syncedTransforms;
+    }
+    m_transformStates = static_cast<int>(m_nextStates.size());
+    m_states.swap(m_nextStates);
+}
@@ -0,0 +1,259 @@
+/*
+ * entity_store.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * EntityStore module: the state of the objects of a scene as entities with
+ * components, each kind of component in a dense array of its own. An
+ * entity is only an id; it has the components added for it, at most one
+ * of each kind.
+ *
+ * update() runs the systems over their arrays in order: oscillators and
+ * spinners animate the transforms, blinkers swap the textures of their
+ * models, then the transforms that changed are committed to the nodes of
+ * their models. Nothing else touches the scene graph, so static entities
+ * cost nothing after their first update.
+ *
+ * The Transform components are a staging buffer: code may write them any
+ * number of times during a frame, only the last value reaches the scene
+ * graph. The commit makes one TransformState per distinct transform of the
+ * pass, and leaves alone the nodes that have it already, so their bounds
+ * aren't invalidated for nothing.
+ */
+
+#ifndef ENTITY_STORE_HPP_
+#define ENTITY_STORE_HPP_
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <nodePath.h>
+#include <texture.h>
+#include <transformState.h>
+
+typedef unsigned int Entity;
+
+// The components of one kind: dense, in no particular order, with the
+// index of each entity's component kept aside.
+template<typename T>
+class ComponentArray
+{
+public:
+    // Replaces the component if `entity' has one already.
+    T& add(Entity entity, const T& component);
+    void remove(Entity entity);
+
+    // NULL if `entity' has no such component.
+    T* get(Entity entity);
+    const T* get(Entity entity) const;
+
+    // Dense access, for the systems.
+    int size() const;
+    T& operator[](int index);
+    Entity get_entity(int index) const;
+
+private:
+    std::vector<T> m_components;
+    std::vector<Entity> m_entities;         // of each component
+    std::vector<int> m_indices;             // by entity, -1 for none
+};
+
+class EntityStore
+{
+public:
+    struct Transform
+    {
+        LPoint3f pos = LPoint3f::zero();
+        LVecBase3f hpr = LVecBase3f::zero();
+        LVecBase3f scale = LVecBase3f(1);
+        bool dirty = true;                  // to be copied to the model
+    };
+
+    struct Model
+    {
+        NodePath np;
+    };
+
+    // pos = basePos + amplitude * sin(2 pi t / period + phase)
+    struct Oscillator
+    {
+        LPoint3f basePos;
+        LVecBase3f amplitude;
+        double period;
+        double phase;
+    };
+
+    // hpr = baseHpr + rate * t, in degrees
+    struct Spinner
+    {
+        LVecBase3f baseHpr;
+        LVecBase3f rate;
+    };
+
+    // Shows textures[0] for the first half of every period, textures[1]
+    // for the second.
+    struct Blinker
+    {
+        PT(Texture) textures[2];
+        double period;
+        double phase;
+        int shown = -1;
+    };
+
+    struct Stats
+    {
+        int numEntities = 0;
+        int syncedTransforms = 0;           // during the last update
+        int transformStates = 0;            // distinct ones among those
+    };
+
+    EntityStore();
+
+    Entity create();
+    // Removes the components of `entity', and the node of its model (no
+    // longer hot reloaded).
+    void destroy(Entity entity);
+
+    ComponentArray<Transform>& get_transforms();
+    ComponentArray<Model>& get_models();
+    ComponentArray<Oscillator>& get_oscillators();
+    ComponentArray<Spinner>& get_spinners();
+    ComponentArray<Blinker>& get_blinkers();
+
+    // Runs the systems for `time' seconds since the start, then commits the
+    // dirty transforms. Main thread once the models are in the scene.
+    void update(double time);
+
+    Stats get_stats() const;
+
+private:
+    typedef std::array<float, 9> TransformKey;              // pos, hpr, scale
+    typedef std::pair<TransformKey, CPT(TransformState)> State;
+
+    // A dirty transform, on its way to the node of its model.
+    struct Commit
+    {
+        TransformKey key;
+        PandaNode* nodePtr;
+        int transform;                      // index in m_transforms
+    };
+
+    void oscillate(double time);
+    void spin(double time);
+    void blink(double time);
+    void commit_transforms();
+
+    EntityStore(const EntityStore&); // to prevent copies
+
+    std::vector<bool> m_alive;
+    std::vector<Entity> m_freeEntities;
+    int m_numEntities;
+    int m_syncedTransforms;
+    int m_transformStates;
+    // The states of the last commit, sorted by key. Kept between commits
+    // for the transforms that take the same values again.
+    std::vector<State> m_states;
+    std::vector<State> m_nextStates;
+    std::vector<Commit> m_commits;
+    ComponentArray<Transform> m_transforms;
+    ComponentArray<Model> m_models;
+    ComponentArray<Oscillator> m_oscillators;
+    ComponentArray<Spinner> m_spinners;
+    ComponentArray<Blinker> m_blinkers;
+};
+
+// ************************************************************************************************
+
+template<typename T>
+T& ComponentArray<T>::add(Entity entity, const T& component)
+{
+    if (entity >= m_indices.size())
+    {
+        m_indices.resize(entity + 1, -1);
+    }
+    if (m_indices[entity] >= 0)
+    {
+        return m_components[m_indices[entity]] = component;
+    }
+    m_indices[entity] = static_cast<int>(m_components.size());
+    m_components.push_back(component);
+    m_entities.push_back(entity);
+    return m_components.back();
+}
+
+template<typename T>
+void ComponentArray<T>::remove(Entity entity)
+{
+    if (entity >= m_indices.size() || m_indices[entity] < 0)
+    {
+        return;
+    }
+
+    // The last component takes the place of the removed one.
+    const int index = m_indices[entity];
+    const Entity lastEntity = m_entities.back();
+    m_components[index] = std::move(m_components.back());
+    m_entities[index] = lastEntity;
+    m_indices[lastEntity] = index;
+    m_components.pop_back();
+    m_entities.pop_back();
+    m_indices[entity] = -1;
+}
+
+template<typename T>
+T* ComponentArray<T>::get(Entity entity)
+{
+    return entity < m_indices.size() && m_indices[entity] >= 0 ? &m_components[m_indices[entity]] : NULL;
+}
+
+template<typename T>
+const T* ComponentArray<T>::get(Entity entity) const
+{
+    return entity < m_indices.size() && m_indices[entity] >= 0 ? &m_components[m_indices[entity]] : NULL;
+}
+
+template<typename T>
+int ComponentArray<T>::size() const
+{
+    return static_cast<int>(m_components.size());
+}
+
+template<typename T>
+T& ComponentArray<T>::operator[](int index)
+{
+    return m_components[index];
+}
+
+template<typename T>
+Entity ComponentArray<T>::get_entity(int index) const
+{
+    return m_entities[index];
+}
+
+inline ComponentArray<EntityStore::Transform>& EntityStore::get_transforms()
+{
+    return m_transforms;
+}
+
+inline ComponentArray<EntityStore::Model>& EntityStore::get_models()
+{
+    return m_models;
+}
+
+inline ComponentArray<EntityStore::Oscillator>& EntityStore::get_oscillators()
+{
+    return m_oscillators;
+}
+
+inline ComponentArray<EntityStore::Spinner>& EntityStore::get_spinners()
+{
+    return m_spinners;
+}
+
+inline ComponentArray<EntityStore::Blinker>& EntityStore::get_blinkers()
+{
+    return m_blinkers;
+}
+
+#endif /* ENTITY_STORE_HPP_ */
@@ -0,0 +1,162 @@
+/*
+ * event_bus.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * EventBus module: typed events dispatched to plain function handlers,
+ * for events frequent enough that going through Panda's EventHandler (an
+ * Event object, a string hash and a map lookup per dispatch) shows.
+ *
+ * An event is any struct; its handlers live in a contiguous array of its
+ * own, picked at compile time from the event type, so publishing is a
+ * loop over function pointers. Panda events are bridged once, at the
+ * boundary: bridge() hooks the Panda event and publishes the converted
+ * event on the bus, and game code subscribes to the typed event only.
+ *
+ * The bus belongs to the main thread, like EventHandler.
+ */
+
+#ifndef EVENT_BUS_HPP_
+#define EVENT_BUS_HPP_
+
+#include <string>
+#include <vector>
+
+#include <event.h>
+#include <eventHandler.h>
+
+namespace EventBus
+{
+    template<typename E>
+    class Channel
+    {
+    public:
+        typedef void Handler(const E& event, void* dataPtr);
+
+        static Channel& get()
+        {
+            static Channel channel;
+            return channel;
+        }
+
+        void subscribe(Handler* handlerPtr, void* dataPtr)
+        {
+            // preconditions
+            if (handlerPtr == NULL)
+            {
+                nout << "ERROR: parameter handlerPtr cannot be NULL." << std::endl;
+                return;
+            }
+
+            Slot slot = { handlerPtr, dataPtr };
+            m_slots.push_back(slot);
+        }
+
+        void unsubscribe(Handler* handlerPtr, void* dataPtr)
+        {
+            for (Slot& slot : m_slots)
+            {
+                if (slot.handlerPtr == handlerPtr && slot.dataPtr == dataPtr)
+                {
+                    // Compacted once no publish() is running, which may be
+                    // iterating over the slots.
+                    slot.handlerPtr = NULL;
+                    m_hasHoles = true;
+                }
+            }
+            compact();
+        }
+
+        void publish(const E& event)
+        {
+            ++m_publishDepth;
+            // Handlers subscribed during the publication wait for the next.
+            for (size_t k = 0, k_end = m_slots.size(); k < k_end; ++k)
+            {
+                const Slot slot = m_slots[k];
+                if (slot.handlerPtr != NULL)
+                {
+                    slot.handlerPtr(event, slot.dataPtr);
+                }
+            }
+            --m_publishDepth;
+            compact();
+        }
+
+        int get_num_handlers() const
+        {
+            return static_cast<int>(m_slots.size());
+        }
+
+    private:
+        struct Slot
+        {
+            Handler* handlerPtr;
+            void* dataPtr;
+        };
+
+        Channel()
+            : m_publishDepth(0),
+            m_hasHoles(false)
+        {
+        }
+
+        void compact()
+        {
+            if (m_publishDepth > 0 || !m_hasHoles)
+            {
+                return;
+            }
+            std::vector<Slot> slots;
+            for (const Slot& slot : m_slots)
+            {
+                if (slot.handlerPtr != NULL)
+                {
+                    slots.push_back(slot);
+                }
+            }
+            m_slots.swap(slots);
+            m_hasHoles = false;
+        }
+
+        Channel(const Channel&); // to prevent copies
+
+        std::vector<Slot> m_slots;
+        int m_publishDepth;
+        bool m_hasHoles;
+    };
+
+    template<typename E>
+    void subscribe(typename Channel<E>::Handler* handlerPtr, void* dataPtr = NULL)
+    {
+        Channel<E>::get().subscribe(handlerPtr, dataPtr);
+    }
+
+    template<typename E>
+    void unsubscribe(typename Channel<E>::Handler* handlerPtr, void* dataPtr = NULL)
+    {
+        Channel<E>::get().unsubscribe(handlerPtr, dataPtr);
+    }
+
+    template<typename E>
+    void publish(const E& event)
+    {
+        Channel<E>::get().publish(event);
+    }
+
+    // Publishes an E for every `pandaEventName' thrown, as converted by
+    // `convertPtr', which returns false to drop the event.
+    template<typename E>
+    void bridge(const std::string& pandaEventName, bool (*convertPtr)(const Event* eventPtr, E& event))
+    {
+        EventHandler::get_global_event_handler()->add_hook(pandaEventName, [](const Event* eventPtr, void* dataPtr) {
+            E event;
+            if (reinterpret_cast<bool (*)(const Event*, E&)>(dataPtr)(eventPtr, event))
+            {
+                Channel<E>::get().publish(event);
+            }
+        }, reinterpret_cast<void*>(convertPtr));
+    }
+}
+
+#endif /* EVENT_BUS_HPP_ */
@@ -0,0 +1,151 @@
+/*
+ * frame_arena.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <new>
+
+#include <asyncTaskManager.h>
+#include <configVariableInt.h>
+
+#include "alloc_stats.hpp"
+#include "frame_arena.hpp"
+#include "profiler.hpp"
+
+namespace
+{
+    ConfigVariableInt frame_arena_size
+    ("frame-arena-size", 1 << 20,
+     PRC_DESC("Size in bytes of the block the per-frame allocations come from. "
+              "Past it, they fall back to the heap."));
+
+#ifdef ADVENTURE3D_ALLOC_STATS
+    Profiler::Counter heap_allocations_counter("Heap allocations");
+#endif
+    Profiler::Counter arena_bytes_counter("Frame arena bytes");
+}
+
+FrameArena* FrameArena::get_global_ptr()
+{
+    static FrameArena arena;
+    return &arena;
+}
+
+FrameArena::FrameArena()
+    : m_block(NULL),
+    m_capacity(std::max(0, static_cast<int>(frame_arena_size))),
+    m_offset(0),
+    m_live(0),
+    m_allocations(0),
+    m_overflows(0),
+    m_heapAllocationsAtReset(AllocStats::get_counts().allocations),
+    m_leakReported(false)
+{
+    m_block = static_cast<unsigned char*>(::operator new(m_capacity));
+
+    // First thing of the frame, before the game tasks allocate.
+    m_resetTaskPtr = new GenericAsyncTask("frameArenaResetTask", reset_task, this);
+    m_resetTaskPtr->set_sort(-1000);
+    AsyncTaskManager::get_global_ptr()->add(m_resetTaskPtr);
+}
+
+FrameArena::~FrameArena()
+{
+    ::operator delete(m_block);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    // preconditions
+    if (alignment > ALIGNMENT)
+    {
+        nout << "ERROR: frame arena allocations can't be aligned on more than " << ALIGNMENT << " bytes." << std::endl;
+        return NULL;
+    }
+
+    // Every allocation is rounded to ALIGNMENT, so offsets stay aligned.
+    const size_t rounded = (std::max<size_t>(size, 1) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (rounded <= m_capacity)
+    {
+        const size_t offset = m_offset.fetch_add(rounded, std::memory_order_relaxed);
+        if (offset + rounded <= m_capacity)
+        {
+            m_live.fetch_add(1, std::memory_order_relaxed);
+            m_allocations.fetch_add(1, std::memory_order_relaxed);
+            return m_block + offset;
+        }
+    }
+
+    m_overflows.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+
+void FrameArena::deallocate(void* ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    if (owns(ptr))
+    {
+        m_live.fetch_sub(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        ::operator delete(ptr);
+    }
+}
+
+void FrameArena::reset()
+{
+    const size_t used = std::min(m_offset.load(), m_capacity);
+    m_stats.allocations = m_allocations.exchange(0);
+    m_stats.bytes = used;
+    m_stats.overflows = m_overflows.exchange(0);
+    m_stats.peakBytes = std::max(m_stats.peakBytes, used);
+    arena_bytes_counter.set(static_cast<double>(used));
+
+#ifdef ADVENTURE3D_ALLOC_STATS
+    const size_t heapAllocations = AllocStats::get_counts().allocations;
+    m_stats.heapAllocations = heapAllocations - m_heapAllocationsAtReset;
+    m_heapAllocationsAtReset = heapAllocations;
+    heap_allocations_counter.set(static_cast<double>(m_stats.heapAllocations));
+#endif
+
+    // Something kept arena memory past its frame: reusing the block would
+    // overwrite it. Keep bumping; the rest of the frames go to the heap.
+    if (m_live.load() > 0)
+    {
+        if (!m_leakReported)
+        {
+            nout << "ERROR: " << m_live.load() << " frame arena allocations outlived their frame." << std::endl;
+            m_leakReported = true;
+        }
+        return;
+    }
+    m_offset = 0;
+}
+
+size_t FrameArena::get_capacity() const
+{
+    return m_capacity;
+}
+
+FrameArena::Stats FrameArena::get_stats() const
+{
+    return m_stats;
+}
+
+bool FrameArena::owns(const void* ptr) const
+{
+    const unsigned char* bytePtr = static_cast<const unsigned char*>(ptr);
+    return bytePtr >= m_block && bytePtr < m_block + m_capacity;
+}
+
+AsyncTask::DoneStatus FrameArena::reset_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<FrameArena*>(dataPtr)->reset();
+    return AsyncTask::DS_cont;
+}
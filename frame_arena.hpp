@@ -0,0 +1,125 @@
+/*
+ * frame_arena.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * FrameArena module: a bump allocator for allocations that don't outlive
+ * the frame (scratch vectors, temporary strings). Allocating is an atomic
+ * add in one preallocated block, freeing does nothing, and the whole block
+ * is reclaimed at once when the next frame begins. Requests that don't fit
+ * in the block (frame-arena-size) fall back to the heap and are freed
+ * normally.
+ *
+ * FrameAllocator is the matching STL allocator; FrameVector and
+ * FrameString are the containers the game code uses. They must be
+ * destroyed before the end of the frame, which the arena checks: a block
+ * with live allocations is not reclaimed, and the leak is reported.
+ *
+ * Allocating is thread safe, so jobs of the frame may use the arena too.
+ */
+
+#ifndef FRAME_ARENA_HPP_
+#define FRAME_ARENA_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <genericAsyncTask.h>
+
+class FrameArena
+{
+public:
+    struct Stats
+    {
+        size_t allocations = 0;     // from the arena, during the last frame
+        size_t bytes = 0;
+        size_t overflows = 0;       // allocations that fell back to the heap
+        size_t heapAllocations = 0; // all operator new calls of the last frame,
+                                    // with ADVENTURE3D_ALLOC_STATS
+        size_t peakBytes = 0;       // since the start
+    };
+
+    static FrameArena* get_global_ptr();
+
+    // `alignment' is at most alignof(std::max_align_t): the heap fallback
+    // is plain operator new.
+    void* allocate(size_t size, size_t alignment);
+    void deallocate(void* ptr);
+
+    // Reclaims the block; called at the beginning of every frame.
+    void reset();
+
+    size_t get_capacity() const;
+    Stats get_stats() const;
+
+private:
+    FrameArena();
+    ~FrameArena();
+
+    bool owns(const void* ptr) const;
+
+    static AsyncTask::DoneStatus reset_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    FrameArena(const FrameArena&); // to prevent copies
+
+    static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+    unsigned char* m_block;
+    size_t m_capacity;
+    std::atomic<size_t> m_offset;
+    std::atomic<size_t> m_live;             // arena allocations not freed yet
+    std::atomic<size_t> m_allocations;
+    std::atomic<size_t> m_overflows;
+    size_t m_heapAllocationsAtReset;
+    bool m_leakReported;
+    Stats m_stats;
+    PT(GenericAsyncTask) m_resetTaskPtr;
+};
+
+template<typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t), "FrameAllocator doesn't support over-aligned types");
+
+    FrameAllocator() = default;
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>&)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(FrameArena::get_global_ptr()->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        FrameArena::get_global_ptr()->deallocate(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U>&) const
+    {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const FrameAllocator<U>&) const
+    {
+        return false;
+    }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
+
+#endif /* FRAME_ARENA_HPP_ */
@@ -0,0 +1,213 @@
+/*
+ * frame_scheduler.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+
+#include <asyncTaskManager.h>
+#include <clockObject.h>
+#include <configVariableBool.h>
+#include <configVariableDouble.h>
+
+#include "frame_scheduler.hpp"
+
+namespace
+{
+    ConfigVariableDouble frame_budget_ms
+    ("frame-budget-ms", 16.0,
+     PRC_DESC("Frame time the FrameScheduler keeps deferred work within, "
+              "in milliseconds."));
+
+    ConfigVariableBool frame_budget_report
+    ("frame-budget-report", false,
+     PRC_DESC("Print the frames whose work, rendering excluded, goes over "
+              "frame-budget-ms."));
+
+    // Before every other task of the frame, and after the gameplay tasks
+    // but before the text batches (45) and rendering (50).
+    const int BEGIN_FRAME_SORT = -1000;
+    const int RUN_JOBS_SORT = 40;
+    // With igLoop's sort, but a higher priority runs it first.
+    const int END_WORK_SORT = 50;
+    const int END_WORK_PRIORITY = 1;
+}
+
+FrameScheduler* FrameScheduler::get_global_ptr()
+{
+    static FrameScheduler scheduler;
+    return &scheduler;
+}
+
+FrameScheduler::FrameScheduler()
+    : m_nextJobId(0),
+    m_runningJobId(-1),
+    m_runningCancelled(false),
+    m_frameStart(WallClock::now()),
+    m_jobsEnd(m_frameStart),
+    m_workEnd(m_frameStart),
+    m_tailSeconds(0)
+{
+    AsyncTaskManager* taskMgrPtr = AsyncTaskManager::get_global_ptr();
+    m_beginFrameTaskPtr = new GenericAsyncTask("frameSchedulerBeginTask", begin_frame_task, this);
+    m_beginFrameTaskPtr->set_sort(BEGIN_FRAME_SORT);
+    taskMgrPtr->add(m_beginFrameTaskPtr);
+    m_runJobsTaskPtr = new GenericAsyncTask("frameSchedulerJobsTask", run_jobs_task, this);
+    m_runJobsTaskPtr->set_sort(RUN_JOBS_SORT);
+    taskMgrPtr->add(m_runJobsTaskPtr);
+    m_endWorkTaskPtr = new GenericAsyncTask("frameSchedulerEndTask", end_work_task, this);
+    m_endWorkTaskPtr->set_sort(END_WORK_SORT);
+    m_endWorkTaskPtr->set_priority(END_WORK_PRIORITY);
+    taskMgrPtr->add(m_endWorkTaskPtr);
+}
+
+int FrameScheduler::submit(const std::string& name, Job job)
+{
+    // preconditions
+    if (!job)
+    {
+        nout << "ERROR: parameter job cannot be empty." << std::endl;
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PendingJob pending;
+    pending.id = m_nextJobId++;
+    pending.name = name;
+    pending.job = std::move(job);
+    m_jobs.push_back(std::move(pending));
+    return m_jobs.back().id;
+}
+
+void FrameScheduler::cancel(int jobId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (jobId == m_runningJobId)
+    {
+        m_runningCancelled = true;
+    }
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+                                [jobId](const PendingJob& pending) { return pending.id == jobId; }),
+                 m_jobs.end());
+}
+
+bool FrameScheduler::is_pending(int jobId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (jobId == m_runningJobId)
+    {
+        return !m_runningCancelled;
+    }
+    return std::any_of(m_jobs.begin(), m_jobs.end(),
+                       [jobId](const PendingJob& pending) { return pending.id == jobId; });
+}
+
+double FrameScheduler::get_budget_ms() const
+{
+    return frame_budget_ms;
+}
+
+FrameScheduler::Stats FrameScheduler::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.pendingJobs = static_cast<int>(m_jobs.size());
+    return stats;
+}
+
+void FrameScheduler::begin_frame()
+{
+    const WallClock::time_point now = WallClock::now();
+    const double frameSeconds = std::chrono::duration<double>(now - m_frameStart).count();
+    const double workSeconds = std::chrono::duration<double>(m_workEnd - m_frameStart).count();
+    m_frameStart = now;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stats.frames > 0)
+    {
+        m_stats.lastFrameMs = 1000 * frameSeconds;
+        m_stats.worstFrameMs = std::max(m_stats.worstFrameMs, m_stats.lastFrameMs);
+        m_stats.lastWorkMs = 1000 * workSeconds;
+        m_stats.worstWorkMs = std::max(m_stats.worstWorkMs, m_stats.lastWorkMs);
+        if (m_stats.lastWorkMs > frame_budget_ms)
+        {
+            ++m_stats.overruns;
+            if (frame_budget_report)
+            {
+                nout << "frame " << ClockObject::get_global_clock()->get_frame_count() - 1 << ": "
+                     << m_stats.lastWorkMs << " ms of work (" << m_stats.lastFrameMs << " ms in all), over the "
+                     << frame_budget_ms << " ms budget (" << m_stats.lastDeferredMs << " ms of deferred work, "
+                     << m_stats.lastSlices << " slices)" << std::endl;
+            }
+        }
+    }
+    ++m_stats.frames;
+}
+
+void FrameScheduler::run_jobs()
+{
+    const WallClock::time_point start = WallClock::now();
+    const double budgetSeconds = frame_budget_ms / 1000.0;
+    int slices = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const double tailSeconds = m_tailSeconds;
+    while (!m_jobs.empty())
+    {
+        const double usedSeconds = std::chrono::duration<double>(WallClock::now() - m_frameStart).count() + tailSeconds;
+        if (slices > 0 && usedSeconds >= budgetSeconds)
+        {
+            break;
+        }
+
+        // The lock is released while the job runs, so that it may submit
+        // or cancel jobs.
+        PendingJob pending = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        m_runningJobId = pending.id;
+        m_runningCancelled = false;
+        lock.unlock();
+        const bool done = pending.job();
+        ++slices;
+        lock.lock();
+        if (!done && !m_runningCancelled)
+        {
+            m_jobs.push_back(std::move(pending));
+        }
+        m_runningJobId = -1;
+    }
+
+    m_jobsEnd = WallClock::now();
+    m_stats.lastDeferredMs = 1000 * std::chrono::duration<double>(m_jobsEnd - start).count();
+    m_stats.lastSlices = slices;
+}
+
+void FrameScheduler::end_work()
+{
+    m_workEnd = WallClock::now();
+    const double tailSeconds = std::chrono::duration<double>(m_workEnd - m_jobsEnd).count();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The tasks after the jobs vary from frame to frame: a smoothed
+    // estimate keeps the slices steady.
+    m_tailSeconds = m_stats.frames <= 1 ? tailSeconds : 0.9 * m_tailSeconds + 0.1 * tailSeconds;
+}
+
+AsyncTask::DoneStatus FrameScheduler::begin_frame_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<FrameScheduler*>(dataPtr)->begin_frame();
+    return AsyncTask::DS_cont;
+}
+
+AsyncTask::DoneStatus FrameScheduler::run_jobs_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<FrameScheduler*>(dataPtr)->run_jobs();
+    return AsyncTask::DS_cont;
+}
+
+AsyncTask::DoneStatus FrameScheduler::end_work_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<FrameScheduler*>(dataPtr)->end_work();
+    return AsyncTask::DS_cont;
+}
@@ -0,0 +1,101 @@
+/*
+ * frame_scheduler.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * FrameScheduler module: runs deferrable work (loading, spawning, LOD or
+ * text rebuilds) in slices spread over frames, within a frame time budget.
+ * Every frame, after the gameplay tasks and before rendering, jobs are
+ * given slices in turn for as long as the work of the frame, plus that of
+ * the tasks after the jobs in the previous frame, stays under
+ * frame-budget-ms. At least one slice runs every frame, so that deferred
+ * work always progresses.
+ *
+ * The work of a frame runs from its first task to the start of igLoop:
+ * rendering is left out, since the flip waits for the vertical sync there
+ * and would fill any budget below the refresh interval.
+ *
+ * Frames whose work goes over the budget are counted and, with
+ * frame-budget-report, reported along with the time spent in deferred work.
+ */
+
+#ifndef FRAME_SCHEDULER_HPP_
+#define FRAME_SCHEDULER_HPP_
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <genericAsyncTask.h>
+
+class FrameScheduler
+{
+public:
+    // Does a bounded amount of work and returns true once there is none
+    // left, false to be called again, possibly on a later frame. Jobs run
+    // on the main thread.
+    typedef std::function<bool()> Job;
+
+    struct Stats
+    {
+        int frames = 0;
+        int overruns = 0;           // frames over the budget
+        double lastFrameMs = 0;     // wall time, rendering included
+        double worstFrameMs = 0;
+        double lastWorkMs = 0;      // up to rendering, see above
+        double worstWorkMs = 0;
+        double lastDeferredMs = 0;  // spent in jobs during the last frame
+        int lastSlices = 0;
+        int pendingJobs = 0;
+    };
+
+    static FrameScheduler* get_global_ptr();
+
+    // May be called from any thread. Returns an id for cancel().
+    int submit(const std::string& name, Job job);
+    void cancel(int jobId);
+    bool is_pending(int jobId) const;
+
+    double get_budget_ms() const;
+    Stats get_stats() const;
+
+private:
+    struct PendingJob
+    {
+        int id;
+        std::string name;
+        Job job;
+    };
+
+    typedef std::chrono::steady_clock WallClock;
+
+    FrameScheduler();
+
+    void begin_frame();
+    void run_jobs();
+    void end_work();
+
+    static AsyncTask::DoneStatus begin_frame_task(GenericAsyncTask* taskPtr, void* dataPtr);
+    static AsyncTask::DoneStatus run_jobs_task(GenericAsyncTask* taskPtr, void* dataPtr);
+    static AsyncTask::DoneStatus end_work_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    FrameScheduler(const FrameScheduler&); // to prevent copies
+
+    mutable std::mutex m_mutex;
+    std::deque<PendingJob> m_jobs;
+    int m_nextJobId;
+    int m_runningJobId;
+    bool m_runningCancelled;
+    Stats m_stats;
+    WallClock::time_point m_frameStart;
+    WallClock::time_point m_jobsEnd;
+    WallClock::time_point m_workEnd;
+    double m_tailSeconds;           // from the jobs to rendering, smoothed
+    PT(GenericAsyncTask) m_beginFrameTaskPtr;
+    PT(GenericAsyncTask) m_runJobsTaskPtr;
+    PT(GenericAsyncTask) m_endWorkTaskPtr;
+};
+
+#endif /* FRAME_SCHEDULER_HPP_ */
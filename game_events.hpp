@@ -0,0 +1,42 @@
+/*
+ * game_events.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * GameEvents module: the events of the game going through the EventBus.
+ * Input and window events are bridged from their Panda events in
+ * Adventure3D.cpp; the others are published directly.
+ */
+
+#ifndef GAME_EVENTS_HPP_
+#define GAME_EVENTS_HPP_
+
+#include <buttonHandle.h>
+
+class GraphicsWindow;
+
+// An ImGui frame started: widgets can be drawn until the next render.
+struct NewFrameEvent
+{
+};
+
+// A button of the keyboard or the mouse went down or up.
+struct ButtonEvent
+{
+    ButtonHandle button;
+    bool down;
+};
+
+// A character was typed.
+struct KeystrokeEvent
+{
+    wchar_t keycode;
+};
+
+// The window changed: size, focus, minimized...
+struct WindowEvent
+{
+    GraphicsWindow* windowPtr;
+};
+
+#endif /* GAME_EVENTS_HPP_ */
@@ -9,17 +9,16 @@
 #include "genericAsyncTask.h"
 #include "genericFunctionInterval.h"
 
-int GenericFunctionInterval::InstanceCounter = 0;
-
 GenericFunctionInterval::GenericFunctionInterval(const string& name,
                                                  IntervalFunc* functionPtr,
                                                  void* dataPtr,
                                                  bool openEnded)
    : CInterval(name, 0, openEnded),
      m_functionPtr(functionPtr),
-     m_dataPtr(dataPtr)
+     m_dataPtr(dataPtr),
+     m_taskPtr(new GenericAsyncTask("GenericFunctionIntervalTask-" + name, wrapper, this)),
+     m_pendingCalls(0)
    {
-   ++InstanceCounter;
    if(functionPtr == NULL)
       {
       nout << "ERROR: parameter functionPtr cannot be NULL." << endl;
@@ -28,7 +27,11 @@ GenericFunctionInterval::GenericFunctionInterval(const string& name,
 
 GenericFunctionInterval::~GenericFunctionInterval()
    {
-   ;
+   // The task only holds a raw pointer to this interval.
+   if(m_taskPtr->is_alive())
+      {
+      m_taskPtr->remove();
+      }
    }
 
 void GenericFunctionInterval::priv_instant()
@@ -46,9 +49,14 @@ void GenericFunctionInterval::priv_instant()
       //
       //       The truth is I did not try to figure it out, but I rather looked for a
       //       workaround to indirectly ask data to thread2 using an AsyncTask.
-      string taskName("GenericFunctionIntervalTask");
-      taskName += InstanceCounter;
-      AsyncTaskManager::get_global_ptr()->add(new GenericAsyncTask(taskName, wrapper, this));
+      //
+      //       The task is created once: building one (and its name) every time the
+      //       interval fires was a few heap allocations per interval per frame.
+      ++m_pendingCalls;
+      if(!m_taskPtr->is_alive())
+         {
+         AsyncTaskManager::get_global_ptr()->add(m_taskPtr);
+         }
       }
    _state = S_final;
    }
@@ -58,7 +66,12 @@ AsyncTask::DoneStatus GenericFunctionInterval::wrapper(GenericAsyncTask* taskPtr
    if(dataPtr != NULL)
       {
       PT(GenericFunctionInterval) ptr = static_cast<GenericFunctionInterval*>(dataPtr);
-      (*ptr->m_functionPtr)(ptr->m_dataPtr);
+      // Once per time the interval fired since the task last ran.
+      while(ptr->m_pendingCalls > 0)
+         {
+         --ptr->m_pendingCalls;
+         (*ptr->m_functionPtr)(ptr->m_dataPtr);
+         }
       }
    return AsyncTask::DS_done;
    }
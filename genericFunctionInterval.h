@@ -12,6 +12,7 @@
 #define GENERICFUNCTIONINTERVAL_H_
 
 #include "cInterval.h"
+#include "genericAsyncTask.h"
 
 #define Colorf LColorf
 
@@ -36,9 +37,10 @@ class GenericFunctionInterval : public CInterval
 
    static AsyncTask::DoneStatus wrapper(GenericAsyncTask* taskPtr, void* dataPtr);
 
-   static int InstanceCounter;
    IntervalFunc* m_functionPtr;
    void* m_dataPtr;
+   PT(GenericAsyncTask) m_taskPtr;  // reused every time the interval fires
+   int m_pendingCalls;
    };
 
 #endif /* GENERICFUNCTIONINTERVAL_H_ */
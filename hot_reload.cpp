@@ -0,0 +1,478 @@
+/*
+ * hot_reload.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <sstream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <asyncTaskManager.h>
+#include <configVariableBool.h>
+#include <configVariableString.h>
+#include <loader.h>
+#include <textureCollection.h>
+#include <texturePool.h>
+#include <virtualFileSystem.h>
+
+#include "hot_reload.hpp"
+#include "shader_cache.hpp"
+
+namespace
+{
+    ConfigVariableBool hot_reload
+    ("hot-reload", false,
+     PRC_DESC("Reload shaders, models and textures when their files change."));
+
+    ConfigVariableString hot_reload_dirs
+    ("hot-reload-dirs", "shader models",
+     PRC_DESC("Directories watched for hot reload, separated by spaces."));
+
+    // How often the watcher checks for stop(), or polls the directories
+    // where there is no inotify.
+    const int POLL_MS = 250;
+    // Editors save in several steps; reload once a file stays quiet.
+    const int SETTLE_MS = 100;
+
+    std::string get_asset_extension(const Filename& filename)
+    {
+        std::string extension = filename.get_extension();
+        if (extension == "pz" || extension == "gz")
+        {
+            extension = Filename(filename.get_fullpath_wo_extension()).get_extension();
+        }
+        return extension;
+    }
+
+    bool is_shader(const std::string& extension)
+    {
+        return extension == "glsl" || extension == "vert" || extension == "frag";
+    }
+
+    bool is_model(const std::string& extension)
+    {
+        return extension == "egg" || extension == "bam";
+    }
+
+    bool is_image(const std::string& extension)
+    {
+        return extension == "jpg" || extension == "jpeg" || extension == "png" || extension == "tga" ||
+               extension == "bmp" || extension == "dds" || extension == "tif";
+    }
+}
+
+HotReload* HotReload::get_global_ptr()
+{
+    static HotReload hotReload;
+    return &hotReload;
+}
+
+HotReload::HotReload()
+    : m_running(false)
+{
+}
+
+HotReload::~HotReload()
+{
+    stop();
+}
+
+void HotReload::start()
+{
+    if (!hot_reload || m_running)
+    {
+        return;
+    }
+
+    m_dirs.clear();
+    std::istringstream dirs(hot_reload_dirs.get_value());
+    for (std::string dir; dirs >> dir;)
+    {
+        m_dirs.push_back(get_absolute_path(Filename::from_os_specific(dir)));
+    }
+#ifndef __linux__
+    // The first poll only records the timestamps.
+    std::vector<std::string> changed;
+    poll_changes(changed);
+#endif
+
+    // Early in the frame, before anything draws with the old assets.
+    m_swapTaskPtr = new GenericAsyncTask("hotReloadTask", swap_task, this);
+    m_swapTaskPtr->set_sort(-900);
+    AsyncTaskManager::get_global_ptr()->add(m_swapTaskPtr);
+
+    m_running = true;
+    m_thread = std::thread(&HotReload::watch, this);
+}
+
+void HotReload::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    m_running = false;
+    m_thread.join();
+    m_swapTaskPtr->remove();
+    m_swapTaskPtr = NULL;
+}
+
+bool HotReload::is_running() const
+{
+    return m_running;
+}
+
+void HotReload::track_model(NodePath np, const Filename& filename)
+{
+    if (!m_running || np.is_empty())
+    {
+        return;
+    }
+
+    TrackedModel model;
+    model.np = np;
+    model.key = get_model_key(get_absolute_path(filename));
+    for (int k = 0, k_end = np.node()->get_num_children(); k < k_end; ++k)
+    {
+        model.children.push_back(np.node()->get_child(k));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_models.push_back(model);
+}
+
+void HotReload::track_shader(NodePath np, const Filename& vertex, const Filename& fragment)
+{
+    if (!m_running || np.is_empty())
+    {
+        return;
+    }
+
+    TrackedShader shader = { np, vertex, fragment };
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shaders.push_back(shader);
+}
+
+void HotReload::untrack(NodePath np)
+{
+    if (!m_running || np.is_empty())
+    {
+        return;
+    }
+
+    // Note: swaps still pending for these nodes find them gone and are
+    // dropped by apply_swaps().
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_models.erase(std::remove_if(m_models.begin(), m_models.end(), [&np](const TrackedModel& model) {
+        return model.np.is_empty() || model.np == np || np.is_ancestor_of(model.np);
+        }), m_models.end());
+    m_shaders.erase(std::remove_if(m_shaders.begin(), m_shaders.end(), [&np](const TrackedShader& shader) {
+        return shader.np.is_empty() || shader.np == np || np.is_ancestor_of(shader.np);
+        }), m_shaders.end());
+}
+
+void HotReload::watch()
+{
+    std::set<std::string> changed;
+#ifdef __linux__
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        nout << "ERROR: inotify is not available, hot reload is off." << std::endl;
+        return;
+    }
+    std::map<int, std::string> dirsByWatch;
+    for (const std::string& dir : m_dirs)
+    {
+        const int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            nout << "ERROR: unable to watch " << dir << "." << std::endl;
+            continue;
+        }
+        dirsByWatch[wd] = dir;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (m_running)
+    {
+        pollfd pollFd = { fd, POLLIN, 0 };
+        if (poll(&pollFd, 1, changed.empty() ? POLL_MS : SETTLE_MS) > 0)
+        {
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* eventPtr = buffer; eventPtr < buffer + length;)
+                {
+                    const inotify_event* notifyPtr = reinterpret_cast<const inotify_event*>(eventPtr);
+                    if (notifyPtr->len > 0)
+                    {
+                        changed.insert(dirsByWatch[notifyPtr->wd] + "/" + notifyPtr->name);
+                    }
+                    eventPtr += sizeof(inotify_event) + notifyPtr->len;
+                }
+            }
+            continue;
+        }
+
+        for (const std::string& path : changed)
+        {
+            reload(path);
+        }
+        changed.clear();
+    }
+    close(fd);
+#else
+    std::vector<std::string> polled;
+    while (m_running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+        polled.clear();
+        poll_changes(polled);
+        // Reload on the next poll, if the file stayed quiet since.
+        for (const std::string& path : changed)
+        {
+            if (std::find(polled.begin(), polled.end(), path) == polled.end())
+            {
+                reload(path);
+            }
+        }
+        changed.clear();
+        changed.insert(polled.begin(), polled.end());
+    }
+#endif
+}
+
+void HotReload::poll_changes(std::vector<std::string>& changed)
+{
+    for (const std::string& dir : m_dirs)
+    {
+        vector_string names;
+        Filename::from_os_specific(dir).scan_directory(names);
+        for (const std::string& name : names)
+        {
+            const std::string path = dir + "/" + name;
+            const time_t timestamp = Filename::from_os_specific(path).get_timestamp();
+            std::map<std::string, time_t>::iterator it = m_timestamps.find(path);
+            if (it == m_timestamps.end())
+            {
+                m_timestamps[path] = timestamp;
+            }
+            else if (it->second != timestamp)
+            {
+                it->second = timestamp;
+                changed.push_back(path);
+            }
+        }
+    }
+}
+
+void HotReload::reload(const std::string& path)
+{
+    const Filename filename = Filename::from_os_specific(path);
+    const std::string extension = get_asset_extension(filename);
+    std::vector<Swap> swaps;
+
+    if (is_shader(extension))
+    {
+        std::vector<TrackedShader> users;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t k = 0; k < m_shaders.size(); ++k)
+            {
+                if (get_absolute_path(m_shaders[k].vertex) == path || get_absolute_path(m_shaders[k].fragment) == path)
+                {
+                    users.push_back(m_shaders[k]);
+                }
+            }
+        }
+        for (const TrackedShader& user : users)
+        {
+            // Made from the text: Shader::load() would return the shader
+            // it loaded from these files before.
+            std::string vertexText;
+            std::string fragmentText;
+            VirtualFileSystem* vfsPtr = VirtualFileSystem::get_global_ptr();
+            if (!vfsPtr->read_file(user.vertex, vertexText, true) ||
+                !vfsPtr->read_file(user.fragment, fragmentText, true))
+            {
+                continue;
+            }
+            Swap swap;
+            swap.kind = Swap::K_shader;
+            swap.np = user.np;
+            swap.shaderPtr = Shader::make(Shader::SL_GLSL, vertexText, fragmentText);
+            swaps.push_back(swap);
+        }
+    }
+    else if (is_model(extension))
+    {
+        const std::string key = get_model_key(path);
+        std::vector<NodePath> users;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t k = 0; k < m_models.size(); ++k)
+            {
+                if (m_models[k].key == key)
+                {
+                    users.push_back(m_models[k].np);
+                }
+            }
+        }
+        if (!users.empty())
+        {
+            // Not from the model pool or the bam cache, which hold the
+            // old version.
+            LoaderOptions options(LoaderOptions::LF_search | LoaderOptions::LF_report_errors | LoaderOptions::LF_no_cache);
+            PT(PandaNode) nodePtr = Loader::get_global_ptr()->load_sync(filename, options);
+            for (size_t k = 0; nodePtr != NULL && k < users.size(); ++k)
+            {
+                Swap swap;
+                swap.kind = Swap::K_model;
+                swap.np = users[k];
+                swap.nodePtr = k == 0 ? nodePtr : nodePtr->copy_subgraph();
+                swaps.push_back(swap);
+            }
+        }
+    }
+    else if (is_image(extension))
+    {
+        TextureCollection textures = TexturePool::find_all_textures();
+        for (int k = 0, k_end = textures.get_num_textures(); k < k_end; ++k)
+        {
+            Texture* texturePtr = textures.get_texture(k);
+            if (!texturePtr->has_fullpath() || get_absolute_path(texturePtr->get_fullpath()) != path)
+            {
+                continue;
+            }
+            PT(Texture) newTexturePtr = new Texture(texturePtr->get_name());
+            if (newTexturePtr->read(filename))
+            {
+                Swap swap;
+                swap.kind = Swap::K_texture;
+                swap.texturePtr = newTexturePtr;
+                swap.pooledTexturePtr = texturePtr;
+                swaps.push_back(swap);
+            }
+        }
+    }
+
+    if (!swaps.empty())
+    {
+        nout << "hot reload: " << path << std::endl;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_swaps.insert(m_swaps.end(), swaps.begin(), swaps.end());
+    }
+}
+
+void HotReload::apply_swaps()
+{
+    std::vector<Swap> swaps;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_swaps.empty())
+        {
+            return;
+        }
+        swaps.swap(m_swaps);
+    }
+
+    // Everything here only moves pointers: the loading is done, and the
+    // GPU uploads and compiles happen when the frame renders.
+    for (Swap& swap : swaps)
+    {
+        switch (swap.kind)
+        {
+        case Swap::K_model:
+        {
+            // The node may have been untracked since the reload.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = std::find_if(m_models.begin(), m_models.end(), [&swap](const TrackedModel& model) {
+                return model.np == swap.np;
+                });
+            if (it == m_models.end())
+            {
+                break;
+            }
+            TrackedModel& model = *it;
+            PandaNode* parentPtr = model.np.node();
+            for (PandaNode* childPtr : model.children)
+            {
+                parentPtr->remove_child(childPtr);
+            }
+            model.children.clear();
+            for (int k = 0, k_end = swap.nodePtr->get_num_children(); k < k_end; ++k)
+            {
+                model.children.push_back(swap.nodePtr->get_child(k));
+            }
+            parentPtr->steal_children(swap.nodePtr);
+            break;
+        }
+
+        case Swap::K_shader:
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (std::none_of(m_shaders.begin(), m_shaders.end(), [&swap](const TrackedShader& shader) {
+                    return shader.np == swap.np;
+                    }))
+                {
+                    break;
+                }
+            }
+            // The old shader is compiled already: it stays until the new
+            // one is.
+            ShaderCache::get_global_ptr()->set_shader_async(swap.np, swap.shaderPtr, const_cast<Shader*>(swap.np.get_shader()));
+            break;
+        }
+
+        case Swap::K_texture:
+        {
+            Texture* targetPtr = swap.pooledTexturePtr;
+            Texture* sourcePtr = swap.texturePtr;
+            targetPtr->setup_texture(sourcePtr->get_texture_type(), sourcePtr->get_x_size(), sourcePtr->get_y_size(),
+                                     sourcePtr->get_z_size(), sourcePtr->get_component_type(), sourcePtr->get_format());
+            targetPtr->set_ram_image(sourcePtr->get_ram_image(), sourcePtr->get_ram_image_compression());
+            break;
+        }
+        }
+    }
+}
+
+std::string HotReload::get_absolute_path(const Filename& filename)
+{
+    Filename absolute = filename;
+    absolute.make_absolute();
+    return absolute.to_os_specific();
+}
+
+std::string HotReload::get_model_key(const std::string& path)
+{
+    // "models/ring", "models/ring.egg" and "models/ring.egg.pz" are the
+    // same model for the loader.
+    Filename filename = Filename::from_os_specific(path);
+    if (filename.get_extension() == "pz" || filename.get_extension() == "gz")
+    {
+        filename = filename.get_fullpath_wo_extension();
+    }
+    if (is_model(filename.get_extension()))
+    {
+        filename = filename.get_fullpath_wo_extension();
+    }
+    return filename.to_os_specific();
+}
+
+AsyncTask::DoneStatus HotReload::swap_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<HotReload*>(dataPtr)->apply_swaps();
+    return AsyncTask::DS_cont;
+}
@@ -0,0 +1,114 @@
+/*
+ * hot_reload.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * HotReload module: reloads shaders, models and textures when their files
+ * change on disk, without restarting the game. A background thread
+ * watches the hot-reload-dirs (with inotify on Linux, by polling their
+ * timestamps elsewhere) and loads the new version of a changed asset
+ * there. The main thread then swaps it in at the start of a frame:
+ *
+ *  - a shader replaces the one of the nodes tracked with track_shader(),
+ *    through ShaderCache::set_shader_async() with the old shader as the
+ *    fallback, so nothing waits for the compiler;
+ *  - a model replaces the children the tracked node got from its file
+ *    (track_model()), leaving what the game attached to it since;
+ *  - a texture found in the TexturePool gets the new image in place, so
+ *    every node using it follows.
+ *
+ * Enabled with hot-reload; nothing runs otherwise.
+ */
+
+#ifndef HOT_RELOAD_HPP_
+#define HOT_RELOAD_HPP_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <filename.h>
+#include <genericAsyncTask.h>
+#include <nodePath.h>
+#include <shader.h>
+#include <texture.h>
+
+class HotReload
+{
+public:
+    static HotReload* get_global_ptr();
+
+    // Starts watching if hot-reload is set. Main thread.
+    void start();
+    void stop();
+    bool is_running() const;
+
+    // Any thread; does nothing while not running.
+    void track_model(NodePath np, const Filename& filename);
+    void track_shader(NodePath np, const Filename& vertex, const Filename& fragment);
+    // Stops tracking `np' and the nodes under it, before they are removed.
+    void untrack(NodePath np);
+
+private:
+    struct TrackedModel
+    {
+        NodePath np;
+        std::string key;                // see get_model_key()
+        std::vector<PT(PandaNode)> children;    // those that came from the file
+    };
+
+    struct TrackedShader
+    {
+        NodePath np;
+        Filename vertex;
+        Filename fragment;
+    };
+
+    // A new version of an asset, loaded and waiting for the main thread.
+    struct Swap
+    {
+        enum Kind
+        {
+            K_model,
+            K_shader,
+            K_texture
+        };
+
+        Kind kind;
+        NodePath np;                    // K_model and K_shader: the tracked node
+        PT(PandaNode) nodePtr;
+        PT(Shader) shaderPtr;
+        PT(Texture) texturePtr;
+        PT(Texture) pooledTexturePtr;   // K_texture: the one to update
+    };
+
+    HotReload();
+    ~HotReload();
+
+    void watch();
+    void poll_changes(std::vector<std::string>& changed);
+    void reload(const std::string& path);
+    void apply_swaps();
+
+    static std::string get_absolute_path(const Filename& filename);
+    static std::string get_model_key(const std::string& path);
+
+    static AsyncTask::DoneStatus swap_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    HotReload(const HotReload&); // to prevent copies
+
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    std::vector<std::string> m_dirs;    // absolute
+    std::map<std::string, time_t> m_timestamps;     // polling only
+    std::mutex m_mutex;                 // guards the fields below
+    std::vector<TrackedModel> m_models;
+    std::vector<TrackedShader> m_shaders;
+    std::vector<Swap> m_swaps;
+    PT(GenericAsyncTask) m_swapTaskPtr;
+};
+
+#endif /* HOT_RELOAD_HPP_ */
@@ -0,0 +1,417 @@
+/*
+ * input_recorder.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include <asyncTaskManager.h>
+#include <buttonRegistry.h>
+#include <clockObject.h>
+#include <configVariableDouble.h>
+#include <eventHandler.h>
+#include <keyboardButton.h>
+#include <throw_event.h>
+
+#include "input_recorder.hpp"
+
+namespace
+{
+    const char RECORDING_MAGIC[4] = { 'A', '3', 'D', 'I' };
+    // 2: little-endian fixed-width fields, written by Datagram.
+    const unsigned int RECORDING_VERSION = 2;
+
+    ConfigVariableDouble input_replay_dt
+    ("input-replay-dt", 1.0 / 60,
+     PRC_DESC("Timestep of every replayed frame, in seconds, so that replays "
+              "run the same frames whatever the machine that recorded them. "
+              "0 replays the dt of each recorded frame instead."));
+}
+
+InputRecorder* InputRecorder::get_global_ptr()
+{
+    static InputRecorder recorder;
+    return &recorder;
+}
+
+InputRecorder::InputRecorder()
+    : m_mode(M_off),
+    m_mouseInWindow(false),
+    m_mouseX(0),
+    m_mouseY(0),
+    m_frameTime(0),
+    m_frameCount(0),
+    m_replayedFrames(0),
+    m_maxFrameSeconds(0)
+{
+    // Until attach(), the names and modifiers of WindowFramework's
+    // "kb-events" thrower, so that headless replays still fire the
+    // define_key() hooks.
+    m_modifiers.add_button(KeyboardButton::shift());
+    m_modifiers.add_button(KeyboardButton::control());
+    m_modifiers.add_button(KeyboardButton::alt());
+    m_modifiers.add_button(KeyboardButton::meta());
+}
+
+InputRecorder::~InputRecorder()
+{
+    // Note: sysExit() ends the game with exit(), so this is where a
+    // recording is usually flushed.
+    if (m_output.is_open())
+    {
+        m_output.close();
+    }
+}
+
+void InputRecorder::attach(NodePath throwerNp)
+{
+    // preconditions
+    if (throwerNp.is_empty() || !throwerNp.node()->is_of_type(ButtonThrower::get_class_type()))
+    {
+        nout << "ERROR: parameter throwerNp must be a ButtonThrower." << std::endl;
+        return;
+    }
+
+    m_throwerNp = throwerNp;
+    m_throwerPtr = DCAST(ButtonThrower, throwerNp.node());
+    m_modifiers = m_throwerPtr->get_modifier_buttons();
+    m_prefix = m_throwerPtr->get_prefix();
+    m_buttonDownEvent = m_throwerPtr->get_button_down_event();
+    m_buttonUpEvent = m_throwerPtr->get_button_up_event();
+    m_keystrokeEvent = m_throwerPtr->get_keystroke_event();
+
+    EventHandler* handlerPtr = EventHandler::get_global_event_handler();
+    handlerPtr->add_hook(m_throwerPtr->get_button_down_event(), on_button_down, this);
+    handlerPtr->add_hook(m_throwerPtr->get_button_up_event(), on_button_up, this);
+    handlerPtr->add_hook(m_throwerPtr->get_keystroke_event(), on_keystroke, this);
+}
+
+bool InputRecorder::start_recording(const Filename& filename)
+{
+    if (m_mode != M_off)
+    {
+        stop();
+    }
+
+    m_output.open(filename.to_os_specific().c_str(), std::ios::binary | std::ios::trunc);
+    if (!m_output)
+    {
+        nout << "ERROR: unable to create the recording " << filename << "." << std::endl;
+        return false;
+    }
+    Datagram header;
+    header.append_data(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    header.add_uint32(RECORDING_VERSION);
+    write_record(header);
+
+    // Force a mouse record on the first frame.
+    m_mouseInWindow = false;
+    m_mouseX = m_mouseY = -1;
+
+    m_mode = M_recording;
+    m_frameTaskPtr = new GenericAsyncTask("inputRecorderTask", frame_task, this);
+    m_frameTaskPtr->set_sort(-100);
+    AsyncTaskManager::get_global_ptr()->add(m_frameTaskPtr);
+    return true;
+}
+
+bool InputRecorder::start_replay(const Filename& filename)
+{
+    if (m_mode != M_off)
+    {
+        stop();
+    }
+
+    std::ifstream input(filename.to_os_specific().c_str(), std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    m_records.assign(bytes.data(), bytes.size());
+    m_reader = DatagramIterator(m_records);
+
+    if (!has_remaining(sizeof(RECORDING_MAGIC) + 4) ||
+        m_reader.get_fixed_string(sizeof(RECORDING_MAGIC)) != std::string(RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) ||
+        m_reader.get_uint32() != RECORDING_VERSION)
+    {
+        nout << "ERROR: " << filename << " is not an input recording." << std::endl;
+        m_records.clear();
+        return false;
+    }
+
+    // Live input would desynchronize the replay: the ButtonThrower leaves
+    // the data graph until the end, and its events come from the records.
+    if (!m_throwerNp.is_empty())
+    {
+        m_throwerParentNp = m_throwerNp.get_parent();
+        m_throwerNp.detach_node();
+    }
+    m_modifiers.all_buttons_up();
+
+    ClockObject* clockPtr = ClockObject::get_global_clock();
+    m_frameTime = clockPtr->get_frame_time();
+    m_frameCount = clockPtr->get_frame_count();
+    clockPtr->set_mode(ClockObject::M_slave);
+
+    m_replayedFrames = 0;
+    m_maxFrameSeconds = 0;
+    m_replayStart = m_lastFrameStart = WallClock::now();
+
+    m_mode = M_replaying;
+    m_frameTaskPtr = new GenericAsyncTask("inputRecorderTask", frame_task, this);
+    m_frameTaskPtr->set_sort(-100);
+    AsyncTaskManager::get_global_ptr()->add(m_frameTaskPtr);
+    return true;
+}
+
+void InputRecorder::stop()
+{
+    if (m_frameTaskPtr != NULL)
+    {
+        m_frameTaskPtr->remove();
+        m_frameTaskPtr = NULL;
+    }
+
+    if (m_mode == M_recording)
+    {
+        m_output.close();
+    }
+    else if (m_mode == M_replaying)
+    {
+        ClockObject::get_global_clock()->set_mode(ClockObject::M_normal);
+        if (!m_throwerParentNp.is_empty())
+        {
+            m_throwerNp.reparent_to(m_throwerParentNp);
+        }
+        m_records.clear();
+    }
+
+    m_mode = M_off;
+}
+
+InputRecorder::Mode InputRecorder::get_mode() const
+{
+    return m_mode;
+}
+
+void InputRecorder::filter_mouse(bool& inWindow, float& x, float& y)
+{
+    if (m_mode == M_replaying)
+    {
+        inWindow = m_mouseInWindow;
+        x = m_mouseX;
+        y = m_mouseY;
+    }
+    else if (m_mode == M_recording && (inWindow != m_mouseInWindow || x != m_mouseX || y != m_mouseY))
+    {
+        // Only changes are recorded; the mouse rests most of the time.
+        m_mouseInWindow = inWindow;
+        m_mouseX = x;
+        m_mouseY = y;
+
+        Datagram record;
+        record.add_uint8(R_mouse);
+        record.add_uint8(inWindow ? 1 : 0);
+        record.add_float32(x);
+        record.add_float32(y);
+        write_record(record);
+    }
+}
+
+void InputRecorder::begin_frame()
+{
+    if (m_mode == M_recording)
+    {
+        record_frame();
+    }
+    else if (m_mode == M_replaying)
+    {
+        replay_frame();
+    }
+}
+
+void InputRecorder::record_frame()
+{
+    Datagram record;
+    record.add_uint8(R_frame);
+    record.add_float64(ClockObject::get_global_clock()->get_dt());
+    write_record(record);
+}
+
+void InputRecorder::replay_frame()
+{
+    const WallClock::time_point now = WallClock::now();
+    if (m_replayedFrames > 0)
+    {
+        const double frameSeconds = std::chrono::duration<double>(now - m_lastFrameStart).count();
+        m_maxFrameSeconds = std::max(m_maxFrameSeconds, frameSeconds);
+    }
+    m_lastFrameStart = now;
+
+    if (!has_remaining(1 + 8) || m_reader.get_uint8() != R_frame)
+    {
+        finish_replay();
+        return;
+    }
+    const double recordedDt = m_reader.get_float64();
+    const double dt = input_replay_dt > 0 ? static_cast<double>(input_replay_dt) : recordedDt;
+
+    // Every task of this frame sees the same dt.
+    ClockObject* clockPtr = ClockObject::get_global_clock();
+    m_frameTime += dt;
+    ++m_frameCount;
+    clockPtr->set_frame_time(m_frameTime);
+    clockPtr->set_frame_count(m_frameCount);
+    clockPtr->set_dt(dt);
+    ++m_replayedFrames;
+
+    // Then the input of the frame, up to the next frame record.
+    const unsigned char* recordsPtr = static_cast<const unsigned char*>(m_records.get_data());
+    while (has_remaining(1) && recordsPtr[m_reader.get_current_index()] != R_frame)
+    {
+        const unsigned char type = m_reader.get_uint8();
+        switch (type)
+        {
+        case R_button_down:
+        case R_button_up:
+        {
+            const size_t length = has_remaining(2) ? m_reader.get_uint16() : 0;
+            if (length == 0 || !has_remaining(length))
+            {
+                m_reader.skip_bytes(m_reader.get_remaining_size());
+                break;
+            }
+            replay_button(m_reader.get_fixed_string(length), type == R_button_down);
+            break;
+        }
+
+        case R_keystroke:
+        {
+            if (!has_remaining(4))
+            {
+                m_reader.skip_bytes(m_reader.get_remaining_size());
+                break;
+            }
+            const unsigned int keycode = m_reader.get_uint32();
+            if (!m_keystrokeEvent.empty())
+            {
+                throw_event(m_keystrokeEvent, EventParameter(std::wstring(1, (wchar_t)keycode)));
+            }
+            break;
+        }
+
+        case R_mouse:
+        {
+            if (!has_remaining(1 + 4 + 4))
+            {
+                m_reader.skip_bytes(m_reader.get_remaining_size());
+                break;
+            }
+            m_mouseInWindow = m_reader.get_uint8() != 0;
+            m_mouseX = m_reader.get_float32();
+            m_mouseY = m_reader.get_float32();
+            break;
+        }
+
+        default:
+            nout << "ERROR: corrupted input recording." << std::endl;
+            m_reader.skip_bytes(m_reader.get_remaining_size());
+            break;
+        }
+    }
+}
+
+void InputRecorder::finish_replay()
+{
+    const double seconds = std::chrono::duration<double>(m_lastFrameStart - m_replayStart).count();
+    std::cout << "replay: " << m_replayedFrames << " frames in " << seconds << " s, "
+              << (m_replayedFrames > 0 ? 1000 * seconds / m_replayedFrames : 0) << " ms/frame mean, "
+              << 1000 * m_maxFrameSeconds << " ms/frame max" << std::endl;
+
+    stop();
+    throw_event(REPLAY_DONE_EVENT_NAME);
+}
+
+void InputRecorder::replay_button(const std::string& name, bool down)
+{
+    // Throw what ButtonThrower would: the button's own event, prefixed by
+    // the modifiers held, then the generic button event if it has a name.
+    const ButtonHandle button = ButtonRegistry::ptr()->get_button(name);
+    if (down)
+    {
+        throw_event(m_prefix + m_modifiers.get_prefix() + name);
+        m_modifiers.button_down(button);
+        if (!m_buttonDownEvent.empty())
+        {
+            throw_event(m_buttonDownEvent, EventParameter(name));
+        }
+    }
+    else
+    {
+        m_modifiers.button_up(button);
+        throw_event(m_prefix + m_modifiers.get_prefix() + name + "-up");
+        if (!m_buttonUpEvent.empty())
+        {
+            throw_event(m_buttonUpEvent, EventParameter(name));
+        }
+    }
+}
+
+void InputRecorder::write_record(const Datagram& record)
+{
+    m_output.write(static_cast<const char*>(record.get_data()), record.get_length());
+}
+
+bool InputRecorder::has_remaining(size_t size) const
+{
+    return m_reader.get_remaining_size() >= size;
+}
+
+void InputRecorder::on_button_down(const Event* eventPtr, void* dataPtr)
+{
+    InputRecorder* recorderPtr = static_cast<InputRecorder*>(dataPtr);
+    if (recorderPtr->m_mode != M_recording)
+    {
+        return;
+    }
+
+    Datagram record;
+    record.add_uint8(R_button_down);
+    record.add_string(eventPtr->get_parameter(0).get_string_value());
+    recorderPtr->write_record(record);
+}
+
+void InputRecorder::on_button_up(const Event* eventPtr, void* dataPtr)
+{
+    InputRecorder* recorderPtr = static_cast<InputRecorder*>(dataPtr);
+    if (recorderPtr->m_mode != M_recording)
+    {
+        return;
+    }
+
+    Datagram record;
+    record.add_uint8(R_button_up);
+    record.add_string(eventPtr->get_parameter(0).get_string_value());
+    recorderPtr->write_record(record);
+}
+
+void InputRecorder::on_keystroke(const Event* eventPtr, void* dataPtr)
+{
+    InputRecorder* recorderPtr = static_cast<InputRecorder*>(dataPtr);
+    if (recorderPtr->m_mode != M_recording)
+    {
+        return;
+    }
+
+    Datagram record;
+    record.add_uint8(R_keystroke);
+    record.add_uint32(eventPtr->get_parameter(0).get_wstring_value()[0]);
+    recorderPtr->write_record(record);
+}
+
+AsyncTask::DoneStatus InputRecorder::frame_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<InputRecorder*>(dataPtr)->begin_frame();
+    return AsyncTask::DS_cont;
+}
@@ -0,0 +1,123 @@
+/*
+ * input_recorder.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * InputRecorder module: records the player's input (buttons, keystrokes
+ * and mouse position) frame by frame, with the frame dt, into a compact
+ * binary file of little-endian fixed-width fields (Datagram), and replays
+ * it later at a fixed timestep (input-replay-dt), the input of each
+ * recorded frame in one replayed frame, so that a session can be run again
+ * and again, on any machine, to compare frame times across builds.
+ *
+ * While replaying, the keyboard ButtonThrower is detached from the data
+ * graph and its events are thrown from the recording instead, so the
+ * define_key() hooks and the ImGui input see the same events as during the
+ * recording. Without a ButtonThrower (headless runs), the button events
+ * are thrown with the names of WindowFramework's keyboard thrower. The
+ * global clock is put in slave mode and driven by the replay.
+ */
+
+#ifndef INPUT_RECORDER_HPP_
+#define INPUT_RECORDER_HPP_
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include <buttonThrower.h>
+#include <datagram.h>
+#include <datagramIterator.h>
+#include <filename.h>
+#include <genericAsyncTask.h>
+#include <modifierButtons.h>
+#include <nodePath.h>
+
+class InputRecorder
+{
+public:
+    static constexpr const char* REPLAY_DONE_EVENT_NAME = "input-replay-done";
+
+    enum Mode
+    {
+        M_off,
+        M_recording,
+        M_replaying
+    };
+
+    static InputRecorder* get_global_ptr();
+
+    // Follow the button events thrown by `throwerNp', a ButtonThrower whose
+    // button down, button up and keystroke events are already named.
+    void attach(NodePath throwerNp);
+
+    bool start_recording(const Filename& filename);
+    bool start_replay(const Filename& filename);
+    void stop();
+
+    Mode get_mode() const;
+
+    // Called where the mouse is polled: records the live position or, while
+    // replaying, replaces it with the recorded one.
+    void filter_mouse(bool& inWindow, float& x, float& y);
+
+private:
+    enum RecordType
+    {
+        R_frame,            // float64 dt, starts the records of a frame
+        R_button_down,      // uint16 length, button name
+        R_button_up,        // uint16 length, button name
+        R_keystroke,        // uint32 keycode
+        R_mouse             // uint8 in window, float32 x, float32 y
+    };
+
+    InputRecorder();
+    ~InputRecorder();
+
+    void begin_frame();
+    void record_frame();
+    void replay_frame();
+    void finish_replay();
+    void replay_button(const std::string& name, bool down);
+
+    void write_record(const Datagram& record);
+    bool has_remaining(size_t size) const;
+
+    static void on_button_down(const Event* eventPtr, void* dataPtr);
+    static void on_button_up(const Event* eventPtr, void* dataPtr);
+    static void on_keystroke(const Event* eventPtr, void* dataPtr);
+    static AsyncTask::DoneStatus frame_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    InputRecorder(const InputRecorder&); // to prevent copies
+
+    typedef std::chrono::steady_clock WallClock;
+
+    Mode m_mode;
+    NodePath m_throwerNp;
+    NodePath m_throwerParentNp;
+    PT(ButtonThrower) m_throwerPtr;
+    std::string m_prefix;
+    std::string m_buttonDownEvent;          // empty: not thrown
+    std::string m_buttonUpEvent;
+    std::string m_keystrokeEvent;
+    PT(GenericAsyncTask) m_frameTaskPtr;
+
+    // Recording.
+    std::ofstream m_output;
+    bool m_mouseInWindow;
+    float m_mouseX;
+    float m_mouseY;
+
+    // Replay.
+    Datagram m_records;
+    DatagramIterator m_reader;
+    ModifierButtons m_modifiers;
+    double m_frameTime;
+    int m_frameCount;
+    int m_replayedFrames;
+    WallClock::time_point m_replayStart;
+    WallClock::time_point m_lastFrameStart;
+    double m_maxFrameSeconds;
+};
+
+#endif /* INPUT_RECORDER_HPP_ */
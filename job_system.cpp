@@ -0,0 +1,352 @@
+/*
+ * job_system.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+
+#include <asyncTaskManager.h>
+#include <configVariableInt.h>
+
+#include "job_system.hpp"
+
+namespace
+{
+    ConfigVariableInt job_threads
+    ("job-threads", 0,
+     PRC_DESC("Number of threads running game jobs, including the main "
+              "thread. 0 means one per hardware thread."));
+
+    // Just before igLoop (50), so frame jobs are done before cull.
+    const int JOIN_FRAME_SORT = 49;
+
+    // Queue of the current thread, see JobSystem::m_queues.
+    thread_local int t_queueIndex = 0;
+}
+
+JobSystem::Counter::Counter()
+    : m_pending(0)
+{
+}
+
+bool JobSystem::Counter::is_done() const
+{
+    return m_pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem* JobSystem::get_global_ptr()
+{
+    static JobSystem jobSystem;
+    return &jobSystem;
+}
+
+JobSystem::JobSystem()
+    : m_queuedJobs(0),
+    m_quit(false)
+{
+    start_workers(job_threads);
+
+    m_joinTaskPtr = new GenericAsyncTask("jobSystemJoinTask", join_frame_jobs, this);
+    m_joinTaskPtr->set_sort(JOIN_FRAME_SORT);
+    AsyncTaskManager::get_global_ptr()->add(m_joinTaskPtr);
+}
+
+JobSystem::~JobSystem()
+{
+    stop_workers();
+}
+
+void JobSystem::submit(Job job, Counter* counterPtr)
+{
+    // preconditions
+    if (!job)
+    {
+        nout << "ERROR: parameter job cannot be empty." << std::endl;
+        return;
+    }
+
+    if (counterPtr != NULL)
+    {
+        counterPtr->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    JobQueue& queue = *m_queues[t_queueIndex < static_cast<int>(m_queues.size()) ? t_queueIndex : 0];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        QueuedJob queued = { std::move(job), counterPtr };
+        queue.jobs.push_back(std::move(queued));
+    }
+    m_queuedJobs.fetch_add(1, std::memory_order_release);
+
+    if (!m_threads.empty())
+    {
+        // Taking the lock orders the notification after a worker's check of
+        // m_queuedJobs, so that it can't be missed.
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wakeCv.notify_one();
+    }
+}
+
+void JobSystem::submit_frame_job(Job job)
+{
+    submit(std::move(job), &m_frameJobs);
+}
+
+void JobSystem::wait(Counter& counter)
+{
+    while (!counter.is_done())
+    {
+        if (!run_one())
+        {
+            // The last jobs are running on other threads.
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallel_for(int begin, int end, int grain, const std::function<void(int, int)>& body)
+{
+    if (grain < 1)
+    {
+        grain = 1;
+    }
+    if (end - begin <= grain || m_threads.empty())
+    {
+        if (begin < end)
+        {
+            body(begin, end);
+        }
+        return;
+    }
+
+    Counter counter;
+    for (int first = begin; first < end; first += grain)
+    {
+        const int last = std::min(first + grain, end);
+        submit([&body, first, last]() { body(first, last); }, &counter);
+    }
+    wait(counter);
+}
+
+int JobSystem::get_num_threads() const
+{
+    return static_cast<int>(m_threads.size()) + 1;
+}
+
+void JobSystem::set_num_threads(int numThreads)
+{
+    wait(m_frameJobs);
+    stop_workers();
+    start_workers(numThreads > 0 ? numThreads : static_cast<int>(job_threads));
+}
+
+void JobSystem::start_workers(int numThreads)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_quit = false;
+    m_queues.clear();
+    for (int q = 0; q < numThreads; ++q)
+    {
+        m_queues.emplace_back(new JobQueue);
+    }
+    for (int t = 1; t < numThreads; ++t)
+    {
+        m_threads.emplace_back(&JobSystem::work, this, t);
+    }
+}
+
+void JobSystem::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wakeCv.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+bool JobSystem::run_one()
+{
+    // Our own jobs first, newest first: their data is still in cache. Then
+    // the oldest jobs of the others, which are usually the largest.
+    const int numQueues = static_cast<int>(m_queues.size());
+    const int self = t_queueIndex < numQueues ? t_queueIndex : 0;
+    QueuedJob queued;
+    bool found = false;
+    for (int k = 0; k < numQueues && !found; ++k)
+    {
+        JobQueue& queue = *m_queues[(self + k) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            if (k == 0)
+            {
+                queued = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            }
+            else
+            {
+                queued = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    queued.job();
+    if (queued.counterPtr != NULL)
+    {
+        queued.counterPtr->m_pending.fetch_sub(1, std::memory_order_release);
+    }
+    return true;
+}
+
+void JobSystem::work(int queueIndex)
+{
+    t_queueIndex = queueIndex;
+    for (;;)
+    {
+        if (run_one())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeCv.wait(lock, [this]() { return m_quit || m_queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (m_quit)
+        {
+            return;
+        }
+    }
+}
+
+AsyncTask::DoneStatus JobSystem::join_frame_jobs(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    JobSystem* jobSystemPtr = static_cast<JobSystem*>(dataPtr);
+    jobSystemPtr->wait(jobSystemPtr->m_frameJobs);
+    return AsyncTask::DS_cont;
+}
+
+// ************************************************************************************************
+
+int JobGraph::add(JobSystem::Job job)
+{
+    Node node;
+    node.job = std::move(job);
+    node.numPrerequisites = 0;
+    m_nodes.push_back(std::move(node));
+    m_remaining.reset();
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void JobGraph::add_dependency(int job, int prerequisite)
+{
+    // preconditions
+    const int numNodes = static_cast<int>(m_nodes.size());
+    if (job < 0 || job >= numNodes || prerequisite < 0 || prerequisite >= numNodes || job == prerequisite)
+    {
+        nout << "ERROR: invalid dependency " << prerequisite << " -> " << job << "." << std::endl;
+        return;
+    }
+
+    m_nodes[prerequisite].successors.push_back(job);
+    ++m_nodes[job].numPrerequisites;
+    // The new edge may close a cycle: check again on the next run().
+    m_remaining.reset();
+}
+
+bool JobGraph::run()
+{
+    const int numNodes = static_cast<int>(m_nodes.size());
+    if (m_remaining == NULL)
+    {
+        // Check for cycles once per graph: they would never finish.
+        std::vector<int> remaining(numNodes);
+        std::vector<int> ready;
+        for (int n = 0; n < numNodes; ++n)
+        {
+            remaining[n] = m_nodes[n].numPrerequisites;
+            if (remaining[n] == 0)
+            {
+                ready.push_back(n);
+            }
+        }
+        int numSorted = 0;
+        while (!ready.empty())
+        {
+            const int n = ready.back();
+            ready.pop_back();
+            ++numSorted;
+            for (int successor : m_nodes[n].successors)
+            {
+                if (--remaining[successor] == 0)
+                {
+                    ready.push_back(successor);
+                }
+            }
+        }
+        if (numSorted != numNodes)
+        {
+            nout << "ERROR: the job graph has a cycle." << std::endl;
+            return false;
+        }
+        m_remaining.reset(new std::atomic<int>[numNodes]);
+    }
+
+    for (int n = 0; n < numNodes; ++n)
+    {
+        m_remaining[n].store(m_nodes[n].numPrerequisites, std::memory_order_relaxed);
+    }
+
+    JobSystem::Counter counter;
+    for (int n = 0; n < numNodes; ++n)
+    {
+        if (m_nodes[n].numPrerequisites == 0)
+        {
+            launch(n, counter);
+        }
+    }
+    JobSystem::get_global_ptr()->wait(counter);
+    return true;
+}
+
+void JobGraph::clear()
+{
+    m_nodes.clear();
+    m_remaining.reset();
+}
+
+int JobGraph::get_num_jobs() const
+{
+    return static_cast<int>(m_nodes.size());
+}
+
+void JobGraph::launch(int node, JobSystem::Counter& counter)
+{
+    // Successors are submitted before the job counts as done, so `counter'
+    // can't reach 0 while some of the graph is left.
+    JobSystem::get_global_ptr()->submit([this, node, &counter]() {
+        m_nodes[node].job();
+        for (int successor : m_nodes[node].successors)
+        {
+            if (m_remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                launch(successor, counter);
+            }
+        }
+    }, &counter);
+}
@@ -0,0 +1,136 @@
+/*
+ * job_system.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * JobSystem module: spreads game work over all the cores. Every thread has
+ * its own deque of jobs: it pushes and pops at the back, and steals from
+ * the front of the other deques when its own is empty. Threads waiting for
+ * jobs to finish run jobs meanwhile, so waiting inside a job is fine.
+ *
+ * On top of the jobs come parallel_for(), which splits an index range in
+ * chunks, and JobGraph, which runs jobs as soon as the jobs they depend on
+ * are done. Jobs given to submit_frame_job() are joined before cull, by a
+ * task running just before igLoop.
+ *
+ * job-threads sets the number of threads, the main thread included.
+ */
+
+#ifndef JOB_SYSTEM_HPP_
+#define JOB_SYSTEM_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <genericAsyncTask.h>
+
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+
+    // Number of jobs not finished yet, among those submitted with it.
+    class Counter
+    {
+    public:
+        Counter();
+        bool is_done() const;
+
+    private:
+        friend class JobSystem;
+        Counter(const Counter&); // to prevent copies
+
+        std::atomic<int> m_pending;
+    };
+
+    static JobSystem* get_global_ptr();
+
+    // May be called from any thread, jobs included.
+    void submit(Job job, Counter* counterPtr = NULL);
+    // Main thread: the job is joined before cull at the latest.
+    void submit_frame_job(Job job);
+    // Runs jobs until every job of `counter' is done.
+    void wait(Counter& counter);
+    // Runs one queued job on the calling thread; false if there was none.
+    bool run_one();
+
+    // Calls body(first, last) on the chunks of [begin, end), `grain' items
+    // long at most, on all threads. Returns once every chunk is done.
+    void parallel_for(int begin, int end, int grain, const std::function<void(int, int)>& body);
+
+    int get_num_threads() const;
+    // Main thread, with no job in flight. 0 means job-threads.
+    void set_num_threads(int numThreads);
+
+private:
+    struct QueuedJob
+    {
+        Job job;
+        Counter* counterPtr;
+    };
+
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+    };
+
+    JobSystem();
+    ~JobSystem();
+
+    void start_workers(int numThreads);
+    void stop_workers();
+    void work(int queueIndex);
+
+    static AsyncTask::DoneStatus join_frame_jobs(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    JobSystem(const JobSystem&); // to prevent copies
+
+    // Queue 0 belongs to the main thread, and to any thread that is not a
+    // worker; queue k to worker k.
+    std::vector<std::unique_ptr<JobQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_queuedJobs;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCv;
+    bool m_quit;
+    Counter m_frameJobs;
+    PT(GenericAsyncTask) m_joinTaskPtr;
+};
+
+// Jobs with dependencies between them. Jobs without prerequisites start
+// right away, the others as soon as their last prerequisite is done.
+class JobGraph
+{
+public:
+    int add(JobSystem::Job job);
+    // `job' starts after `prerequisite' is done.
+    void add_dependency(int job, int prerequisite);
+
+    // Runs the whole graph and returns once it is done. May be run again.
+    bool run();
+    void clear();
+
+    int get_num_jobs() const;
+
+private:
+    struct Node
+    {
+        JobSystem::Job job;
+        std::vector<int> successors;
+        int numPrerequisites;
+    };
+
+    void launch(int node, JobSystem::Counter& counter);
+
+    std::vector<Node> m_nodes;
+    std::unique_ptr<std::atomic<int>[]> m_remaining;
+};
+
+#endif /* JOB_SYSTEM_HPP_ */
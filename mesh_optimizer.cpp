@@ -0,0 +1,640 @@
+/*
+ * mesh_optimizer.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include <config_putil.h>
+#include <geomTriangles.h>
+#include <geomVertexReader.h>
+#include <geomVertexWriter.h>
+#include <loader.h>
+#include <nodePathCollection.h>
+#include <virtualFileSystem.h>
+
+#include "mesh_optimizer.hpp"
+#include "shader_cache.hpp"
+
+namespace
+{
+    // Set on the quantized GeomNodes: the position offset and scale, then
+    // the texcoord offset and scale, separated by spaces.
+    const char* const QUANTIZATION_TAG = "mesh-quantization";
+
+    const char* const DEFAULT_MODELS[] = { "carousel_base", "carousel_lights", "carousel_panda", "env", "ring" };
+
+    // The extensions the model files of the game come with, tried in order
+    // for a filename without one, as the Loader does.
+    const char* const MODEL_EXTENSIONS[] = { "egg", "egg.pz", "bam" };
+
+    // The file `filename' names, in the current directory or the model
+    // path; NULL if there is none.
+    PT(VirtualFile) find_model_file(const Filename& filename)
+    {
+        VirtualFileSystem* vfsPtr = VirtualFileSystem::get_global_ptr();
+        Filename resolved = filename;
+        if (vfsPtr->exists(resolved) || vfsPtr->resolve_filename(resolved, get_model_path()))
+        {
+            return vfsPtr->get_file(resolved);
+        }
+        return NULL;
+    }
+
+    // Forsyth's vertex scoring.
+    const int SCORING_CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float get_vertex_score(int cachePosition, int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0 && cachePosition < 3)
+        {
+            // The vertices of the last triangle: using them right away
+            // would favor thin strips.
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else if (cachePosition >= 3)
+        {
+            const float scale = 1.0f / (SCORING_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+        // Finish the vertices with few triangles left first.
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    }
+
+    size_t get_vertex_bytes(const GeomVertexData* vdataPtr)
+    {
+        size_t bytes = 0;
+        for (int k = 0, k_end = vdataPtr->get_num_arrays(); k < k_end; ++k)
+        {
+            bytes += vdataPtr->get_array(k)->get_data_size_bytes();
+        }
+        return bytes;
+    }
+
+    size_t get_index_bytes(const Geom* geomPtr)
+    {
+        size_t bytes = 0;
+        for (int k = 0, k_end = geomPtr->get_num_primitives(); k < k_end; ++k)
+        {
+            const GeomPrimitive* primitivePtr = geomPtr->get_primitive(k);
+            if (primitivePtr->is_indexed())
+            {
+                bytes += primitivePtr->get_num_vertices() * primitivePtr->get_index_stride();
+            }
+        }
+        return bytes;
+    }
+
+    // Where the range is flat, any scale decodes it.
+    float get_scale(float minValue, float maxValue, float steps)
+    {
+        return maxValue > minValue ? (maxValue - minValue) / steps : 1.0f;
+    }
+
+    int quantize_value(float value, float offset, float scale, int minValue, int maxValue)
+    {
+        const int quantized = static_cast<int>(std::floor((value - offset) / scale + 0.5f));
+        return std::max(minValue, std::min(quantized, maxValue));
+    }
+}
+
+MeshOptimizer::Stats MeshOptimizer::optimize(NodePath root, bool quantize)
+{
+    Stats stats;
+    NodePathCollection geomNodes = root.find_all_matches("**/+GeomNode");
+    for (int k = 0, k_end = geomNodes.get_num_paths(); k < k_end; ++k)
+    {
+        optimize_node(DCAST(GeomNode, geomNodes.get_path(k).node()), quantize, stats);
+    }
+    return stats;
+}
+
+void MeshOptimizer::setup_decoding(NodePath root)
+{
+    NodePathCollection quantizedNodes = root.find_all_matches(std::string("**/=") + QUANTIZATION_TAG);
+    if (quantizedNodes.get_num_paths() == 0)
+    {
+        return;
+    }
+
+    PT(Shader) shaderPtr = ShaderCache::get_global_ptr()->load(
+        "shader/quantized_mesh.vert.glsl", "shader/quantized_mesh.frag.glsl");
+    if (shaderPtr == NULL)
+    {
+        nout << "ERROR: unable to load the quantized mesh shader." << std::endl;
+        return;
+    }
+
+    for (int k = 0, k_end = quantizedNodes.get_num_paths(); k < k_end; ++k)
+    {
+        NodePath np = quantizedNodes.get_path(k);
+        std::istringstream tag(np.get_tag(QUANTIZATION_TAG));
+        LVecBase3f positionOffset;
+        LVecBase3f positionScale;
+        LVecBase4f texcoordRange;
+        tag >> positionOffset[0] >> positionOffset[1] >> positionOffset[2]
+            >> positionScale[0] >> positionScale[1] >> positionScale[2]
+            >> texcoordRange[0] >> texcoordRange[1] >> texcoordRange[2] >> texcoordRange[3];
+        if (!tag)
+        {
+            nout << "ERROR: bad " << QUANTIZATION_TAG << " tag on " << np << "." << std::endl;
+            continue;
+        }
+        np.set_shader(shaderPtr);
+        np.set_shader_input("position_offset", positionOffset);
+        np.set_shader_input("position_scale", positionScale);
+        np.set_shader_input("texcoord_range", texcoordRange);
+    }
+}
+
+Filename MeshOptimizer::get_optimized_filename(const Filename& filename)
+{
+    // Quantized meshes can't be drawn without their shader. A GSG without
+    // a context yet is assumed to support it, as ShaderCache does.
+    GraphicsStateGuardian* gsgPtr = ShaderCache::get_global_ptr()->get_gsg();
+    if (gsgPtr == NULL || (gsgPtr->is_valid() && !gsgPtr->get_supports_basic_shaders()))
+    {
+        return filename;
+    }
+
+    const Filename optimized = filename.get_fullpath() + ".opt.bam";
+    PT(VirtualFile) optimizedFilePtr = find_model_file(optimized);
+    if (optimizedFilePtr == NULL)
+    {
+        return filename;
+    }
+
+    // A model edited since it was optimized is loaded as is, until
+    // optimize-meshes runs again.
+    PT(VirtualFile) sourceFilePtr;
+    if (!filename.get_extension().empty())
+    {
+        sourceFilePtr = find_model_file(filename);
+    }
+    else
+    {
+        for (const char* extension : MODEL_EXTENSIONS)
+        {
+            sourceFilePtr = find_model_file(filename.get_fullpath() + "." + extension);
+            if (sourceFilePtr != NULL)
+            {
+                break;
+            }
+        }
+    }
+    if (sourceFilePtr != NULL && sourceFilePtr->get_timestamp() > optimizedFilePtr->get_timestamp())
+    {
+        return filename;
+    }
+    return optimizedFilePtr->get_filename();
+}
+
+int MeshOptimizer::run(int argc, char* argv[])
+{
+    std::vector<std::string> models(argv + std::min(argc, 2), argv + argc);
+    if (models.empty())
+    {
+        models.assign(std::begin(DEFAULT_MODELS), std::end(DEFAULT_MODELS));
+    }
+
+    int status = 0;
+    for (const std::string& model : models)
+    {
+        const Filename filename = Filename("models") / model;
+        LoaderOptions options(LoaderOptions::LF_search | LoaderOptions::LF_report_errors | LoaderOptions::LF_no_cache);
+        PT(PandaNode) nodePtr = Loader::get_global_ptr()->load_sync(filename, options);
+        if (nodePtr == NULL)
+        {
+            status = 1;
+            continue;
+        }
+
+        NodePath np(nodePtr);
+        const Stats stats = optimize(np);
+        const Filename optimized = filename.get_fullpath() + ".opt.bam";
+        if (!np.write_bam_file(optimized))
+        {
+            nout << "ERROR: unable to write " << optimized << "." << std::endl;
+            status = 1;
+            continue;
+        }
+
+        // Average cache miss ratio: vertices transformed per triangle.
+        const double triangles = std::max(stats.triangles, 1);
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "%-16s %3d geoms (%d skipped) %7d triangles  vertices %8zu -> %8zu B  indices %8zu -> %8zu B  "
+                 "transforms %7lld -> %7lld (ACMR %.2f -> %.2f)",
+                 model.c_str(), stats.geoms, stats.skippedGeoms, stats.triangles,
+                 stats.vertexBytesBefore, stats.vertexBytesAfter, stats.indexBytesBefore, stats.indexBytesAfter,
+                 stats.transformsBefore, stats.transformsAfter,
+                 stats.transformsBefore / triangles, stats.transformsAfter / triangles);
+        std::cout << line << std::endl;
+    }
+    return status;
+}
+
+std::vector<int> MeshOptimizer::get_cache_order(const std::vector<int>& indices, int numVertices)
+{
+    const int numTriangles = static_cast<int>(indices.size() / 3);
+
+    // The triangles of each vertex, those not emitted yet first.
+    std::vector<int> firstTriangle(numVertices + 1, 0);
+    for (int index : indices)
+    {
+        ++firstTriangle[index + 1];
+    }
+    for (int v = 0; v < numVertices; ++v)
+    {
+        firstTriangle[v + 1] += firstTriangle[v];
+    }
+    std::vector<int> vertexTriangles(indices.size());
+    std::vector<int> remaining(numVertices, 0);
+    for (int t = 0; t < numTriangles; ++t)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const int v = indices[3 * t + c];
+            vertexTriangles[firstTriangle[v] + remaining[v]++] = t;
+        }
+    }
+
+    std::vector<int> cachePositions(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (int v = 0; v < numVertices; ++v)
+    {
+        vertexScores[v] = get_vertex_score(-1, remaining[v]);
+    }
+    std::vector<float> triangleScores(numTriangles);
+    int best = -1;
+    for (int t = 0; t < numTriangles; ++t)
+    {
+        triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+        if (best < 0 || triangleScores[t] > triangleScores[best])
+        {
+            best = t;
+        }
+    }
+
+    std::vector<char> emitted(numTriangles, 0);
+    std::vector<int> order;
+    order.reserve(numTriangles);
+    std::vector<int> cache;
+    std::vector<int> newCache;
+    int nextUnemitted = 0;
+    while (static_cast<int>(order.size()) < numTriangles)
+    {
+        if (best < 0)
+        {
+            // Nothing left around the cache: start anew elsewhere.
+            while (emitted[nextUnemitted])
+            {
+                ++nextUnemitted;
+            }
+            best = nextUnemitted;
+        }
+
+        emitted[best] = 1;
+        order.push_back(best);
+
+        newCache.clear();
+        for (int c = 0; c < 3; ++c)
+        {
+            const int v = indices[3 * best + c];
+            newCache.push_back(v);
+            int* trianglesPtr = &vertexTriangles[firstTriangle[v]];
+            std::swap(*std::find(trianglesPtr, trianglesPtr + remaining[v], best), trianglesPtr[remaining[v] - 1]);
+            --remaining[v];
+        }
+        for (int v : cache)
+        {
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+            {
+                newCache.push_back(v);
+            }
+        }
+
+        // Rescore the vertices of the cache, and those just evicted, then
+        // their triangles.
+        for (size_t k = 0; k < newCache.size(); ++k)
+        {
+            const int v = newCache[k];
+            cachePositions[v] = static_cast<int>(k) < SCORING_CACHE_SIZE ? static_cast<int>(k) : -1;
+            vertexScores[v] = get_vertex_score(cachePositions[v], remaining[v]);
+        }
+        best = -1;
+        float bestScore = -1.0f;
+        for (int v : newCache)
+        {
+            for (int k = firstTriangle[v], k_end = firstTriangle[v] + remaining[v]; k < k_end; ++k)
+            {
+                const int t = vertexTriangles[k];
+                const float score = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+        if (static_cast<int>(newCache.size()) > SCORING_CACHE_SIZE)
+        {
+            newCache.resize(SCORING_CACHE_SIZE);
+        }
+        cache.swap(newCache);
+    }
+    return order;
+}
+
+long long MeshOptimizer::count_transforms(const std::vector<int>& indices, int cacheSize)
+{
+    std::deque<int> cache;
+    long long transforms = 0;
+    for (int index : indices)
+    {
+        if (std::find(cache.begin(), cache.end(), index) == cache.end())
+        {
+            ++transforms;
+            cache.push_back(index);
+            if (static_cast<int>(cache.size()) > cacheSize)
+            {
+                cache.pop_front();
+            }
+        }
+    }
+    return transforms;
+}
+
+bool MeshOptimizer::optimize_node(GeomNode* geomNodePtr, bool quantize, Stats& stats)
+{
+    // All the Geoms of the node share one range, so that one set of shader
+    // inputs decodes them. It needs them all quantized, normals included.
+    Range range;
+    range.minPosition = LPoint3f(std::numeric_limits<float>::max());
+    range.maxPosition = LPoint3f(-std::numeric_limits<float>::max());
+    range.minTexcoord = LPoint2f(std::numeric_limits<float>::max());
+    range.maxTexcoord = LPoint2f(-std::numeric_limits<float>::max());
+    std::vector<int> indices;
+    for (int k = 0, k_end = geomNodePtr->get_num_geoms(); k < k_end && quantize; ++k)
+    {
+        const Geom* geomPtr = geomNodePtr->get_geom(k);
+        indices.clear();
+        quantize = can_optimize(geomPtr) && get_triangles(geomPtr, indices) &&
+                   geomPtr->get_vertex_data()->has_column(InternalName::get_normal());
+        if (quantize)
+        {
+            grow_range(geomPtr, range);
+        }
+    }
+
+    for (int k = 0, k_end = geomNodePtr->get_num_geoms(); k < k_end; ++k)
+    {
+        ++stats.geoms;
+        const Geom* geomPtr = geomNodePtr->get_geom(k);
+        PT(Geom) newGeomPtr = can_optimize(geomPtr) ? optimize_geom(geomPtr, quantize ? &range : NULL, stats) : NULL;
+        if (newGeomPtr == NULL)
+        {
+            ++stats.skippedGeoms;
+            continue;
+        }
+        geomNodePtr->set_geom(k, newGeomPtr);
+    }
+
+    if (quantize && geomNodePtr->get_num_geoms() > 0)
+    {
+        const LPoint3f positionOffset = (range.minPosition + range.maxPosition) / 2;
+        std::ostringstream tag;
+        tag.precision(9);
+        tag << positionOffset[0] << ' ' << positionOffset[1] << ' ' << positionOffset[2];
+        for (int c = 0; c < 3; ++c)
+        {
+            tag << ' ' << get_scale(range.minPosition[c], range.maxPosition[c], 65534.0f);
+        }
+        tag << ' ' << range.minTexcoord[0] << ' ' << range.minTexcoord[1];
+        for (int c = 0; c < 2; ++c)
+        {
+            tag << ' ' << get_scale(range.minTexcoord[c], range.maxTexcoord[c], 65535.0f);
+        }
+        geomNodePtr->set_tag(QUANTIZATION_TAG, tag.str());
+    }
+    return quantize;
+}
+
+PT(Geom) MeshOptimizer::optimize_geom(const Geom* geomPtr, const Range* rangePtr, Stats& stats)
+{
+    std::vector<int> indices;
+    if (!get_triangles(geomPtr, indices) || indices.empty())
+    {
+        return NULL;
+    }
+
+    const GeomVertexData* vdataPtr = geomPtr->get_vertex_data();
+    const int numVertices = vdataPtr->get_num_rows();
+    const std::vector<int> order = get_cache_order(indices, numVertices);
+
+    // Vertices in the order of their first use; unused ones are dropped.
+    std::vector<int> newVertexOf(numVertices, -1);
+    std::vector<int> oldVertexOf;
+    std::vector<int> newIndices;
+    newIndices.reserve(indices.size());
+    for (int t : order)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const int v = indices[3 * t + c];
+            if (newVertexOf[v] < 0)
+            {
+                newVertexOf[v] = static_cast<int>(oldVertexOf.size());
+                oldVertexOf.push_back(v);
+            }
+            newIndices.push_back(newVertexOf[v]);
+        }
+    }
+    const int numNewVertices = static_cast<int>(oldVertexOf.size());
+
+    CPT(GeomVertexFormat) formatPtr = rangePtr != NULL ? get_quantized_format(vdataPtr->get_format()) : vdataPtr->get_format();
+    PT(GeomVertexData) newVdataPtr = new GeomVertexData(vdataPtr->get_name(), formatPtr, Geom::UH_static);
+    newVdataPtr->unclean_set_num_rows(numNewVertices);
+
+    LVecBase3f positionOffset;
+    LVecBase3f positionScale;
+    if (rangePtr != NULL)
+    {
+        positionOffset = (rangePtr->minPosition + rangePtr->maxPosition) / 2;
+        for (int c = 0; c < 3; ++c)
+        {
+            positionScale[c] = get_scale(rangePtr->minPosition[c], rangePtr->maxPosition[c], 65534.0f);
+        }
+    }
+
+    for (int a = 0, a_end = formatPtr->get_num_arrays(); a < a_end; ++a)
+    {
+        const GeomVertexArrayFormat* arrayPtr = formatPtr->get_array(a);
+        for (int k = 0, k_end = arrayPtr->get_num_columns(); k < k_end; ++k)
+        {
+            const InternalName* namePtr = arrayPtr->get_column(k)->get_name();
+            GeomVertexReader reader(vdataPtr, namePtr);
+            GeomVertexWriter writer(newVdataPtr, namePtr);
+            for (int v = 0; v < numNewVertices; ++v)
+            {
+                reader.set_row(oldVertexOf[v]);
+                if (rangePtr != NULL && namePtr == InternalName::get_vertex())
+                {
+                    const LPoint3f position = reader.get_data3f();
+                    writer.set_data3i(quantize_value(position[0], positionOffset[0], positionScale[0], -32767, 32767),
+                                      quantize_value(position[1], positionOffset[1], positionScale[1], -32767, 32767),
+                                      quantize_value(position[2], positionOffset[2], positionScale[2], -32767, 32767));
+                }
+                else if (rangePtr != NULL && namePtr == InternalName::get_normal())
+                {
+                    LVector3f normal = reader.get_data3f();
+                    normal.normalize();
+                    writer.set_data3i(quantize_value(normal[0], 0, 1.0f / 127, -127, 127),
+                                      quantize_value(normal[1], 0, 1.0f / 127, -127, 127),
+                                      quantize_value(normal[2], 0, 1.0f / 127, -127, 127));
+                }
+                else if (rangePtr != NULL && namePtr == InternalName::get_texcoord())
+                {
+                    const LPoint2f texcoord = reader.get_data2f();
+                    const float scaleU = get_scale(rangePtr->minTexcoord[0], rangePtr->maxTexcoord[0], 65535.0f);
+                    const float scaleV = get_scale(rangePtr->minTexcoord[1], rangePtr->maxTexcoord[1], 65535.0f);
+                    writer.set_data2i(quantize_value(texcoord[0], rangePtr->minTexcoord[0], scaleU, 0, 65535),
+                                      quantize_value(texcoord[1], rangePtr->minTexcoord[1], scaleV, 0, 65535));
+                }
+                else
+                {
+                    writer.set_data4f(reader.get_data4f());
+                }
+            }
+        }
+    }
+
+    PT(GeomTriangles) trianglesPtr = new GeomTriangles(Geom::UH_static);
+    trianglesPtr->set_index_type(numNewVertices <= 0xffff ? GeomEnums::NT_uint16 : GeomEnums::NT_uint32);
+    trianglesPtr->reserve_num_vertices(static_cast<int>(newIndices.size()));
+    for (size_t k = 0; k < newIndices.size(); k += 3)
+    {
+        trianglesPtr->add_vertices(newIndices[k], newIndices[k + 1], newIndices[k + 2]);
+    }
+
+    PT(Geom) newGeomPtr = new Geom(newVdataPtr);
+    newGeomPtr->add_primitive(trianglesPtr);
+    // Computed from quantized positions, the bounds would be wrong.
+    newGeomPtr->set_bounds(geomPtr->get_bounds());
+
+    stats.triangles += static_cast<int>(newIndices.size() / 3);
+    stats.vertexBytesBefore += get_vertex_bytes(vdataPtr);
+    stats.vertexBytesAfter += get_vertex_bytes(newVdataPtr);
+    stats.indexBytesBefore += get_index_bytes(geomPtr);
+    stats.indexBytesAfter += get_index_bytes(newGeomPtr);
+    stats.transformsBefore += count_transforms(indices);
+    stats.transformsAfter += count_transforms(newIndices);
+    return newGeomPtr;
+}
+
+bool MeshOptimizer::get_triangles(const Geom* geomPtr, std::vector<int>& indices)
+{
+    for (int k = 0, k_end = geomPtr->get_num_primitives(); k < k_end; ++k)
+    {
+        const GeomPrimitive* primitivePtr = geomPtr->get_primitive(k);
+        if (primitivePtr->get_primitive_type() != GeomEnums::PT_polygons)
+        {
+            return false;
+        }
+        CPT(GeomPrimitive) trianglesPtr = primitivePtr->decompose();
+        for (int v = 0, v_end = trianglesPtr->get_num_vertices(); v < v_end; ++v)
+        {
+            indices.push_back(trianglesPtr->get_vertex(v));
+        }
+    }
+    return true;
+}
+
+bool MeshOptimizer::can_optimize(const Geom* geomPtr)
+{
+    const GeomVertexData* vdataPtr = geomPtr->get_vertex_data();
+    return vdataPtr->get_format()->get_animation().get_animation_type() == GeomEnums::AT_none &&
+           vdataPtr->get_transform_blend_table() == NULL && vdataPtr->get_slider_table() == NULL &&
+           vdataPtr->has_column(InternalName::get_vertex());
+}
+
+void MeshOptimizer::grow_range(const Geom* geomPtr, Range& range)
+{
+    const GeomVertexData* vdataPtr = geomPtr->get_vertex_data();
+    GeomVertexReader positions(vdataPtr, InternalName::get_vertex());
+    while (!positions.is_at_end())
+    {
+        const LPoint3f position = positions.get_data3f();
+        for (int c = 0; c < 3; ++c)
+        {
+            range.minPosition[c] = std::min(range.minPosition[c], position[c]);
+            range.maxPosition[c] = std::max(range.maxPosition[c], position[c]);
+        }
+    }
+    if (!vdataPtr->has_column(InternalName::get_texcoord()))
+    {
+        return;
+    }
+    GeomVertexReader texcoords(vdataPtr, InternalName::get_texcoord());
+    while (!texcoords.is_at_end())
+    {
+        const LPoint2f texcoord = texcoords.get_data2f();
+        for (int c = 0; c < 2; ++c)
+        {
+            range.minTexcoord[c] = std::min(range.minTexcoord[c], texcoord[c]);
+            range.maxTexcoord[c] = std::max(range.maxTexcoord[c], texcoord[c]);
+        }
+    }
+}
+
+CPT(GeomVertexFormat) MeshOptimizer::get_quantized_format(const GeomVertexFormat* formatPtr)
+{
+    // One interleaved array: int16 positions, int8 normals, uint16
+    // texcoords; the other columns as they were.
+    PT(GeomVertexArrayFormat) arrayPtr = new GeomVertexArrayFormat;
+    for (int a = 0, a_end = formatPtr->get_num_arrays(); a < a_end; ++a)
+    {
+        const GeomVertexArrayFormat* sourcePtr = formatPtr->get_array(a);
+        for (int k = 0, k_end = sourcePtr->get_num_columns(); k < k_end; ++k)
+        {
+            const GeomVertexColumn* columnPtr = sourcePtr->get_column(k);
+            InternalName* namePtr = columnPtr->get_name();
+            if (namePtr == InternalName::get_vertex())
+            {
+                arrayPtr->add_column(namePtr, 3, GeomEnums::NT_int16, GeomEnums::C_point);
+            }
+            else if (namePtr == InternalName::get_normal())
+            {
+                arrayPtr->add_column(namePtr, 3, GeomEnums::NT_int8, GeomEnums::C_normal);
+            }
+            else if (namePtr == InternalName::get_texcoord())
+            {
+                arrayPtr->add_column(namePtr, 2, GeomEnums::NT_uint16, GeomEnums::C_texcoord);
+            }
+            else
+            {
+                arrayPtr->add_column(namePtr, columnPtr->get_num_components(), columnPtr->get_numeric_type(),
+                                     columnPtr->get_contents());
+            }
+        }
+    }
+    return GeomVertexFormat::register_format(arrayPtr);
+}
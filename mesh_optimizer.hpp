@@ -0,0 +1,89 @@
+/*
+ * mesh_optimizer.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * MeshOptimizer module: the offline optimization of the static meshes,
+ * run as
+ *
+ *    Adventure3D optimize-meshes [model...]
+ *
+ * which writes models/<model>.opt.bam next to each model. For every Geom,
+ * the triangles are reordered for the post-transform vertex cache (Tom
+ * Forsyth's linear-speed algorithm), then the vertices in the order the
+ * triangles first use them. Positions are quantized to int16 within the
+ * bounds of their GeomNode, normals to int8 and texcoords to uint16 within
+ * their range; the quantized_mesh shader decodes them, with the ranges set
+ * by setup_decoding() from a tag of the GeomNode.
+ *
+ * Animated vertex data is left alone. The report compares the vertex and
+ * index bytes and the vertices transformed through a 32 entry FIFO cache.
+ */
+
+#ifndef MESH_OPTIMIZER_HPP_
+#define MESH_OPTIMIZER_HPP_
+
+#include <vector>
+
+#include <geom.h>
+#include <geomNode.h>
+#include <nodePath.h>
+
+class MeshOptimizer
+{
+public:
+    struct Stats
+    {
+        int geoms = 0;
+        int skippedGeoms = 0;       // animated or without triangles
+        int triangles = 0;
+        size_t vertexBytesBefore = 0;
+        size_t vertexBytesAfter = 0;
+        size_t indexBytesBefore = 0;
+        size_t indexBytesAfter = 0;
+        long long transformsBefore = 0;     // FIFO cache misses
+        long long transformsAfter = 0;
+    };
+
+    // Optimizes the Geoms below `root' in place.
+    static Stats optimize(NodePath root, bool quantize = true);
+
+    // Sets the decoding shader and its inputs on the quantized GeomNodes
+    // below `root'. Any thread, before `root' is rendered.
+    static void setup_decoding(NodePath root);
+
+    // Returns `filename'.opt.bam if it exists, is not older than the model
+    // it was made from, and the GSG runs the decoding shader; else
+    // `filename'. Any thread, after ShaderCache::set_gsg().
+    static Filename get_optimized_filename(const Filename& filename);
+
+    // "optimize-meshes [model...]"; returns the process exit status.
+    static int run(int argc, char* argv[]);
+
+    // Triangle order for the vertex cache, as indices into `indices'
+    // triangles.
+    static std::vector<int> get_cache_order(const std::vector<int>& indices, int numVertices);
+
+    // Vertices transformed by a FIFO post-transform cache of `cacheSize'.
+    static long long count_transforms(const std::vector<int>& indices, int cacheSize = 32);
+
+private:
+    struct Range
+    {
+        LPoint3f minPosition;
+        LPoint3f maxPosition;
+        LPoint2f minTexcoord;
+        LPoint2f maxTexcoord;
+    };
+
+    static bool optimize_node(GeomNode* geomNodePtr, bool quantize, Stats& stats);
+    static PT(Geom) optimize_geom(const Geom* geomPtr, const Range* rangePtr, Stats& stats);
+    static bool get_triangles(const Geom* geomPtr, std::vector<int>& indices);
+    static bool can_optimize(const Geom* geomPtr);
+    static void grow_range(const Geom* geomPtr, Range& range);
+    static CPT(GeomVertexFormat) get_quantized_format(const GeomVertexFormat* formatPtr);
+
+    MeshOptimizer(); // to prevent instances
+};
+
+#endif /* MESH_OPTIMIZER_HPP_ */
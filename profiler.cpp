@@ -0,0 +1,331 @@
+/*
+ * profiler.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+
+#include <asyncTaskManager.h>
+#include <configVariableBool.h>
+
+#include <imgui.h>
+
+#include "event_bus.hpp"
+#include "game_events.hpp"
+#include "profiler.hpp"
+
+namespace
+{
+    ConfigVariableBool profiler_panel
+    ("profiler-panel", false,
+     PRC_DESC("Show the profiler panel at startup. F3 toggles it; nothing is "
+              "recorded while it is hidden."));
+
+    const float FLAME_ROW_HEIGHT = 18;
+
+    // The last component of a PStats name.
+    const char* get_label(const std::string& name)
+    {
+        const size_t colon = name.rfind(':');
+        return name.c_str() + (colon == std::string::npos ? 0 : colon + 1);
+    }
+}
+
+Profiler::Section::Section(const std::string& name)
+    : m_collector(name),
+    m_name(name),
+    m_nanoseconds(0),
+    m_history(HISTORY_SIZE, 0.0f)
+{
+    Profiler::get_global_ptr()->register_section(this);
+}
+
+Profiler::Timer::Timer(Section& section)
+    : m_pstatTimer(section.m_collector),
+    m_sectionPtr(NULL)
+{
+    if (Profiler::get_global_ptr()->is_enabled())
+    {
+        m_sectionPtr = &section;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+Profiler::Timer::~Timer()
+{
+    if (m_sectionPtr != NULL)
+    {
+        const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+        m_sectionPtr->m_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+}
+
+Profiler::Counter::Counter(const std::string& name)
+    : m_collector(name),
+    m_name(name),
+    m_value(0),
+    m_history(HISTORY_SIZE, 0.0f)
+{
+    Profiler::get_global_ptr()->register_counter(this);
+}
+
+void Profiler::Counter::set(double value)
+{
+    m_collector.set_level(value);
+    m_value = value;
+}
+
+Profiler* Profiler::get_global_ptr()
+{
+    static Profiler profiler;
+    return &profiler;
+}
+
+Profiler::Profiler()
+    : m_enabled(false),
+    m_frameHistory(HISTORY_SIZE, 0.0f),
+    m_historyIndex(0),
+    m_recordedFrames(0)
+{
+    // Note: sections and counters register from static initializers, so
+    // nothing here may depend on Panda being initialized.
+}
+
+void Profiler::init()
+{
+    set_enabled(profiler_panel);
+}
+
+void Profiler::set_enabled(bool enabled)
+{
+    if (enabled == m_enabled)
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        // Start with an empty history.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (Section* sectionPtr : m_sections)
+            {
+                sectionPtr->m_nanoseconds = 0;
+                std::fill(sectionPtr->m_history.begin(), sectionPtr->m_history.end(), 0.0f);
+            }
+            for (Counter* counterPtr : m_counters)
+            {
+                std::fill(counterPtr->m_history.begin(), counterPtr->m_history.end(), 0.0f);
+            }
+        }
+        std::fill(m_frameHistory.begin(), m_frameHistory.end(), 0.0f);
+        m_historyIndex = 0;
+        m_recordedFrames = 0;
+        m_frameStart = std::chrono::steady_clock::now();
+
+        m_frameTaskPtr = new GenericAsyncTask("profilerFrameTask", frame_task, this);
+        m_frameTaskPtr->set_sort(-1000);
+        AsyncTaskManager::get_global_ptr()->add(m_frameTaskPtr);
+        EventBus::subscribe<NewFrameEvent>(on_new_frame, this);
+    }
+    else
+    {
+        m_frameTaskPtr->remove();
+        m_frameTaskPtr = NULL;
+        EventBus::unsubscribe<NewFrameEvent>(on_new_frame, this);
+    }
+    m_enabled = enabled;
+}
+
+bool Profiler::is_enabled() const
+{
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::toggle(const Event* eventPtr, void* dataPtr)
+{
+    Profiler* profilerPtr = Profiler::get_global_ptr();
+    profilerPtr->set_enabled(!profilerPtr->is_enabled());
+}
+
+void Profiler::register_section(Section* sectionPtr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sections.push_back(sectionPtr);
+    // Sorted by name, parents come before their children.
+    std::sort(m_sections.begin(), m_sections.end(),
+              [](const Section* a, const Section* b) { return a->m_name < b->m_name; });
+}
+
+void Profiler::register_counter(Counter* counterPtr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters.push_back(counterPtr);
+}
+
+void Profiler::end_frame()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    m_frameHistory[m_historyIndex] = std::chrono::duration<float, std::milli>(now - m_frameStart).count();
+    m_frameStart = now;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Section* sectionPtr : m_sections)
+    {
+        sectionPtr->m_history[m_historyIndex] = sectionPtr->m_nanoseconds.exchange(0) / 1.0e6f;
+    }
+    for (Counter* counterPtr : m_counters)
+    {
+        counterPtr->m_history[m_historyIndex] = static_cast<float>(counterPtr->m_value.load());
+    }
+    m_historyIndex = (m_historyIndex + 1) % HISTORY_SIZE;
+    if (m_recordedFrames < HISTORY_SIZE)
+    {
+        ++m_recordedFrames;
+    }
+}
+
+void Profiler::draw_panel()
+{
+    ImGui::SetNextWindowSize(ImVec2(440, 520), ImGuiCond_FirstUseEver);
+    bool open = true;
+    const bool visible = ImGui::Begin("Profiler", &open);
+    if (visible)
+    {
+        char overlay[64];
+        const int lastIndex = (m_historyIndex + HISTORY_SIZE - 1) % HISTORY_SIZE;
+        const float frameMs = get_mean(m_frameHistory);
+        snprintf(overlay, sizeof(overlay), "%.2f ms, mean %.2f ms", m_frameHistory[lastIndex], frameMs);
+        ImGui::Text("Frame");
+        ImGui::PlotLines("##frame", m_frameHistory.data(), HISTORY_SIZE, m_historyIndex, overlay, 0, FLT_MAX, ImVec2(0, 48));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (ImGui::CollapsingHeader("Breakdown", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            draw_flame(frameMs);
+        }
+        if (ImGui::CollapsingHeader("Sections", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            for (Section* sectionPtr : m_sections)
+            {
+                snprintf(overlay, sizeof(overlay), "%.3f ms, mean %.3f ms",
+                         sectionPtr->m_history[lastIndex], get_mean(sectionPtr->m_history));
+                ImGui::Text("%s", sectionPtr->m_name.c_str());
+                ImGui::PushID(sectionPtr);
+                ImGui::PlotHistogram("##section", sectionPtr->m_history.data(), HISTORY_SIZE, m_historyIndex,
+                                     overlay, 0, FLT_MAX, ImVec2(0, 32));
+                ImGui::PopID();
+            }
+        }
+        if (ImGui::CollapsingHeader("Counters", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            for (Counter* counterPtr : m_counters)
+            {
+                snprintf(overlay, sizeof(overlay), "%.0f", counterPtr->m_history[lastIndex]);
+                ImGui::Text("%s", counterPtr->m_name.c_str());
+                ImGui::PushID(counterPtr);
+                ImGui::PlotLines("##counter", counterPtr->m_history.data(), HISTORY_SIZE, m_historyIndex,
+                                 overlay, 0, FLT_MAX, ImVec2(0, 32));
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::End();
+
+    if (!open)
+    {
+        set_enabled(false);
+    }
+}
+
+void Profiler::draw_flame(float frameMs)
+{
+    // One row per nesting level, the frame on top: each section is drawn
+    // under its nearest registered ancestor, after its previous siblings,
+    // as wide as its mean share of the frame.
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    ImDrawList* drawListPtr = ImGui::GetWindowDrawList();
+
+    struct Bar
+    {
+        float x;
+        float cursor;           // where the next child goes
+        int depth;
+    };
+    std::vector<Bar> bars(m_sections.size());
+    Bar frameBar = { 0, 0, 0 };
+    int maxDepth = 0;
+    char label[64];
+
+    drawListPtr->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + FLAME_ROW_HEIGHT - 1), IM_COL32(90, 90, 90, 255));
+    snprintf(label, sizeof(label), "frame %.2f ms", frameMs);
+    drawListPtr->AddText(ImVec2(origin.x + 2, origin.y + 2), IM_COL32_WHITE, label);
+
+    for (size_t k = 0; k < m_sections.size(); ++k)
+    {
+        const std::string& name = m_sections[k]->m_name;
+        Bar* parentPtr = &frameBar;
+        for (size_t j = k; j-- > 0;)
+        {
+            const std::string& other = m_sections[j]->m_name;
+            if (name.size() > other.size() && name.compare(0, other.size(), other) == 0 && name[other.size()] == ':')
+            {
+                parentPtr = &bars[j];
+                break;
+            }
+        }
+
+        const float ms = get_mean(m_sections[k]->m_history);
+        const float barWidth = frameMs > 0 ? width * ms / frameMs : 0;
+        Bar& bar = bars[k];
+        bar.x = parentPtr->cursor;
+        bar.cursor = bar.x;
+        bar.depth = parentPtr->depth + 1;
+        parentPtr->cursor += barWidth;
+        maxDepth = std::max(maxDepth, bar.depth);
+
+        const ImVec2 barMin(origin.x + bar.x, origin.y + bar.depth * FLAME_ROW_HEIGHT);
+        const ImVec2 barMax(barMin.x + std::max(barWidth - 1, 1.0f), barMin.y + FLAME_ROW_HEIGHT - 1);
+        drawListPtr->AddRectFilled(barMin, barMax, ImColor::HSV(0.08f * bar.depth + 0.05f * k, 0.6f, 0.7f));
+        snprintf(label, sizeof(label), "%s %.2f ms", get_label(name), ms);
+        drawListPtr->PushClipRect(barMin, barMax, true);
+        drawListPtr->AddText(ImVec2(barMin.x + 2, barMin.y + 2), IM_COL32_WHITE, label);
+        drawListPtr->PopClipRect();
+        if (ImGui::IsMouseHoveringRect(barMin, barMax))
+        {
+            ImGui::SetTooltip("%s: %.3f ms mean", name.c_str(), ms);
+        }
+    }
+
+    ImGui::Dummy(ImVec2(width, (maxDepth + 1) * FLAME_ROW_HEIGHT));
+}
+
+float Profiler::get_mean(const std::vector<float>& history) const
+{
+    if (m_recordedFrames == 0)
+    {
+        return 0;
+    }
+    // The slots not recorded yet hold zeros.
+    float sum = 0;
+    for (float value : history)
+    {
+        sum += value;
+    }
+    return sum / m_recordedFrames;
+}
+
+AsyncTask::DoneStatus Profiler::frame_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<Profiler*>(dataPtr)->end_frame();
+    return AsyncTask::DS_cont;
+}
+
+void Profiler::on_new_frame(const NewFrameEvent& event, void* dataPtr)
+{
+    static_cast<Profiler*>(dataPtr)->draw_panel();
+}
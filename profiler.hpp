@@ -0,0 +1,127 @@
+/*
+ * profiler.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * Profiler module: named timing sections and per-frame counters, reported
+ * both to PStats and to an in-game ImGui panel.
+ *
+ * A Section is a PStatCollector; its name uses the PStats hierarchy, as in
+ * "App:ImGui:Render", and a Timer times a scope of code against it. A
+ * Counter is a PStats level set once per frame, such as a number of draw
+ * commands. Sections and counters are meant to be static objects.
+ *
+ * The panel (toggled with F3, shown at startup with profiler-panel) plots
+ * the rolling history of every section and counter, and breaks the frame
+ * down flame-style, sections nested under their parent by name. While the
+ * panel is hidden nothing is recorded: a Timer is a plain PStatTimer, which
+ * is idle when no PStats server is connected.
+ */
+
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <genericAsyncTask.h>
+#include <pStatCollector.h>
+#include <pStatTimer.h>
+
+class Event;
+struct NewFrameEvent;
+
+class Profiler
+{
+public:
+    class Section
+    {
+    public:
+        Section(const std::string& name);
+
+    private:
+        friend class Profiler;
+
+        PStatCollector m_collector;
+        std::string m_name;
+        std::atomic<long long> m_nanoseconds;   // this frame, from any thread
+        std::vector<float> m_history;           // ms
+
+        Section(const Section&); // to prevent copies
+    };
+
+    class Timer
+    {
+    public:
+        Timer(Section& section);
+        ~Timer();
+
+    private:
+        PStatTimer m_pstatTimer;
+        Section* m_sectionPtr;                  // NULL while not recording
+        std::chrono::steady_clock::time_point m_start;
+
+        Timer(const Timer&); // to prevent copies
+    };
+
+    class Counter
+    {
+    public:
+        Counter(const std::string& name);
+
+        // The value for this frame.
+        void set(double value);
+
+    private:
+        friend class Profiler;
+
+        PStatCollector m_collector;
+        std::string m_name;
+        std::atomic<double> m_value;
+        std::vector<float> m_history;
+
+        Counter(const Counter&); // to prevent copies
+    };
+
+    static Profiler* get_global_ptr();
+
+    // Shows the panel if profiler-panel is set.
+    void init();
+
+    void set_enabled(bool enabled);
+    bool is_enabled() const;
+
+    static void toggle(const Event* eventPtr, void* dataPtr);
+
+private:
+    Profiler();
+
+    void register_section(Section* sectionPtr);
+    void register_counter(Counter* counterPtr);
+    void end_frame();
+    void draw_panel();
+    void draw_flame(float frameMs);
+    float get_mean(const std::vector<float>& history) const;
+
+    static AsyncTask::DoneStatus frame_task(GenericAsyncTask* taskPtr, void* dataPtr);
+    static void on_new_frame(const NewFrameEvent& event, void* dataPtr);
+
+    Profiler(const Profiler&); // to prevent copies
+
+    static constexpr int HISTORY_SIZE = 120;
+
+    std::atomic<bool> m_enabled;
+    std::mutex m_mutex;                         // guards registration
+    std::vector<Section*> m_sections;
+    std::vector<Counter*> m_counters;
+    std::vector<float> m_frameHistory;          // ms
+    int m_historyIndex;
+    int m_recordedFrames;
+    std::chrono::steady_clock::time_point m_frameStart;
+    PT(GenericAsyncTask) m_frameTaskPtr;
+};
+
+#endif /* PROFILER_HPP_ */
@@ -0,0 +1,560 @@
+/*
+ * robots_scene.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <cmath>
+#include <mutex>
+
+#include <asyncTaskManager.h>
+#include <clockObject.h>
+#include <graphicsOutput.h>
+#include <loader.h>
+#include <nodePathCollection.h>
+#include <pandaFramework.h>
+
+#include "animation_cache.hpp"
+#include "frame_scheduler.hpp"
+#include "job_system.hpp"
+#include "robots_scene.hpp"
+
+namespace
+{
+    const char* const CLIP_FILENAMES[] =
+    {
+        "./models/robot_left_punch",
+        "./models/robot_right_punch",
+        "./models/robot_head_up",
+        "./models/robot_head_down"
+    };
+
+    // Frame of the punch clips where the fist reaches the opponent.
+    const double PUNCH_HIT_FRAME = 10;
+    // How long a robot keeps its head up after being hit, in seconds.
+    const double HIT_HOLD_TIME = 1.5;
+    // Average number of punches per second thrown by the robots nobody controls.
+    const double AI_PUNCH_RATE = 0.5;
+    // Distance between two rings of the grid.
+    const float RING_SPACING = 20;
+
+    // Hit shapes, in robot model units: a sphere around the head joint and
+    // a capsule along each forearm, from the elbow to the fist.
+    const char* const HEAD_JOINT = "joint15";
+    const char* const ELBOW_JOINTS[] = { "joint10", "joint13" };
+    const char* const FIST_JOINTS[] = { "joint11", "joint14" };
+    const float HEAD_RADIUS = 0.9f;
+    const float FIST_RADIUS = 0.4f;
+    // Cell of the collision grid, in scene units; a few times the size of
+    // a forearm.
+    const float COLLISION_CELL_SIZE = 4;
+    // Robots whose punches are checked by one job.
+    const int COLLISION_GRAIN = 64;
+
+    // Animation LOD: robots farther than these distances from the camera
+    // have their joints evaluated every 2nd, 4th and 8th frame.
+    const float LOD_HALF_DISTANCE = 40;
+    const float LOD_QUARTER_DISTANCE = 80;
+    const float LOD_EIGHTH_DISTANCE = 160;
+}
+
+RobotsScene::RobotsScene(int pairCount)
+    : m_pairCount(pairCount < 1 ? 1 : pairCount),
+    m_cpuSkinning(false),
+    m_collisions(COLLISION_CELL_SIZE),
+    m_spawnJob(-1),
+    m_frame(0),
+    m_randomSeed(12345)
+{
+}
+
+RobotsScene::~RobotsScene()
+{
+    if (m_spawnJob >= 0)
+    {
+        FrameScheduler::get_global_ptr()->cancel(m_spawnJob);
+    }
+    if (m_updateTaskPtr != NULL)
+    {
+        m_updateTaskPtr->remove();
+    }
+}
+
+int RobotsScene::get_num_robots() const
+{
+    return static_cast<int>(m_robots.size());
+}
+
+void RobotsScene::load(WindowFramework* windowFrameworkPtr, NodePath root)
+{
+    m_rootNp = root;
+    m_cameraNp = windowFrameworkPtr->get_camera_group();
+    // Without a GPU doing the skinning, take it over from Panda's generic
+    // CPU path.
+    m_cpuSkinning = CpuSkinning::should_use(windowFrameworkPtr->get_graphics_output()->get_gsg());
+
+    // Warm up the cache: the clips are loaded once here and every robot
+    // binds the same AnimBundles.
+    AnimationCache* cachePtr = AnimationCache::get_global_ptr();
+    for (int clipId = 0; clipId < C_clips; ++clipId)
+    {
+        cachePtr->load_clip(CLIP_FILENAMES[clipId]);
+    }
+
+    // Load the ring and the robot once; each pair instances the ring and
+    // copies the robot, so the geometry is shared between all of them.
+    NodePath ringNp(Loader::get_global_ptr()->load_sync("./models/ring"));
+    NodePath robotNp(Loader::get_global_ptr()->load_sync("./models/robot"));
+    if (ringNp.is_empty() || robotNp.is_empty())
+    {
+        nout << "ERROR: unable to load the robots models." << std::endl;
+        return;
+    }
+
+    // The first pair is there from the start, for the keyboard; the others
+    // are spawned by the FrameScheduler, a few per frame, so that large
+    // grids don't stall the game when entered.
+    m_robots.reserve(2 * m_pairCount);
+    m_ringModelNp = ringNp;
+    m_robotModelNp = robotNp;
+    spawn_pair(0, m_ringModelNp, m_robotModelNp);
+    if (m_pairCount > 1)
+    {
+        m_spawnJob = FrameScheduler::get_global_ptr()->submit("spawn-robots", [this]() { return spawn_next_pair(); });
+    }
+}
+
+bool RobotsScene::spawn_next_pair()
+{
+    const int pairId = get_num_robots() / 2;
+    spawn_pair(pairId, m_ringModelNp, m_robotModelNp);
+    if (pairId + 1 < m_pairCount)
+    {
+        return false;
+    }
+
+    m_spawnJob = -1;
+    m_ringModelNp.clear();
+    m_robotModelNp.clear();
+    return true;
+}
+
+void RobotsScene::enter(WindowFramework* windowFrameworkPtr)
+{
+    windowFrameworkPtr->get_display_region_3d()->set_clear_color(LColorf(0, 0, 0, 1));
+
+    // Look at the first ring like the tutorial does, and back off so that
+    // the whole grid fits in view.
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(m_pairCount))));
+    m_cameraNp.set_pos_hpr(14.5f * side, -15.4f * side, 14.0f * side, 45, -14, 0);
+
+    PandaFramework* frameworkPtr = windowFrameworkPtr->get_panda_framework();
+    frameworkPtr->define_key("a", "leftPunch1", punch_key<0, C_left_punch>, this);
+    frameworkPtr->define_key("s", "rightPunch1", punch_key<0, C_right_punch>, this);
+    frameworkPtr->define_key("k", "leftPunch2", punch_key<1, C_left_punch>, this);
+    frameworkPtr->define_key("l", "rightPunch2", punch_key<1, C_right_punch>, this);
+
+    m_updateTaskPtr = new GenericAsyncTask("robotsUpdateTask", update_robots, this);
+    AsyncTaskManager::get_global_ptr()->add(m_updateTaskPtr);
+}
+
+void RobotsScene::exit(WindowFramework* windowFrameworkPtr)
+{
+    EventHandler* handlerPtr = EventHandler::get_global_event_handler();
+    handlerPtr->remove_hook("a", punch_key<0, C_left_punch>, this);
+    handlerPtr->remove_hook("s", punch_key<0, C_right_punch>, this);
+    handlerPtr->remove_hook("k", punch_key<1, C_left_punch>, this);
+    handlerPtr->remove_hook("l", punch_key<1, C_right_punch>, this);
+
+    if (m_updateTaskPtr != NULL)
+    {
+        m_updateTaskPtr->remove();
+        m_updateTaskPtr = NULL;
+    }
+}
+
+void RobotsScene::spawn_pair(int pairId, NodePath ringNp, NodePath robotNp)
+{
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(m_pairCount))));
+    const int column = pairId % side;
+    const int row = pairId / side;
+
+    NodePath pairNp = m_rootNp.attach_new_node("robotPair");
+    pairNp.set_pos((column - (side - 1) * 0.5f) * RING_SPACING, (row - (side - 1) * 0.5f) * RING_SPACING, 0);
+    ringNp.instance_to(pairNp);
+
+    const int firstId = static_cast<int>(m_robots.size());
+
+    spawn_robot(pairNp, robotNp, firstId + 1);
+    m_robots.back().np.set_pos_hpr_scale(-1, -2.5, 4, 45, 0, 0, 1.25, 1.25, 1.25);
+
+    spawn_robot(pairNp, robotNp, firstId);
+    m_robots.back().np.set_pos_hpr_scale(1, -1, 4, 225, 0, 0, 1.25, 1.25, 1.25);
+    m_robots.back().np.set_color(LColorf(0.7, 0, 0, 1));
+
+    for (int robotId = firstId; robotId < firstId + 2; ++robotId)
+    {
+        Robot& robot = m_robots[robotId];
+        robot.pos = robot.np.get_pos(m_rootNp);
+        if (robot.characterPtr == NULL || robot.headJointPtr == NULL)
+        {
+            continue;
+        }
+
+        // Robots never move: the Character to scene transform is computed
+        // once, and only the joints have to be followed afterwards.
+        robot.toScene = robot.np.find("**/+Character").get_mat(m_rootNp);
+        robot.scale = robot.toScene.get_row3(0).length();
+        robot.characterPtr->update();
+
+        robot.headProxy = m_collisions.add_sphere(get_joint_pos(robot, robot.headJointPtr),
+                                                  HEAD_RADIUS * robot.scale, L_head, robotId);
+        for (int arm = 0; arm < 2; ++arm)
+        {
+            robot.armProxies[arm] = m_collisions.add_capsule(get_joint_pos(robot, robot.elbowJointPtrs[arm]),
+                                                             get_joint_pos(robot, robot.fistJointPtrs[arm]),
+                                                             FIST_RADIUS * robot.scale, L_arm, robotId);
+        }
+    }
+}
+
+void RobotsScene::spawn_robot(NodePath parentNp, NodePath robotNp, int opponentId)
+{
+    Robot robot;
+    robot.np = robotNp.copy_to(parentNp);
+    robot.opponentId = opponentId;
+    robot.state = R_idle;
+    robot.clip = -1;
+    robot.clipTime = 0;
+    robot.holdTime = 0;
+    robot.punchLanded = false;
+    robot.poseDirty = false;
+    robot.firstSkinner = static_cast<int>(m_skinners.size());
+    robot.numSkinners = 0;
+    robot.scale = 1;
+    robot.headProxy = -1;
+    robot.armProxies[0] = robot.armProxies[1] = -1;
+
+    NodePath characterNp = robot.np.find("**/+Character");
+    if (!characterNp.is_empty())
+    {
+        robot.characterPtr = DCAST(Character, characterNp.node());
+        PartBundle* bundlePtr = robot.characterPtr->get_bundle(0);
+        for (int clipId = 0; clipId < C_clips; ++clipId)
+        {
+            robot.controlPtrs[clipId] = AnimationCache::get_global_ptr()->bind_clip(bundlePtr, CLIP_FILENAMES[clipId]);
+        }
+
+        robot.headJointPtr = robot.characterPtr->find_joint(HEAD_JOINT);
+        for (int arm = 0; arm < 2; ++arm)
+        {
+            robot.elbowJointPtrs[arm] = robot.characterPtr->find_joint(ELBOW_JOINTS[arm]);
+            robot.fistJointPtrs[arm] = robot.characterPtr->find_joint(FIST_JOINTS[arm]);
+            if (robot.elbowJointPtrs[arm] == NULL || robot.fistJointPtrs[arm] == NULL)
+            {
+                robot.headJointPtr = NULL;
+            }
+        }
+        if (robot.headJointPtr == NULL)
+        {
+            nout << "ERROR: the robot model lacks the joints used for hit detection." << std::endl;
+        }
+    }
+    else
+    {
+        nout << "ERROR: the robot model has no Character." << std::endl;
+    }
+
+    if (m_cpuSkinning)
+    {
+        NodePathCollection geomNodes = robot.np.find_all_matches("**/+GeomNode");
+        for (int k = 0, k_end = geomNodes.get_num_paths(); k < k_end; ++k)
+        {
+            std::unique_ptr<CpuSkinner> skinner(new CpuSkinner(DCAST(GeomNode, geomNodes.get_path(k).node())));
+            if (skinner->is_valid())
+            {
+                m_skinners.push_back(std::move(skinner));
+                ++robot.numSkinners;
+            }
+        }
+    }
+
+    m_robots.push_back(robot);
+}
+
+template<int robotId, int clipId>
+void RobotsScene::punch_key(const Event* eventPtr, void* dataPtr)
+{
+    // preconditions
+    if (dataPtr == NULL)
+    {
+        nout << "ERROR: parameter dataPtr cannot be NULL." << std::endl;
+        return;
+    }
+
+    static_cast<RobotsScene*>(dataPtr)->punch(robotId, (ClipId)clipId);
+}
+
+void RobotsScene::punch(int robotId, ClipId clipId)
+{
+    if (robotId >= get_num_robots())
+    {
+        return;
+    }
+
+    Robot& robot = m_robots[robotId];
+    // A robot can't punch while it is still reeling from a hit.
+    if (robot.state == R_hit || robot.state == R_recovering)
+    {
+        return;
+    }
+
+    robot.state = R_punching;
+    robot.punchLanded = false;
+    play(robot, clipId);
+}
+
+void RobotsScene::play(Robot& robot, ClipId clipId)
+{
+    robot.clip = robot.controlPtrs[clipId] != NULL ? clipId : -1;
+    robot.clipTime = 0;
+    robot.poseDirty = true;
+}
+
+void RobotsScene::update_gameplay(double dt)
+{
+    const double aiPunchChance = AI_PUNCH_RATE * dt;
+
+    for (int robotId = 0, robotEnd = get_num_robots(); robotId < robotEnd; ++robotId)
+    {
+        Robot& robot = m_robots[robotId];
+
+        double clipLength = 0;
+        double frameRate = 0;
+        if (robot.clip >= 0)
+        {
+            AnimControl* controlPtr = robot.controlPtrs[robot.clip];
+            frameRate = controlPtr->get_frame_rate();
+            clipLength = controlPtr->get_num_frames() / frameRate;
+            robot.clipTime += dt;
+        }
+        const bool clipDone = robot.clip < 0 || robot.clipTime >= clipLength;
+
+        switch (robot.state)
+        {
+        case R_idle:
+            // The first pair is driven by the keyboard, the rest fight on
+            // their own.
+            if (robotId >= 2 && (next_random() % 10000) < aiPunchChance * 10000)
+            {
+                punch(robotId, (next_random() & 1) ? C_left_punch : C_right_punch);
+            }
+            break;
+
+        case R_punching:
+            // Whether the punch lands is up to update_collisions().
+            if (clipDone)
+            {
+                robot.state = R_idle;
+            }
+            break;
+
+        case R_hit:
+            if (clipDone)
+            {
+                robot.holdTime -= dt;
+                if (robot.holdTime <= 0)
+                {
+                    robot.state = R_recovering;
+                    play(robot, C_head_down);
+                }
+            }
+            break;
+
+        case R_recovering:
+            if (clipDone)
+            {
+                robot.state = R_idle;
+            }
+            break;
+        }
+    }
+}
+
+void RobotsScene::update_animation()
+{
+    // All the joints are evaluated here, in one pass over the robots,
+    // instead of lazily by each Character when it is culled.
+    const LPoint3f cameraPos = m_cameraNp.get_pos(m_rootNp);
+    ++m_frame;
+
+    for (int robotId = 0, robotEnd = get_num_robots(); robotId < robotEnd; ++robotId)
+    {
+        Robot& robot = m_robots[robotId];
+        if (robot.clip < 0)
+        {
+            continue;
+        }
+
+        // Stagger the far robots so they don't all update on the same frame.
+        const int stride = get_lod_stride(robot.pos, cameraPos);
+        if (!robot.poseDirty && (m_frame + robotId) % stride != 0)
+        {
+            continue;
+        }
+
+        AnimControl* controlPtr = robot.controlPtrs[robot.clip];
+        const int lastFrame = controlPtr->get_num_frames() - 1;
+        double frame = robot.clipTime * controlPtr->get_frame_rate();
+        if (frame >= lastFrame)
+        {
+            // Hold the last pose; nothing left to evaluate until the next clip.
+            frame = lastFrame;
+            robot.clip = -1;
+        }
+        controlPtr->pose(frame);
+        robot.characterPtr->update();
+        robot.poseDirty = false;
+        move_proxies(robot);
+
+        for (int k = 0; k < robot.numSkinners; ++k)
+        {
+            m_dirtySkinners.push_back(m_skinners[robot.firstSkinner + k].get());
+        }
+    }
+
+    // The vertices of every robot posed above are skinned in one go.
+    if (!m_dirtySkinners.empty())
+    {
+        CpuSkinning::skin_all(m_dirtySkinners);
+        m_dirtySkinners.clear();
+    }
+}
+
+void RobotsScene::update_collisions()
+{
+    // The queries run in parallel; the punches that landed are applied
+    // afterwards, in robot order, checking again the states that an
+    // earlier hit of the frame may have changed.
+    const int robotCount = get_num_robots();
+    m_landed.assign(robotCount, 0);
+    std::mutex statsMutex;
+    JobSystem::get_global_ptr()->parallel_for(0, robotCount, COLLISION_GRAIN, [&](int firstRobot, int lastRobot) {
+        std::vector<int> hits;
+        SpatialHash::Stats stats;
+        for (int robotId = firstRobot; robotId < lastRobot; ++robotId)
+        {
+            if (!can_land_punch(robotId))
+            {
+                continue;
+            }
+
+            const Robot& robot = m_robots[robotId];
+            hits.clear();
+            for (int arm = 0; arm < 2; ++arm)
+            {
+                m_collisions.query(robot.armProxies[arm], L_head, hits, stats);
+            }
+            for (int hit : hits)
+            {
+                if (m_collisions.get_owner(hit) == robot.opponentId)
+                {
+                    m_landed[robotId] = 1;
+                    break;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(statsMutex);
+        m_collisions.add_stats(stats);
+    });
+
+    for (int robotId = 0; robotId < robotCount; ++robotId)
+    {
+        if (m_landed[robotId] && can_land_punch(robotId))
+        {
+            Robot& robot = m_robots[robotId];
+            Robot& opponent = m_robots[robot.opponentId];
+            robot.punchLanded = true;
+            opponent.state = R_hit;
+            opponent.holdTime = HIT_HOLD_TIME;
+            play(opponent, C_head_up);
+        }
+    }
+}
+
+bool RobotsScene::can_land_punch(int robotId) const
+{
+    const Robot& robot = m_robots[robotId];
+    if (robot.state != R_punching || robot.punchLanded || robot.headProxy < 0)
+    {
+        return false;
+    }
+
+    // A punch can't land before it is well under way.
+    if (robot.clip >= 0 && robot.clipTime * robot.controlPtrs[robot.clip]->get_frame_rate() < PUNCH_HIT_FRAME)
+    {
+        return false;
+    }
+
+    const Robot& opponent = m_robots[robot.opponentId];
+    return opponent.state != R_hit && opponent.state != R_recovering;
+}
+
+void RobotsScene::move_proxies(Robot& robot)
+{
+    if (robot.headProxy < 0)
+    {
+        return;
+    }
+
+    m_collisions.move_sphere(robot.headProxy, get_joint_pos(robot, robot.headJointPtr));
+    for (int arm = 0; arm < 2; ++arm)
+    {
+        m_collisions.move_capsule(robot.armProxies[arm],
+                                  get_joint_pos(robot, robot.elbowJointPtrs[arm]),
+                                  get_joint_pos(robot, robot.fistJointPtrs[arm]));
+    }
+}
+
+LPoint3f RobotsScene::get_joint_pos(const Robot& robot, CharacterJoint* jointPtr) const
+{
+    // The net transform of a joint is relative to its Character, and kept
+    // up to date by Character::update().
+    LMatrix4f jointMat;
+    jointPtr->get_net_transform(jointMat);
+    return robot.toScene.xform_point(jointMat.get_row3(3));
+}
+
+int RobotsScene::get_lod_stride(const LPoint3f& pos, const LPoint3f& cameraPos) const
+{
+    const float distance2 = (pos - cameraPos).length_squared();
+    if (distance2 < LOD_HALF_DISTANCE * LOD_HALF_DISTANCE)
+    {
+        return 1;
+    }
+    if (distance2 < LOD_QUARTER_DISTANCE * LOD_QUARTER_DISTANCE)
+    {
+        return 2;
+    }
+    if (distance2 < LOD_EIGHTH_DISTANCE * LOD_EIGHTH_DISTANCE)
+    {
+        return 4;
+    }
+    return 8;
+}
+
+unsigned int RobotsScene::next_random()
+{
+    // Note: a local generator keeps fights reproducible from run to run.
+    m_randomSeed = m_randomSeed * 1103515245u + 12345u;
+    return (m_randomSeed >> 16) & 0x7fff;
+}
+
+AsyncTask::DoneStatus RobotsScene::update_robots(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    RobotsScene* scenePtr = static_cast<RobotsScene*>(dataPtr);
+    scenePtr->update_gameplay(ClockObject::get_global_clock()->get_dt());
+    scenePtr->update_animation();
+    scenePtr->update_collisions();
+    return AsyncTask::DS_cont;
+}
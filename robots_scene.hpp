@@ -0,0 +1,127 @@
+/*
+ * robots_scene.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * RobotsScene module: the boxing robots from the Panda3D tutorials, scaled
+ * to any number of robot pairs. Animation clips come from the shared
+ * AnimationCache, and the joints of every robot are evaluated in a single
+ * task per frame, at a lower rate for robots far from the camera. Punches
+ * land when a fist actually reaches the opponent's head, as reported by a
+ * SpatialHash tracking the arms and heads of every robot. Pairs past the
+ * first one are spawned as deferred FrameScheduler work.
+ */
+
+#ifndef ROBOTS_SCENE_HPP_
+#define ROBOTS_SCENE_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <animControl.h>
+#include <character.h>
+#include <characterJoint.h>
+#include <genericAsyncTask.h>
+
+#include "cpu_skinning.hpp"
+#include "scene_manager.hpp"
+#include "spatial_hash.hpp"
+
+class RobotsScene : public Scene
+{
+public:
+    RobotsScene(int pairCount = 1);
+    virtual ~RobotsScene();
+
+    virtual void load(WindowFramework* windowFrameworkPtr, NodePath root);
+    virtual void enter(WindowFramework* windowFrameworkPtr);
+    virtual void exit(WindowFramework* windowFrameworkPtr);
+
+    int get_num_robots() const;
+
+private:
+    enum ClipId
+    {
+        C_left_punch,
+        C_right_punch,
+        C_head_up,
+        C_head_down,
+        C_clips
+    };
+
+    enum CollisionLayer
+    {
+        L_head = 1,
+        L_arm = 2
+    };
+
+    enum RobotState
+    {
+        R_idle,
+        R_punching,
+        R_hit,
+        R_recovering
+    };
+
+    struct Robot
+    {
+        NodePath np;
+        PT(Character) characterPtr;
+        PT(AnimControl) controlPtrs[C_clips];
+        LPoint3f pos;             // in scene space, robots never move
+        int opponentId;
+        RobotState state;
+        int clip;                 // clip being played, -1 once the pose is final
+        double clipTime;
+        double holdTime;
+        bool punchLanded;
+        bool poseDirty;
+        int firstSkinner;         // CpuSkinners of this robot in m_skinners
+        int numSkinners;
+        LMatrix4f toScene;        // from the Character to the scene
+        float scale;              // of toScene, robots are scaled uniformly
+        PT(CharacterJoint) headJointPtr;
+        PT(CharacterJoint) elbowJointPtrs[2];
+        PT(CharacterJoint) fistJointPtrs[2];
+        int headProxy;            // proxies in m_collisions, -1 without joints
+        int armProxies[2];
+    };
+
+    bool spawn_next_pair();
+    void spawn_pair(int pairId, NodePath ringNp, NodePath robotNp);
+    void spawn_robot(NodePath parentNp, NodePath robotNp, int opponentId);
+
+    void punch(int robotId, ClipId clipId);
+    void play(Robot& robot, ClipId clipId);
+    void update_gameplay(double dt);
+    void update_animation();
+    void update_collisions();
+    bool can_land_punch(int robotId) const;
+    void move_proxies(Robot& robot);
+    LPoint3f get_joint_pos(const Robot& robot, CharacterJoint* jointPtr) const;
+    int get_lod_stride(const LPoint3f& pos, const LPoint3f& cameraPos) const;
+    unsigned int next_random();
+
+    template<int robotId, int clipId> static void punch_key(const Event* eventPtr, void* dataPtr);
+    static AsyncTask::DoneStatus update_robots(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    RobotsScene(const RobotsScene&); // to prevent copies
+
+    int m_pairCount;
+    NodePath m_rootNp;
+    NodePath m_cameraNp;
+    std::vector<Robot> m_robots;
+    bool m_cpuSkinning;
+    std::vector<std::unique_ptr<CpuSkinner>> m_skinners;
+    std::vector<CpuSkinner*> m_dirtySkinners;
+    SpatialHash m_collisions;
+    std::vector<char> m_landed;     // per robot, during update_collisions()
+    PT(GenericAsyncTask) m_updateTaskPtr;
+    NodePath m_ringModelNp;     // models the pairs are made of, while spawning
+    NodePath m_robotModelNp;
+    int m_spawnJob;             // in the FrameScheduler, -1 once all pairs are there
+    unsigned int m_frame;
+    unsigned int m_randomSeed;
+};
+
+#endif /* ROBOTS_SCENE_HPP_ */
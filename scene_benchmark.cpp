@@ -0,0 +1,276 @@
+/*
+ * scene_benchmark.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <asyncTaskCollection.h>
+#include <asyncTaskManager.h>
+#include <clockObject.h>
+#include <pandaFramework.h>
+#include <thread.h>
+
+#include "carousel_scene.hpp"
+#include "frame_scheduler.hpp"
+#include "robots_scene.hpp"
+#include "scene_benchmark.hpp"
+#include "scene_manager.hpp"
+
+namespace
+{
+    typedef std::chrono::steady_clock BenchClock;
+
+    const double FIXED_DT = 1.0 / 60.0;
+    // Frames run before measuring, once the scene is fully spawned.
+    const int WARMUP_FRAMES = 30;
+
+    struct Timing
+    {
+        std::string name;
+        std::vector<double> samples;    // ms
+        double p50, p95, p99, max, mean;
+        // Of a task after its last sample, to tell whether it ran since.
+        double lastDt = -1;
+        double lastAverageDt = -1;
+    };
+
+    // By task, not by name: several tasks may share one.
+    typedef std::map<PT(AsyncTask), Timing> TaskTimings;
+
+    // Samples the tasks of the default task chain that ran since the last
+    // call. AsyncTask doesn't publish its run count: a run changes get_dt()
+    // or get_average_dt(), unless it took exactly the previous average.
+    void sample_tasks(AsyncTaskManager* taskMgrPtr, TaskTimings& taskTimings, bool record)
+    {
+        AsyncTaskCollection tasks = taskMgrPtr->get_tasks();
+        for (size_t k = 0, k_end = tasks.get_num_tasks(); k < k_end; ++k)
+        {
+            // Note: the other chains run on threads of their own, their
+            // tasks aren't part of the frame.
+            AsyncTask* taskPtr = tasks.get_task(k);
+            if (taskPtr->get_task_chain() != "default")
+            {
+                continue;
+            }
+            Timing& timing = taskTimings[taskPtr];
+            const double dt = taskPtr->get_dt();
+            const double averageDt = taskPtr->get_average_dt();
+            if (dt == timing.lastDt && averageDt == timing.lastAverageDt)
+            {
+                continue;
+            }
+            timing.lastDt = dt;
+            timing.lastAverageDt = averageDt;
+            if (record)
+            {
+                timing.samples.push_back(1000 * dt);
+            }
+        }
+    }
+
+    // Nearest rank percentile of sorted samples.
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        const size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    void summarize(Timing& timing)
+    {
+        std::vector<double> sorted(timing.samples);
+        std::sort(sorted.begin(), sorted.end());
+        timing.p50 = percentile(sorted, 50);
+        timing.p95 = percentile(sorted, 95);
+        timing.p99 = percentile(sorted, 99);
+        timing.max = sorted.empty() ? 0 : sorted.back();
+        double sum = 0;
+        for (double sample : sorted)
+        {
+            sum += sample;
+        }
+        timing.mean = sorted.empty() ? 0 : sum / sorted.size();
+    }
+
+    // The camera goes once around the scene over the run, at the distance
+    // the scene's enter() puts it.
+    void place_camera(NodePath cameraNp, const std::string& sceneName, int count, double progress)
+    {
+        const double angle = 2 * 3.14159265358979 * progress;
+        const float side = std::ceil(std::sqrt(static_cast<float>(count)));
+        float radius = 8 * side;
+        float height = 2.5f * side;
+        LPoint3f target(0, 0, 1.5f);
+        if (sceneName == "robots")
+        {
+            radius = 21 * side;
+            height = 14 * side;
+            target = LPoint3f(0, 0, 4);
+        }
+        cameraNp.set_pos(radius * std::sin(angle), -radius * std::cos(angle), height);
+        cameraNp.look_at(target);
+    }
+
+    void write_json(const std::string& filename, const std::string& sceneName, int count, int frames,
+                    const std::vector<Timing>& timings)
+    {
+        std::ofstream out(filename.c_str());
+        out << "{\n  \"scene\": \"" << sceneName << "\",\n  \"count\": " << count
+            << ",\n  \"frames\": " << frames << ",\n  \"dt\": " << FIXED_DT << ",\n  \"timings\": [\n";
+        for (size_t k = 0; k < timings.size(); ++k)
+        {
+            const Timing& timing = timings[k];
+            out << "    { \"name\": \"" << timing.name << "\", \"p50\": " << timing.p50 << ", \"p95\": " << timing.p95
+                << ", \"p99\": " << timing.p99 << ", \"max\": " << timing.max << ", \"mean\": " << timing.mean << " }"
+                << (k + 1 < timings.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+    void write_csv(const std::string& filename, const std::vector<Timing>& timings)
+    {
+        std::ofstream out(filename.c_str());
+        out << "name,p50_ms,p95_ms,p99_ms,max_ms,mean_ms\n";
+        for (const Timing& timing : timings)
+        {
+            out << timing.name << "," << timing.p50 << "," << timing.p95 << "," << timing.p99 << ","
+                << timing.max << "," << timing.mean << "\n";
+        }
+    }
+}
+
+int run_scene_benchmark(WindowFramework* windowFrameworkPtr, int argc, char* argv[])
+{
+    const std::string sceneName = argc >= 3 ? argv[2] : "carousel";
+    const int frames = argc >= 4 && argv[3][0] != '-' ? std::max(1, atoi(argv[3])) : 600;
+    const int count = argc >= 5 && argv[4][0] != '-' ? std::max(1, atoi(argv[4])) : 1;
+    std::string jsonFilename;
+    std::string csvFilename;
+    for (int k = 2; k + 1 < argc; ++k)
+    {
+        if (strcmp(argv[k], "--json") == 0)
+        {
+            jsonFilename = argv[k + 1];
+        }
+        else if (strcmp(argv[k], "--csv") == 0)
+        {
+            csvFilename = argv[k + 1];
+        }
+    }
+
+    SceneManager sceneManager(windowFrameworkPtr);
+    if (sceneName == "carousel")
+    {
+        sceneManager.register_scene(sceneName, std::unique_ptr<Scene>(new CarouselScene(count)));
+    }
+    else if (sceneName == "robots")
+    {
+        sceneManager.register_scene(sceneName, std::unique_ptr<Scene>(new RobotsScene(count)));
+    }
+    else
+    {
+        std::cerr << "Unknown scene " << sceneName << ", expected carousel or robots" << std::endl;
+        return 1;
+    }
+
+    ClockObject* clockPtr = ClockObject::get_global_clock();
+    clockPtr->set_mode(ClockObject::M_non_real_time);
+    clockPtr->set_frame_rate(1 / FIXED_DT);
+
+    PandaFramework* frameworkPtr = windowFrameworkPtr->get_panda_framework();
+    Thread* currentThreadPtr = Thread::get_current_thread();
+    NodePath cameraNp = windowFrameworkPtr->get_camera_group();
+    sceneManager.switch_to(sceneName);
+
+    // Deferred spawning first, then a few frames for the caches.
+    FrameScheduler* schedulerPtr = FrameScheduler::get_global_ptr();
+    while (schedulerPtr->get_stats().pendingJobs > 0)
+    {
+        frameworkPtr->do_frame(currentThreadPtr);
+    }
+    for (int frame = 0; frame < WARMUP_FRAMES; ++frame)
+    {
+        place_camera(cameraNp, sceneName, count, 0);
+        frameworkPtr->do_frame(currentThreadPtr);
+    }
+
+    // Note: tasks that did not run in a frame, like the ones waiting on a
+    // delay, have no sample for it.
+    Timing frameTiming;
+    frameTiming.name = "frame";
+    TaskTimings taskTimings;
+    AsyncTaskManager* taskMgrPtr = AsyncTaskManager::get_global_ptr();
+    sample_tasks(taskMgrPtr, taskTimings, false);
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        place_camera(cameraNp, sceneName, count, static_cast<double>(frame) / frames);
+        const BenchClock::time_point start = BenchClock::now();
+        frameworkPtr->do_frame(currentThreadPtr);
+        frameTiming.samples.push_back(1000 * std::chrono::duration<double>(BenchClock::now() - start).count());
+        sample_tasks(taskMgrPtr, taskTimings, true);
+    }
+
+    // Tasks sharing a name are told apart by their id.
+    std::map<std::string, int> nameCounts;
+    for (const auto& entry : taskTimings)
+    {
+        if (!entry.second.samples.empty())
+        {
+            ++nameCounts[entry.first->get_name()];
+        }
+    }
+    std::vector<Timing> timings;
+    timings.push_back(frameTiming);
+    for (auto& entry : taskTimings)
+    {
+        if (entry.second.samples.empty())
+        {
+            continue;
+        }
+        const std::string& taskName = entry.first->get_name();
+        entry.second.name = "task:" + taskName;
+        if (nameCounts[taskName] > 1)
+        {
+            entry.second.name += "#" + std::to_string(entry.first->get_task_id());
+        }
+        timings.push_back(entry.second);
+    }
+    for (Timing& timing : timings)
+    {
+        summarize(timing);
+    }
+    // Heaviest first, after the frame itself.
+    std::sort(timings.begin() + 1, timings.end(),
+              [](const Timing& a, const Timing& b) { return a.mean > b.mean; });
+
+    std::cout << sceneName << " x" << count << ", " << frames << " frames at dt " << FIXED_DT << " s (ms)" << std::endl;
+    for (const Timing& timing : timings)
+    {
+        std::cout << timing.name << ": p50 " << timing.p50 << ", p95 " << timing.p95 << ", p99 " << timing.p99
+                  << ", max " << timing.max << ", mean " << timing.mean << std::endl;
+    }
+    if (!jsonFilename.empty())
+    {
+        write_json(jsonFilename, sceneName, count, frames, timings);
+    }
+    if (!csvFilename.empty())
+    {
+        write_csv(csvFilename, timings);
+    }
+    return 0;
+}
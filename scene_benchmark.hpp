@@ -0,0 +1,29 @@
+/*
+ * scene_benchmark.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * SceneBenchmark module: the scripted scene benchmark, run instead of the
+ * game as
+ *
+ *    Adventure3D bench-scene <carousel|robots> [frames] [count] [--json <file>] [--csv <file>]
+ *
+ * The scene is rendered offscreen with tinydisplay, at a fixed dt of 1/60 s,
+ * while the camera orbits it once over the run; `count' scales the scene
+ * (carousels or robot pairs). Frames are measured once the scene is fully
+ * spawned.
+ *
+ * The CPU time of every frame and of every task in it is recorded, and
+ * their p50, p95, p99, max and mean are printed, and written as JSON or
+ * CSV for comparisons between commits.
+ */
+
+#ifndef SCENE_BENCHMARK_HPP_
+#define SCENE_BENCHMARK_HPP_
+
+class WindowFramework;
+
+// `windowFrameworkPtr' is the offscreen buffer to render to.
+int run_scene_benchmark(WindowFramework* windowFrameworkPtr, int argc, char* argv[]);
+
+#endif /* SCENE_BENCHMARK_HPP_ */
@@ -0,0 +1,255 @@
+/*
+ * scene_manager.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <asyncTaskManager.h>
+#include <asyncTaskChain.h>
+#include <cIntervalManager.h>
+#include <graphicsWindow.h>
+#include <windowFramework.h>
+#include <windowProperties.h>
+
+#include "hot_reload.hpp"
+#include "profiler.hpp"
+#include "scene_manager.hpp"
+
+namespace
+{
+    Profiler::Section intervals_section("App:Intervals");
+    Profiler::Counter intervals_counter("Intervals");
+}
+
+SceneManager::SceneManager(WindowFramework* windowFrameworkPtr)
+    : m_windowFrameworkPtr(windowFrameworkPtr)
+{
+    // preconditions
+    if (m_windowFrameworkPtr == NULL)
+    {
+        nout << "ERROR: parameter windowFrameworkPtr cannot be NULL." << std::endl;
+    }
+
+    // Scenes are built on their own thread so that the main loop keeps
+    // rendering the active scene while the next one loads.
+    AsyncTaskManager* taskMgrPtr = AsyncTaskManager::get_global_ptr();
+    AsyncTaskChain* chainPtr = taskMgrPtr->make_task_chain(LOADER_TASK_CHAIN_NAME);
+    chainPtr->set_num_threads(1);
+    chainPtr->set_frame_sync(false);
+
+    // Note: intervals of every resident scene share one interval manager,
+    // so it is stepped once here rather than by each scene.
+    m_intervalTaskPtr = new GenericAsyncTask("intervalManagerTask", step_interval_manager, this);
+    taskMgrPtr->add(m_intervalTaskPtr);
+}
+
+SceneManager::~SceneManager()
+{
+    if (m_intervalTaskPtr != NULL)
+    {
+        m_intervalTaskPtr->remove();
+    }
+
+    for (auto& slot : m_slots)
+    {
+        if (slot->loadTaskPtr != NULL)
+        {
+            slot->loadTaskPtr->wait();
+        }
+        HotReload::get_global_ptr()->untrack(slot->root);
+        slot->root.remove_node();
+    }
+}
+
+void SceneManager::register_scene(const std::string& name, std::unique_ptr<Scene> scene)
+{
+    if (find_slot(name) != NULL)
+    {
+        nout << "ERROR: scene " << name << " is already registered." << std::endl;
+        return;
+    }
+
+    std::unique_ptr<SceneSlot> slot(new SceneSlot);
+    slot->ownerPtr = this;
+    slot->name = name;
+    slot->scene = std::move(scene);
+    // The root is never parented to render while the scene is inactive,
+    // so nothing below it is culled or drawn.
+    slot->root = NodePath("scene-" + name);
+    m_slots.push_back(std::move(slot));
+}
+
+void SceneManager::preload(const std::string& name)
+{
+    SceneSlot* slotPtr = find_slot(name);
+    if (slotPtr == NULL)
+    {
+        nout << "ERROR: unknown scene " << name << "." << std::endl;
+        return;
+    }
+
+    SceneState expected = S_unloaded;
+    if (!slotPtr->state.compare_exchange_strong(expected, S_loading))
+    {
+        return;
+    }
+
+    slotPtr->loadTaskPtr = new GenericAsyncTask("load-scene-" + name, load_scene, slotPtr);
+    slotPtr->loadTaskPtr->set_task_chain(LOADER_TASK_CHAIN_NAME);
+    AsyncTaskManager::get_global_ptr()->add(slotPtr->loadTaskPtr);
+}
+
+bool SceneManager::load(const std::string& name)
+{
+    SceneSlot* slotPtr = find_slot(name);
+    if (slotPtr == NULL)
+    {
+        nout << "ERROR: unknown scene " << name << "." << std::endl;
+        return false;
+    }
+
+    load_now(*slotPtr);
+    return true;
+}
+
+bool SceneManager::switch_to(const std::string& name)
+{
+    SceneSlot* slotPtr = find_slot(name);
+    if (slotPtr == NULL)
+    {
+        nout << "ERROR: unknown scene " << name << "." << std::endl;
+        return false;
+    }
+
+    int newIndex = 0;
+    while (m_slots[newIndex].get() != slotPtr)
+    {
+        ++newIndex;
+    }
+    if (newIndex == m_activeIndex)
+    {
+        return true;
+    }
+
+    load_now(*slotPtr);
+
+    // Swap the scene roots within the same frame; the window and the GSG
+    // are left untouched.
+    if (m_activeIndex >= 0)
+    {
+        SceneSlot& oldSlot = *m_slots[m_activeIndex];
+        oldSlot.scene->exit(m_windowFrameworkPtr);
+        oldSlot.root.detach_node();
+    }
+
+    slotPtr->root.reparent_to(m_windowFrameworkPtr->get_render());
+    m_activeIndex = newIndex;
+    slotPtr->scene->enter(m_windowFrameworkPtr);
+
+    GraphicsWindow* windowPtr = m_windowFrameworkPtr->get_graphics_window();
+    if (windowPtr != NULL)
+    {
+        WindowProperties props;
+        props.set_title("Super Amandine3D - " + name);
+        windowPtr->request_properties(props);
+    }
+
+    return true;
+}
+
+void SceneManager::switch_to_next()
+{
+    if (m_slots.empty())
+    {
+        return;
+    }
+
+    const int nextIndex = (m_activeIndex + 1) % static_cast<int>(m_slots.size());
+    switch_to(m_slots[nextIndex]->name);
+
+    // Get the following scene ready while the player looks at this one.
+    const int followingIndex = (nextIndex + 1) % static_cast<int>(m_slots.size());
+    preload(m_slots[followingIndex]->name);
+}
+
+Scene* SceneManager::get_scene(const std::string& name) const
+{
+    const SceneSlot* slotPtr = find_slot(name);
+    return slotPtr == NULL ? NULL : slotPtr->scene.get();
+}
+
+const std::string& SceneManager::get_active_name() const
+{
+    static const std::string noScene;
+    return m_activeIndex < 0 ? noScene : m_slots[m_activeIndex]->name;
+}
+
+void SceneManager::change_scene(const Event* eventPtr, void* dataPtr)
+{
+    // preconditions
+    if (dataPtr == NULL)
+    {
+        nout << "ERROR: parameter dataPtr cannot be NULL." << std::endl;
+        return;
+    }
+
+    static_cast<SceneManager*>(dataPtr)->switch_to_next();
+}
+
+SceneManager::SceneSlot* SceneManager::find_slot(const std::string& name)
+{
+    for (auto& slot : m_slots)
+    {
+        if (slot->name == name)
+        {
+            return slot.get();
+        }
+    }
+    return NULL;
+}
+
+const SceneManager::SceneSlot* SceneManager::find_slot(const std::string& name) const
+{
+    for (const auto& slot : m_slots)
+    {
+        if (slot->name == name)
+        {
+            return slot.get();
+        }
+    }
+    return NULL;
+}
+
+void SceneManager::load_now(SceneSlot& slot)
+{
+    SceneState expected = S_unloaded;
+    if (slot.state.compare_exchange_strong(expected, S_loading))
+    {
+        slot.scene->load(m_windowFrameworkPtr, slot.root);
+        slot.state = S_loaded;
+    }
+    else if (slot.state == S_loading && slot.loadTaskPtr != NULL)
+    {
+        // Note: only happens when switching faster than the loader can
+        // keep up; the frame stalls until the scene is ready.
+        slot.loadTaskPtr->wait();
+    }
+    slot.loadTaskPtr = NULL;
+}
+
+AsyncTask::DoneStatus SceneManager::load_scene(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    SceneSlot* slotPtr = static_cast<SceneSlot*>(dataPtr);
+    slotPtr->scene->load(slotPtr->ownerPtr->m_windowFrameworkPtr, slotPtr->root);
+    slotPtr->state = S_loaded;
+    return AsyncTask::DS_done;
+}
+
+AsyncTask::DoneStatus SceneManager::step_interval_manager(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    Profiler::Timer timer(intervals_section);
+    CIntervalManager* intervalMgrPtr = CIntervalManager::get_global_ptr();
+    intervals_counter.set(intervalMgrPtr->get_num_intervals());
+    intervalMgrPtr->step();
+    return AsyncTask::DS_cont;
+}
@@ -0,0 +1,102 @@
+/*
+ * scene_manager.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * SceneManager module: keeps several scenes resident in memory and switches
+ * between them by reparenting their root under render. The window, the GSG
+ * and the ImGui state are never torn down, so a switch only costs the
+ * enter()/exit() callbacks of the scenes involved.
+ */
+
+#ifndef SCENE_MANAGER_HPP_
+#define SCENE_MANAGER_HPP_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nodePath.h>
+#include <genericAsyncTask.h>
+
+class WindowFramework;
+
+class Scene
+{
+public:
+    virtual ~Scene() = default;
+
+    // Build the scene graph under `root'. This may run on the scene loader
+    // thread, so it must not touch render, the camera or the window.
+    virtual void load(WindowFramework* windowFrameworkPtr, NodePath root) = 0;
+
+    // Called on the main thread once `root' is parented under render.
+    virtual void enter(WindowFramework* windowFrameworkPtr) = 0;
+
+    // Called on the main thread before `root' is detached from render.
+    // The scene stays loaded and can be entered again later.
+    virtual void exit(WindowFramework* windowFrameworkPtr) = 0;
+};
+
+class SceneManager
+{
+public:
+    SceneManager(WindowFramework* windowFrameworkPtr);
+    ~SceneManager();
+
+    void register_scene(const std::string& name, std::unique_ptr<Scene> scene);
+
+    // Start loading `name' in the background. Does nothing if the scene
+    // is already loaded or being loaded.
+    void preload(const std::string& name);
+
+    // Load `name' on the calling thread, or wait for the loader if it is
+    // loading already. Any thread, as long as the scene is not active.
+    bool load(const std::string& name);
+
+    // Make `name' the active scene. If it was not preloaded, it is loaded
+    // synchronously; if it is still loading, we wait for the loader.
+    bool switch_to(const std::string& name);
+    void switch_to_next();
+
+    Scene* get_scene(const std::string& name) const;
+    const std::string& get_active_name() const;
+
+    static void change_scene(const Event* eventPtr, void* dataPtr);
+
+private:
+    enum SceneState
+    {
+        S_unloaded,
+        S_loading,
+        S_loaded
+    };
+
+    struct SceneSlot
+    {
+        SceneManager* ownerPtr;
+        std::string name;
+        std::unique_ptr<Scene> scene;
+        NodePath root;
+        std::atomic<SceneState> state{S_unloaded};
+        PT(AsyncTask) loadTaskPtr;
+    };
+
+    SceneSlot* find_slot(const std::string& name);
+    const SceneSlot* find_slot(const std::string& name) const;
+    void load_now(SceneSlot& slot);
+    static AsyncTask::DoneStatus load_scene(GenericAsyncTask* taskPtr, void* dataPtr);
+    static AsyncTask::DoneStatus step_interval_manager(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    SceneManager(); // to prevent use of the default constructor
+
+    static constexpr const char* LOADER_TASK_CHAIN_NAME = "sceneLoaderChain";
+
+    WindowFramework* m_windowFrameworkPtr;
+    std::vector<std::unique_ptr<SceneSlot>> m_slots;
+    int m_activeIndex = -1;
+    PT(GenericAsyncTask) m_intervalTaskPtr;
+};
+
+#endif /* SCENE_MANAGER_HPP_ */
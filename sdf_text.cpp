@@ -0,0 +1,115 @@
+/*
+ * sdf_text.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <configVariableFilename.h>
+#include <configVariableInt.h>
+#include <dynamicTextFont.h>
+#include <shader.h>
+#include <shaderAttrib.h>
+
+#include "sdf_text.hpp"
+#include "shader_cache.hpp"
+
+namespace
+{
+    ConfigVariableFilename sdf_text_font
+    ("sdf-text-font", "",
+     PRC_DESC("Font file drawn as a signed distance field by every "
+              "COnscreenText. Empty to keep Panda's default font."));
+
+    ConfigVariableInt sdf_text_pixels_per_unit
+    ("sdf-text-pixels-per-unit", 24,
+     PRC_DESC("Resolution of the distance field glyphs. Edges stay sharp "
+              "well beyond it, so it can stay low."));
+
+    const Filename SHADER_DIR("shader");
+
+    CPT(ShaderAttrib) get_base_attrib()
+    {
+        static CPT(ShaderAttrib) attribPtr;
+        if (attribPtr == NULL)
+        {
+            // Through the cache, so that later runs compile it at startup.
+            PT(Shader) shaderPtr = ShaderCache::get_global_ptr()->load(SHADER_DIR / "sdf_text.vert.glsl",
+                                                                       SHADER_DIR / "sdf_text.frag.glsl");
+            if (shaderPtr == NULL)
+            {
+                nout << "ERROR: unable to load the SDF text shader." << std::endl;
+                attribPtr = DCAST(ShaderAttrib, ShaderAttrib::make());
+            }
+            else
+            {
+                attribPtr = DCAST(ShaderAttrib, ShaderAttrib::make(shaderPtr));
+            }
+        }
+        return attribPtr;
+    }
+}
+
+PT(TextFont) SdfText::load_font(const Filename& filename)
+{
+    PT(DynamicTextFont) fontPtr = new DynamicTextFont(filename);
+    if (!fontPtr->is_valid())
+    {
+        nout << "ERROR: unable to load the font " << filename << "." << std::endl;
+        return NULL;
+    }
+
+    // The margin around each glyph holds the outside part of the field,
+    // where outlines and soft edges are drawn.
+    fontPtr->set_render_mode(TextFont::RM_distance_field);
+    fontPtr->set_pixels_per_unit(sdf_text_pixels_per_unit);
+    fontPtr->set_scale_factor(1);
+    fontPtr->set_native_antialias(false);
+    fontPtr->set_texture_margin(4);
+    fontPtr->set_page_size(256, 256);
+    fontPtr->set_minfilter(SamplerState::FT_linear);
+    fontPtr->set_magfilter(SamplerState::FT_linear);
+    return fontPtr.p();
+}
+
+TextFont* SdfText::get_default_font()
+{
+    static bool loaded = false;
+    static PT(TextFont) fontPtr;
+    if (!loaded)
+    {
+        loaded = true;
+        const Filename filename = sdf_text_font;
+        if (!filename.empty())
+        {
+            fontPtr = load_font(filename);
+        }
+    }
+    return fontPtr;
+}
+
+bool SdfText::is_sdf_font(const TextFont* fontPtr)
+{
+    // Note: only dynamic fonts have a render mode.
+    return fontPtr != NULL && fontPtr->is_of_type(DynamicTextFont::get_class_type()) &&
+           static_cast<const DynamicTextFont*>(fontPtr)->get_render_mode() == TextFont::RM_distance_field;
+}
+
+CPT(RenderAttrib) SdfText::make_shader_attrib(const LColorf& outlineColor, float outlineWidth)
+{
+    // The plain attrib is asked for often, by TextBatch::can_batch().
+    static CPT(RenderAttrib) plainAttribPtr;
+    const bool plain = outlineWidth == 0 && outlineColor == LColorf::zero();
+    if (plain && plainAttribPtr != NULL)
+    {
+        return plainAttribPtr;
+    }
+
+    CPT(RenderAttrib) attribPtr = get_base_attrib();
+    attribPtr = DCAST(ShaderAttrib, attribPtr)->set_shader_input(ShaderInput("sdf_outline_color", LVecBase4f(outlineColor)));
+    attribPtr = DCAST(ShaderAttrib, attribPtr)->set_shader_input(ShaderInput("sdf_outline_width", LVecBase4f(outlineWidth, 0, 0, 0)));
+    if (plain)
+    {
+        plainAttribPtr = attribPtr;
+    }
+    return attribPtr;
+}
@@ -0,0 +1,41 @@
+/*
+ * sdf_text.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * SdfText module: signed distance field fonts for COnscreenText. The glyphs
+ * of an SDF font are rasterized once, as distances to their outline, in a
+ * single atlas, and a small shader rebuilds sharp edges at any scale: a
+ * title at 0.15 and a label at 0.07 share the same pages.
+ *
+ * The shader also draws an outline around the glyphs (see
+ * COnscreenText::set_outline()); shadows are the glyphs drawn again, so
+ * they get the same treatment for free.
+ *
+ * Set sdf-text-font to a font file to have every COnscreenText use it.
+ */
+
+#ifndef SDF_TEXT_HPP_
+#define SDF_TEXT_HPP_
+
+#include <renderAttrib.h>
+#include <textFont.h>
+
+namespace SdfText
+{
+    // Loads `filename' as a distance field font, or returns NULL.
+    PT(TextFont) load_font(const Filename& filename);
+
+    // The font named by sdf-text-font, loaded on first use, or NULL.
+    // Not before main(): the config variable may not exist yet.
+    TextFont* get_default_font();
+
+    bool is_sdf_font(const TextFont* fontPtr);
+
+    // The shader drawing distance field glyphs, with an outline of
+    // `outlineWidth' (0 to 0.5, in distance units) when non zero.
+    CPT(RenderAttrib) make_shader_attrib(const LColorf& outlineColor = LColorf::zero(),
+                                         float outlineWidth = 0);
+}
+
+#endif /* SDF_TEXT_HPP_ */
@@ -0,0 +1,41 @@
+#version 150
+
+// Meshes quantized by MeshOptimizer, see mesh_optimizer.hpp.
+// Lit like the fixed function pipeline lights the scenes: ambient plus
+// Lambert diffuse from the first lights of the node.
+
+in vec3 eye_position;
+in vec3 eye_normal;
+in vec2 texcoord;
+in vec4 color;
+
+out vec4 frag_color;
+
+uniform sampler2D p3d_Texture0;
+
+uniform struct p3d_LightModelParameters {
+    vec4 ambient;
+} p3d_LightModel;
+
+uniform struct p3d_LightSourceParameters {
+    vec4 color;
+    vec4 position;          // eye space; w is 0 for directional lights
+} p3d_LightSource[4];
+
+void main()
+{
+    vec3 normal = normalize(eye_normal);
+    vec3 light = p3d_LightModel.ambient.rgb;
+    for (int k = 0; k < p3d_LightSource.length(); ++k)
+    {
+        // Unused slots are all zeros.
+        vec3 direction = p3d_LightSource[k].position.xyz - eye_position * p3d_LightSource[k].position.w;
+        if (dot(direction, direction) > 0.0)
+        {
+            light += p3d_LightSource[k].color.rgb * max(dot(normal, normalize(direction)), 0.0);
+        }
+    }
+
+    vec4 albedo = texture(p3d_Texture0, texcoord) * color;
+    frag_color = vec4(albedo.rgb * light, albedo.a);
+}
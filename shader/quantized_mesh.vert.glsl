@@ -0,0 +1,32 @@
+#version 150
+
+// Meshes quantized by MeshOptimizer, see mesh_optimizer.hpp.
+// Positions are int16 and texcoords uint16, both read as unnormalized
+// integers and mapped back to their range; normals are int8.
+
+in vec4 p3d_Vertex;
+in vec3 p3d_Normal;
+in vec2 p3d_MultiTexCoord0;
+in vec4 p3d_Color;
+
+out vec3 eye_position;
+out vec3 eye_normal;
+out vec2 texcoord;
+out vec4 color;
+
+uniform mat4 p3d_ModelViewProjectionMatrix;
+uniform mat4 p3d_ModelViewMatrix;
+uniform mat3 p3d_NormalMatrix;
+uniform vec4 p3d_ColorScale;
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform vec4 texcoord_range;        // xy: offset, zw: scale
+
+void main() {
+    vec4 position = vec4(position_offset + p3d_Vertex.xyz * position_scale, 1.0);
+    gl_Position = p3d_ModelViewProjectionMatrix * position;
+    eye_position = vec3(p3d_ModelViewMatrix * position);
+    eye_normal = normalize(p3d_NormalMatrix * p3d_Normal);
+    texcoord = texcoord_range.xy + p3d_MultiTexCoord0 * texcoord_range.zw;
+    color = p3d_Color * p3d_ColorScale;
+}
@@ -0,0 +1,34 @@
+#version 150
+
+// Signed distance field text, see sdf_text.hpp.
+// The glyph pages store 0.5 on the outline of the glyphs, more inside.
+// Untextured geometry (cards, frames) samples white, that is inside.
+
+in vec2 texcoord;
+in vec4 color;
+
+out vec4 frag_color;
+
+uniform sampler2D p3d_Texture0;
+uniform vec4 sdf_outline_color;
+uniform vec4 sdf_outline_width;     // x: width in distance units
+
+void main()
+{
+    float dist = texture(p3d_Texture0, texcoord).a;
+
+    // About one pixel of antialiasing, whatever the scale of the text.
+    float smoothing = max(fwidth(dist) * 0.75, 1e-4);
+    float glyph = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);
+
+    vec4 fill = color;
+    if (sdf_outline_width.x > 0.0)
+    {
+        float edge = 0.5 - sdf_outline_width.x;
+        float outline = smoothstep(edge - smoothing, edge + smoothing, dist);
+        fill = mix(sdf_outline_color, color, glyph);
+        glyph = outline;
+    }
+
+    frag_color = vec4(fill.rgb, fill.a * glyph);
+}
@@ -0,0 +1,19 @@
+#version 150
+
+// Signed distance field text, see sdf_text.hpp.
+
+in vec4 p3d_Vertex;
+in vec2 p3d_MultiTexCoord0;
+in vec4 p3d_Color;
+
+out vec2 texcoord;
+out vec4 color;
+
+uniform mat4 p3d_ModelViewProjectionMatrix;
+uniform vec4 p3d_ColorScale;
+
+void main() {
+    texcoord = p3d_MultiTexCoord0;
+    color = p3d_Color * p3d_ColorScale;
+    gl_Position = p3d_ModelViewProjectionMatrix * p3d_Vertex;
+}
@@ -0,0 +1,347 @@
+/*
+ * shader_cache.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <asyncTaskManager.h>
+#include <configVariableFilename.h>
+#include <virtualFileSystem.h>
+
+#include "shader_cache.hpp"
+
+namespace
+{
+    ConfigVariableFilename shader_cache_file
+    ("shader-cache-file", "shader-cache.txt",
+     PRC_DESC("Manifest of the GLSL programs used by previous runs, per driver. "
+              "They are compiled right after the first frame. Empty to "
+              "disable."));
+
+    // A program still not ready after this many frames failed to compile:
+    // apply it anyway, so that its errors show as usual.
+    const int MAX_PENDING_FRAMES = 300;
+
+    const char* const FALLBACK_VERTEX =
+        "#version 130\n"
+        "in vec4 p3d_Vertex;\n"
+        "in vec4 p3d_Color;\n"
+        "out vec4 color;\n"
+        "uniform mat4 p3d_ModelViewProjectionMatrix;\n"
+        "void main() {\n"
+        "    color = p3d_Color;\n"
+        "    gl_Position = p3d_ModelViewProjectionMatrix * p3d_Vertex;\n"
+        "}\n";
+
+    const char* const FALLBACK_FRAGMENT =
+        "#version 130\n"
+        "in vec4 color;\n"
+        "out vec4 frag_color;\n"
+        "void main() {\n"
+        "    frag_color = color;\n"
+        "}\n";
+
+    // FNV-1a, over both sources.
+    unsigned long long hash_sources(const std::string& vertex, const std::string& fragment)
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (char c : vertex + '\0' + fragment)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Tabs and newlines separate the fields of the manifest.
+    std::string sanitize(std::string text)
+    {
+        for (char& c : text)
+        {
+            if (c == '\t' || c == '\n' || c == '\r')
+            {
+                c = ' ';
+            }
+        }
+        return text;
+    }
+}
+
+ShaderCache* ShaderCache::get_global_ptr()
+{
+    static ShaderCache cache;
+    return &cache;
+}
+
+ShaderCache::ShaderCache()
+    : m_entriesChanged(false)
+{
+}
+
+void ShaderCache::set_gsg(GraphicsStateGuardian* gsgPtr)
+{
+    m_gsgPtr = gsgPtr;
+    if (m_gsgPtr == NULL)
+    {
+        // Released while the context is still there; the shaders still
+        // waiting get set as they are.
+        if (m_updateTaskPtr != NULL)
+        {
+            m_updateTaskPtr->remove();
+            m_updateTaskPtr = NULL;
+        }
+        for (Pending& entry : m_pending)
+        {
+            entry.np.set_shader(entry.shaderPtr);
+        }
+        m_pending.clear();
+        return;
+    }
+
+    // After igLoop: the programs enqueued are compiled when the frame
+    // begins rendering, so they are ready to be checked by then.
+    if (m_updateTaskPtr == NULL)
+    {
+        m_updateTaskPtr = new GenericAsyncTask("shaderCacheTask", update_task, this);
+        m_updateTaskPtr->set_sort(55);
+        AsyncTaskManager::get_global_ptr()->add(m_updateTaskPtr);
+    }
+    get_default_fallback()->prepare(m_gsgPtr->get_prepared_objects());
+}
+
+GraphicsStateGuardian* ShaderCache::get_gsg() const
+{
+    return m_gsgPtr;
+}
+
+PT(Shader) ShaderCache::load(const Filename& vertex, const Filename& fragment)
+{
+    std::string vertexText;
+    std::string fragmentText;
+    if (!read_text(vertex, vertexText) || !read_text(fragment, fragmentText))
+    {
+        return NULL;
+    }
+
+    const unsigned long long hash = hash_sources(vertexText, fragmentText);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<unsigned long long, Entry>::const_iterator it = m_entries.find(hash);
+        if (it != m_entries.end())
+        {
+            return it->second.shaderPtr;
+        }
+    }
+
+    // Note: loaded by name rather than made from the text, so that errors
+    // name the files.
+    PT(Shader) shaderPtr = Shader::load(Shader::SL_GLSL, vertex, fragment);
+    if (shaderPtr == NULL)
+    {
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = m_entries[hash];
+    if (entry.shaderPtr == NULL)
+    {
+        entry.vertex = vertex;
+        entry.fragment = fragment;
+        entry.shaderPtr = shaderPtr;
+        m_entriesChanged = true;
+    }
+    return entry.shaderPtr;
+}
+
+void ShaderCache::set_shader_async(NodePath np, Shader* shaderPtr, Shader* fallbackPtr)
+{
+    // preconditions
+    if (np.is_empty() || shaderPtr == NULL)
+    {
+        nout << "ERROR: parameters np and shaderPtr cannot be empty." << std::endl;
+        return;
+    }
+
+    // The last shader set wins over one still compiling.
+    for (size_t k = 0; k < m_pending.size();)
+    {
+        if (m_pending[k].np == np)
+        {
+            m_pending[k] = m_pending.back();
+            m_pending.pop_back();
+            continue;
+        }
+        ++k;
+    }
+
+    // Without a GSG, or one without shaders, there is nothing to wait for.
+    if (m_gsgPtr == NULL || (m_gsgPtr->is_valid() && !m_gsgPtr->get_supports_basic_shaders()) ||
+        shaderPtr->is_prepared(m_gsgPtr->get_prepared_objects()))
+    {
+        np.set_shader(shaderPtr);
+        return;
+    }
+
+    if (fallbackPtr == NULL)
+    {
+        fallbackPtr = get_default_fallback();
+    }
+    fallbackPtr->prepare(m_gsgPtr->get_prepared_objects());
+    shaderPtr->prepare(m_gsgPtr->get_prepared_objects());
+    np.set_shader(fallbackPtr);
+
+    Pending pending;
+    pending.np = np;
+    pending.shaderPtr = shaderPtr;
+    pending.frames = 0;
+    m_pending.push_back(pending);
+}
+
+Shader* ShaderCache::get_default_fallback()
+{
+    if (m_fallbackPtr == NULL)
+    {
+        m_fallbackPtr = Shader::make(Shader::SL_GLSL, FALLBACK_VERTEX, FALLBACK_FRAGMENT);
+    }
+    return m_fallbackPtr;
+}
+
+int ShaderCache::get_num_pending() const
+{
+    return static_cast<int>(m_pending.size());
+}
+
+void ShaderCache::warm_up()
+{
+    const Filename filename = shader_cache_file;
+    if (filename.empty())
+    {
+        return;
+    }
+
+    std::ifstream input(filename.to_os_specific().c_str());
+    std::string line;
+    int numPrepared = 0;
+    while (std::getline(input, line))
+    {
+        // driver, source hash, vertex file, fragment file
+        std::vector<std::string> fields;
+        std::istringstream lineStream(line);
+        for (std::string field; std::getline(lineStream, field, '\t');)
+        {
+            fields.push_back(field);
+        }
+        if (fields.size() != 4)
+        {
+            continue;
+        }
+        if (fields[0] != m_driverKey)
+        {
+            m_otherDrivers.push_back(line);
+            continue;
+        }
+
+        PT(Shader) shaderPtr = load(Filename(fields[2]), Filename(fields[3]));
+        if (shaderPtr != NULL)
+        {
+            shaderPtr->prepare(m_gsgPtr->get_prepared_objects());
+            ++numPrepared;
+        }
+    }
+    if (numPrepared > 0)
+    {
+        nout << "shader cache: " << numPrepared << " programs enqueued." << std::endl;
+    }
+}
+
+void ShaderCache::save_manifest() const
+{
+    const Filename filename = shader_cache_file;
+    if (filename.empty())
+    {
+        return;
+    }
+
+    std::ofstream output(filename.to_os_specific().c_str(), std::ios::trunc);
+    for (const std::string& line : m_otherDrivers)
+    {
+        output << line << "\n";
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry : m_entries)
+    {
+        char hash[32];
+        snprintf(hash, sizeof(hash), "%016llx", entry.first);
+        output << m_driverKey << "\t" << hash << "\t" << sanitize(entry.second.vertex.get_fullpath()) << "\t"
+               << sanitize(entry.second.fragment.get_fullpath()) << "\n";
+    }
+}
+
+std::string ShaderCache::get_driver_key(GraphicsStateGuardian* gsgPtr)
+{
+    return sanitize(gsgPtr->get_driver_vendor() + " / " + gsgPtr->get_driver_renderer() + " / " +
+                    gsgPtr->get_driver_version());
+}
+
+bool ShaderCache::read_text(const Filename& filename, std::string& text)
+{
+    Filename resolved = filename;
+    resolved.set_text();
+    if (!VirtualFileSystem::get_global_ptr()->read_file(resolved, text, true))
+    {
+        nout << "ERROR: unable to read the shader " << filename << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+AsyncTask::DoneStatus ShaderCache::update_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    ShaderCache* cachePtr = static_cast<ShaderCache*>(dataPtr);
+    GraphicsStateGuardian* gsgPtr = cachePtr->m_gsgPtr;
+    if (gsgPtr == NULL || !gsgPtr->is_valid())
+    {
+        // The context is made when the first frame renders.
+        return AsyncTask::DS_cont;
+    }
+
+    // The driver is known once there is a context.
+    if (cachePtr->m_driverKey.empty())
+    {
+        cachePtr->m_driverKey = get_driver_key(gsgPtr);
+        cachePtr->warm_up();
+    }
+
+    PreparedGraphicsObjects* preparedPtr = gsgPtr->get_prepared_objects();
+    const bool supportsShaders = gsgPtr->get_supports_basic_shaders();
+    std::vector<Pending>& pending = cachePtr->m_pending;
+    for (size_t k = 0; k < pending.size();)
+    {
+        Pending& entry = pending[k];
+        if (!supportsShaders || entry.shaderPtr->is_prepared(preparedPtr) || ++entry.frames >= MAX_PENDING_FRAMES)
+        {
+            entry.np.set_shader(entry.shaderPtr);
+            pending[k] = pending.back();
+            pending.pop_back();
+        }
+        else
+        {
+            ++k;
+        }
+    }
+
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(cachePtr->m_mutex);
+        std::swap(changed, cachePtr->m_entriesChanged);
+    }
+    if (changed)
+    {
+        cachePtr->save_manifest();
+    }
+    return AsyncTask::DS_cont;
+}
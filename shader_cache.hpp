@@ -0,0 +1,97 @@
+/*
+ * shader_cache.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * ShaderCache module: loads GLSL programs once per source and prepares
+ * them ahead of their first use, so that compiling a program does not stall
+ * the frame that first draws with it.
+ *
+ * set_shader_async() puts a fallback shader on a node and enqueues the real
+ * program with the GSG's prepared objects; the node is switched over once
+ * the program is compiled. Every program loaded is recorded, by source hash,
+ * in a manifest keyed by driver (shader-cache-file); later runs on the same
+ * driver enqueue all of them right after the first frame, before the game
+ * asks for them.
+ *
+ * Note: Panda does not expose GL program binaries, so the programs are
+ * still compiled by the driver on every run (which the driver's own cache
+ * usually speeds up); what is saved is the stall at first use.
+ */
+
+#ifndef SHADER_CACHE_HPP_
+#define SHADER_CACHE_HPP_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <filename.h>
+#include <genericAsyncTask.h>
+#include <graphicsStateGuardian.h>
+#include <nodePath.h>
+#include <shader.h>
+
+class ShaderCache
+{
+public:
+    static ShaderCache* get_global_ptr();
+
+    // The GSG programs are prepared for. Main thread, before the first
+    // frame; NULL releases it, before the framework closes.
+    void set_gsg(GraphicsStateGuardian* gsgPtr);
+    // NULL until set_gsg().
+    GraphicsStateGuardian* get_gsg() const;
+
+    // One Shader per source: loading the same sources again returns the
+    // same object. NULL if a file can't be read. Any thread.
+    PT(Shader) load(const Filename& vertex, const Filename& fragment);
+
+    // Draws `np' with `fallbackPtr' (the default fallback if NULL) until
+    // `shaderPtr' is compiled. Main thread.
+    void set_shader_async(NodePath np, Shader* shaderPtr, Shader* fallbackPtr = NULL);
+
+    // Flat vertex color, for the usual p3d_Vertex layouts.
+    Shader* get_default_fallback();
+
+    int get_num_pending() const;
+
+private:
+    struct Entry
+    {
+        Filename vertex;
+        Filename fragment;
+        PT(Shader) shaderPtr;
+    };
+
+    struct Pending
+    {
+        NodePath np;
+        PT(Shader) shaderPtr;
+        int frames;
+    };
+
+    ShaderCache();
+
+    void warm_up();
+    void save_manifest() const;
+    static std::string get_driver_key(GraphicsStateGuardian* gsgPtr);
+    static bool read_text(const Filename& filename, std::string& text);
+
+    static AsyncTask::DoneStatus update_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    ShaderCache(const ShaderCache&); // to prevent copies
+
+    mutable std::mutex m_mutex;             // guards m_entries
+    std::map<unsigned long long, Entry> m_entries;      // by source hash
+    bool m_entriesChanged;
+    std::vector<std::string> m_otherDrivers;            // manifest lines, kept as is
+    PT(GraphicsStateGuardian) m_gsgPtr;
+    std::string m_driverKey;                // empty until the GSG is ready
+    std::vector<Pending> m_pending;
+    PT(Shader) m_fallbackPtr;
+    PT(GenericAsyncTask) m_updateTaskPtr;
+};
+
+#endif /* SHADER_CACHE_HPP_ */
@@ -0,0 +1,394 @@
+/*
+ * spatial_hash.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "spatial_hash.hpp"
+
+namespace
+{
+    // Marks proxies kept in the oversized list rather than in a bucket.
+    const int OVERSIZED = -2;
+
+    float segment_point_distance2(const LPoint3f& a, const LPoint3f& b, const LPoint3f& p)
+    {
+        const LVector3f ab = b - a;
+        const float length2 = ab.length_squared();
+        float t = length2 > 0.0f ? (p - a).dot(ab) / length2 : 0.0f;
+        t = std::min(1.0f, std::max(0.0f, t));
+        return (a + ab * t - p).length_squared();
+    }
+
+    // Squared distance between segments [p1, q1] and [p2, q2].
+    // From Ericson, Real-Time Collision Detection, 5.1.9.
+    float segment_segment_distance2(const LPoint3f& p1, const LPoint3f& q1,
+                                    const LPoint3f& p2, const LPoint3f& q2)
+    {
+        const float epsilon = 1e-8f;
+        const LVector3f d1 = q1 - p1;
+        const LVector3f d2 = q2 - p2;
+        const LVector3f r = p1 - p2;
+        const float a = d1.length_squared();
+        const float e = d2.length_squared();
+        const float f = d2.dot(r);
+        float s = 0.0f;
+        float t = 0.0f;
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            return r.length_squared();
+        }
+        if (a <= epsilon)
+        {
+            t = std::min(1.0f, std::max(0.0f, f / e));
+        }
+        else
+        {
+            const float c = d1.dot(r);
+            if (e <= epsilon)
+            {
+                s = std::min(1.0f, std::max(0.0f, -c / a));
+            }
+            else
+            {
+                const float b = d1.dot(d2);
+                const float denom = a * e - b * b;
+                if (denom != 0.0f)
+                {
+                    s = std::min(1.0f, std::max(0.0f, (b * f - c * e) / denom));
+                }
+                t = (b * s + f) / e;
+                if (t < 0.0f)
+                {
+                    t = 0.0f;
+                    s = std::min(1.0f, std::max(0.0f, -c / a));
+                }
+                else if (t > 1.0f)
+                {
+                    t = 1.0f;
+                    s = std::min(1.0f, std::max(0.0f, (b - c) / a));
+                }
+            }
+        }
+
+        return ((p1 + d1 * s) - (p2 + d2 * t)).length_squared();
+    }
+}
+
+SpatialHash::SpatialHash(float cellSize, int bucketCountLog2)
+    : m_cellSize(cellSize),
+    m_invCellSize(1.0f / cellSize),
+    m_bucketMask((1 << bucketCountLog2) - 1),
+    m_buckets(static_cast<size_t>(1) << bucketCountLog2, -1),
+    m_numProxies(0)
+{
+}
+
+int SpatialHash::add_sphere(const LPoint3f& center, float radius, unsigned int layer, int owner)
+{
+    const int proxy = allocate(ST_sphere, layer, owner);
+    m_pointsA[proxy] = center;
+    m_pointsB[proxy] = center;
+    m_radii[proxy] = radius;
+    update_bounds(proxy);
+    m_cells[proxy] = get_cell(m_boundCenters[proxy]);
+    link(proxy);
+    return proxy;
+}
+
+int SpatialHash::add_capsule(const LPoint3f& a, const LPoint3f& b, float radius, unsigned int layer, int owner)
+{
+    const int proxy = allocate(ST_capsule, layer, owner);
+    m_pointsA[proxy] = a;
+    m_pointsB[proxy] = b;
+    m_radii[proxy] = radius;
+    update_bounds(proxy);
+    m_cells[proxy] = get_cell(m_boundCenters[proxy]);
+    link(proxy);
+    return proxy;
+}
+
+void SpatialHash::move_sphere(int proxy, const LPoint3f& center)
+{
+    move_capsule(proxy, center, center);
+}
+
+void SpatialHash::move_capsule(int proxy, const LPoint3f& a, const LPoint3f& b)
+{
+    m_pointsA[proxy] = a;
+    m_pointsB[proxy] = b;
+    update_bounds(proxy);
+
+    // Most moves stay within the same cell and the same size class: nothing
+    // to relink then. A capsule that stretches past half a cell must go to
+    // the oversized list though, or queries of range 1 would miss it.
+    const Cell cell = get_cell(m_boundCenters[proxy]);
+    const Cell& oldCell = m_cells[proxy];
+    const bool oversized = m_boundRadii[proxy] > 0.5f * m_cellSize;
+    if (cell.x != oldCell.x || cell.y != oldCell.y || cell.z != oldCell.z ||
+        oversized != (m_prev[proxy] == OVERSIZED))
+    {
+        unlink(proxy);
+        m_cells[proxy] = cell;
+        link(proxy);
+        ++m_stats.relinks;
+    }
+}
+
+void SpatialHash::remove(int proxy)
+{
+    unlink(proxy);
+    m_types[proxy] = ST_free;
+    m_freeProxies.push_back(proxy);
+    --m_numProxies;
+}
+
+int SpatialHash::query(int proxy, unsigned int layerMask, std::vector<int>& hits) const
+{
+    return query(proxy, layerMask, hits, m_stats);
+}
+
+int SpatialHash::query(int proxy, unsigned int layerMask, std::vector<int>& hits, Stats& stats) const
+{
+    ++stats.queries;
+    const size_t firstHit = hits.size();
+    const int owner = m_owners[proxy];
+
+    auto test = [&](int other) {
+        if (other == proxy || (m_layers[other] & layerMask) == 0 || m_owners[other] == owner)
+        {
+            return;
+        }
+        ++stats.candidates;
+        if (overlap(proxy, other))
+        {
+            hits.push_back(other);
+        }
+    };
+
+    // Neighbor cells that may hold an overlapping proxy; 1 for any proxy
+    // that fits in half a cell.
+    const Cell& cell = m_cells[proxy];
+    const int range = static_cast<int>(std::ceil((m_boundRadii[proxy] + 0.5f * m_cellSize) * m_invCellSize));
+
+    // Different cells may hash to the same bucket; visit each bucket once.
+    int visited[27];
+    int numVisited = 0;
+    std::vector<int> visitedOverflow;
+
+    for (int dz = -range; dz <= range; ++dz)
+    {
+        for (int dy = -range; dy <= range; ++dy)
+        {
+            for (int dx = -range; dx <= range; ++dx)
+            {
+                const Cell neighbor = { cell.x + dx, cell.y + dy, cell.z + dz };
+                const int bucket = get_bucket(neighbor);
+
+                bool seen = std::find(visited, visited + numVisited, bucket) != visited + numVisited ||
+                    std::find(visitedOverflow.begin(), visitedOverflow.end(), bucket) != visitedOverflow.end();
+                if (seen)
+                {
+                    continue;
+                }
+                if (numVisited < 27)
+                {
+                    visited[numVisited++] = bucket;
+                }
+                else
+                {
+                    visitedOverflow.push_back(bucket);
+                }
+
+                for (int other = m_buckets[bucket]; other >= 0; other = m_next[other])
+                {
+                    // Skip the proxies of other cells sharing the bucket.
+                    const Cell& otherCell = m_cells[other];
+                    if (std::abs(otherCell.x - cell.x) > range ||
+                        std::abs(otherCell.y - cell.y) > range ||
+                        std::abs(otherCell.z - cell.z) > range)
+                    {
+                        continue;
+                    }
+                    test(other);
+                }
+            }
+        }
+    }
+
+    for (int other : m_oversized)
+    {
+        test(other);
+    }
+
+    const int numHits = static_cast<int>(hits.size() - firstHit);
+    stats.overlaps += numHits;
+    return numHits;
+}
+
+int SpatialHash::get_owner(int proxy) const
+{
+    return m_owners[proxy];
+}
+
+int SpatialHash::get_num_proxies() const
+{
+    return m_numProxies;
+}
+
+float SpatialHash::get_cell_size() const
+{
+    return m_cellSize;
+}
+
+const SpatialHash::Stats& SpatialHash::get_stats() const
+{
+    return m_stats;
+}
+
+void SpatialHash::reset_stats()
+{
+    m_stats = Stats();
+}
+
+void SpatialHash::add_stats(const Stats& stats)
+{
+    m_stats.queries += stats.queries;
+    m_stats.candidates += stats.candidates;
+    m_stats.overlaps += stats.overlaps;
+    m_stats.relinks += stats.relinks;
+}
+
+int SpatialHash::allocate(ShapeType type, unsigned int layer, int owner)
+{
+    int proxy;
+    if (!m_freeProxies.empty())
+    {
+        proxy = m_freeProxies.back();
+        m_freeProxies.pop_back();
+    }
+    else
+    {
+        proxy = static_cast<int>(m_types.size());
+        m_types.push_back(ST_free);
+        m_pointsA.push_back(LPoint3f::zero());
+        m_pointsB.push_back(LPoint3f::zero());
+        m_radii.push_back(0.0f);
+        m_boundCenters.push_back(LPoint3f::zero());
+        m_boundRadii.push_back(0.0f);
+        m_layers.push_back(0);
+        m_owners.push_back(-1);
+        m_cells.push_back(Cell());
+        m_prev.push_back(-1);
+        m_next.push_back(-1);
+    }
+
+    m_types[proxy] = type;
+    m_layers[proxy] = layer;
+    m_owners[proxy] = owner;
+    ++m_numProxies;
+    return proxy;
+}
+
+void SpatialHash::update_bounds(int proxy)
+{
+    const LPoint3f& a = m_pointsA[proxy];
+    const LPoint3f& b = m_pointsB[proxy];
+    m_boundCenters[proxy] = (a + b) * 0.5f;
+    m_boundRadii[proxy] = (b - a).length() * 0.5f + m_radii[proxy];
+}
+
+SpatialHash::Cell SpatialHash::get_cell(const LPoint3f& point) const
+{
+    Cell cell;
+    cell.x = static_cast<int>(std::floor(point[0] * m_invCellSize));
+    cell.y = static_cast<int>(std::floor(point[1] * m_invCellSize));
+    cell.z = static_cast<int>(std::floor(point[2] * m_invCellSize));
+    return cell;
+}
+
+int SpatialHash::get_bucket(const Cell& cell) const
+{
+    const unsigned int h = static_cast<unsigned int>(cell.x) * 73856093u ^
+                           static_cast<unsigned int>(cell.y) * 19349663u ^
+                           static_cast<unsigned int>(cell.z) * 83492791u;
+    return static_cast<int>(h & static_cast<unsigned int>(m_bucketMask));
+}
+
+void SpatialHash::link(int proxy)
+{
+    if (m_boundRadii[proxy] > 0.5f * m_cellSize)
+    {
+        m_prev[proxy] = OVERSIZED;
+        m_oversized.push_back(proxy);
+        return;
+    }
+
+    const int bucket = get_bucket(m_cells[proxy]);
+    m_prev[proxy] = -1;
+    m_next[proxy] = m_buckets[bucket];
+    if (m_buckets[bucket] >= 0)
+    {
+        m_prev[m_buckets[bucket]] = proxy;
+    }
+    m_buckets[bucket] = proxy;
+}
+
+void SpatialHash::unlink(int proxy)
+{
+    if (m_prev[proxy] == OVERSIZED)
+    {
+        m_oversized.erase(std::find(m_oversized.begin(), m_oversized.end(), proxy));
+        m_prev[proxy] = -1;
+        return;
+    }
+
+    if (m_prev[proxy] >= 0)
+    {
+        m_next[m_prev[proxy]] = m_next[proxy];
+    }
+    else
+    {
+        m_buckets[get_bucket(m_cells[proxy])] = m_next[proxy];
+    }
+    if (m_next[proxy] >= 0)
+    {
+        m_prev[m_next[proxy]] = m_prev[proxy];
+    }
+    m_prev[proxy] = -1;
+    m_next[proxy] = -1;
+}
+
+bool SpatialHash::overlap(int proxyA, int proxyB) const
+{
+    const float reach = m_radii[proxyA] + m_radii[proxyB];
+    const float reach2 = reach * reach;
+
+    // Cheap rejection on the bounding spheres first.
+    const float bound = m_boundRadii[proxyA] + m_boundRadii[proxyB];
+    if ((m_boundCenters[proxyA] - m_boundCenters[proxyB]).length_squared() > bound * bound)
+    {
+        return false;
+    }
+
+    const bool sphereA = m_types[proxyA] == ST_sphere;
+    const bool sphereB = m_types[proxyB] == ST_sphere;
+    if (sphereA && sphereB)
+    {
+        return (m_pointsA[proxyA] - m_pointsA[proxyB]).length_squared() <= reach2;
+    }
+    if (sphereA)
+    {
+        return segment_point_distance2(m_pointsA[proxyB], m_pointsB[proxyB], m_pointsA[proxyA]) <= reach2;
+    }
+    if (sphereB)
+    {
+        return segment_point_distance2(m_pointsA[proxyA], m_pointsB[proxyA], m_pointsA[proxyB]) <= reach2;
+    }
+    return segment_segment_distance2(m_pointsA[proxyA], m_pointsB[proxyA],
+                                     m_pointsA[proxyB], m_pointsB[proxyB]) <= reach2;
+}
@@ -0,0 +1,104 @@
+/*
+ * spatial_hash.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * SpatialHash module: hit detection between simple shapes (spheres and
+ * capsules) attached to moving objects, such as the fists and heads of
+ * the boxing robots.
+ *
+ * The broadphase is a uniform grid hashed into a fixed number of buckets.
+ * A proxy lives in the bucket of the cell holding its bounding sphere's
+ * center and is only relinked when it changes cell, so moving proxies
+ * every frame is cheap. Proxies are at most half a cell wide, so a query
+ * only has to look at the 27 cells around the queried proxy.
+ */
+
+#ifndef SPATIAL_HASH_HPP_
+#define SPATIAL_HASH_HPP_
+
+#include <vector>
+
+#include <luse.h>
+
+class SpatialHash
+{
+public:
+    struct Stats
+    {
+        int queries = 0;
+        int candidates = 0;     // proxies that reached the narrowphase
+        int overlaps = 0;
+        int relinks = 0;        // proxies moved to another bucket
+    };
+
+    SpatialHash(float cellSize, int bucketCountLog2 = 12);
+
+    int add_sphere(const LPoint3f& center, float radius, unsigned int layer, int owner);
+    int add_capsule(const LPoint3f& a, const LPoint3f& b, float radius, unsigned int layer, int owner);
+    void move_sphere(int proxy, const LPoint3f& center);
+    void move_capsule(int proxy, const LPoint3f& a, const LPoint3f& b);
+    void remove(int proxy);
+
+    // Appends to `hits' the proxies on one of the `layerMask' layers that
+    // overlap `proxy', ignoring the proxies of the same owner. Returns the
+    // number of hits appended.
+    int query(int proxy, unsigned int layerMask, std::vector<int>& hits) const;
+    // Same, counting in `stats' rather than in the hash's own: concurrent
+    // queries are safe as long as nothing moves meanwhile.
+    int query(int proxy, unsigned int layerMask, std::vector<int>& hits, Stats& stats) const;
+
+    int get_owner(int proxy) const;
+    int get_num_proxies() const;
+    float get_cell_size() const;
+
+    const Stats& get_stats() const;
+    void reset_stats();
+    void add_stats(const Stats& stats);
+
+private:
+    enum ShapeType
+    {
+        ST_sphere,
+        ST_capsule,
+        ST_free
+    };
+
+    struct Cell
+    {
+        int x, y, z;
+    };
+
+    int allocate(ShapeType type, unsigned int layer, int owner);
+    void update_bounds(int proxy);
+    Cell get_cell(const LPoint3f& point) const;
+    int get_bucket(const Cell& cell) const;
+    void link(int proxy);
+    void unlink(int proxy);
+    bool overlap(int proxyA, int proxyB) const;
+
+    float m_cellSize;
+    float m_invCellSize;
+    int m_bucketMask;
+    std::vector<int> m_buckets;       // first proxy of each bucket, -1 when empty
+    std::vector<int> m_oversized;     // proxies wider than half a cell, always tested
+
+    // Proxies, in SoA form.
+    std::vector<ShapeType> m_types;
+    std::vector<LPoint3f> m_pointsA;  // sphere center or capsule start
+    std::vector<LPoint3f> m_pointsB;  // capsule end
+    std::vector<float> m_radii;
+    std::vector<LPoint3f> m_boundCenters;
+    std::vector<float> m_boundRadii;
+    std::vector<unsigned int> m_layers;
+    std::vector<int> m_owners;
+    std::vector<Cell> m_cells;
+    std::vector<int> m_prev;          // links in the bucket lists
+    std::vector<int> m_next;
+    std::vector<int> m_freeProxies;
+
+    int m_numProxies;
+    mutable Stats m_stats;
+};
+
+#endif /* SPATIAL_HASH_HPP_ */
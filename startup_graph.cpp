@@ -0,0 +1,244 @@
+/*
+ * startup_graph.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#include <asyncTaskManager.h>
+#include <configVariableBool.h>
+
+#include "job_system.hpp"
+#include "startup_graph.hpp"
+
+namespace
+{
+    ConfigVariableBool startup_timeline
+    ("startup-timeline", true,
+     PRC_DESC("Print the timeline of the startup steps and the time to first "
+              "frame once the first frame is rendered."));
+
+    // Initialized with the other statics, before main(): close enough to
+    // the start of the process.
+    const std::chrono::steady_clock::time_point process_start = std::chrono::steady_clock::now();
+
+    const int TIMELINE_WIDTH = 40;
+
+    double to_ms(std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration<double, std::milli>(time - process_start).count();
+    }
+}
+
+StartupGraph::StartupGraph()
+    : m_finished(0)
+{
+}
+
+StartupGraph::~StartupGraph()
+{
+    if (m_firstFrameTaskPtr != NULL)
+    {
+        m_firstFrameTaskPtr->remove();
+    }
+}
+
+int StartupGraph::add(const std::string& name, Step step, Affinity affinity)
+{
+    Node node;
+    node.name = name;
+    node.step = std::move(step);
+    node.affinity = affinity;
+    node.numPrerequisites = 0;
+    node.remaining = 0;
+    node.onMainThread = false;
+    m_nodes.push_back(std::move(node));
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void StartupGraph::add_dependency(int step, int prerequisite)
+{
+    // preconditions
+    const int numNodes = static_cast<int>(m_nodes.size());
+    if (step < 0 || step >= numNodes || prerequisite < 0 || prerequisite >= numNodes)
+    {
+        nout << "ERROR: unknown startup step." << std::endl;
+        return;
+    }
+
+    m_nodes[prerequisite].successors.push_back(step);
+    ++m_nodes[step].numPrerequisites;
+}
+
+bool StartupGraph::run()
+{
+    const int numNodes = static_cast<int>(m_nodes.size());
+
+    // A cycle would never finish.
+    std::vector<int> ready;
+    for (int n = 0; n < numNodes; ++n)
+    {
+        m_nodes[n].remaining = m_nodes[n].numPrerequisites;
+        if (m_nodes[n].remaining == 0)
+        {
+            ready.push_back(n);
+        }
+    }
+    int numSorted = 0;
+    std::vector<int> sorting(ready);
+    while (!sorting.empty())
+    {
+        const int n = sorting.back();
+        sorting.pop_back();
+        ++numSorted;
+        for (int successor : m_nodes[n].successors)
+        {
+            if (--m_nodes[successor].remaining == 0)
+            {
+                sorting.push_back(successor);
+            }
+        }
+    }
+    if (numSorted != numNodes)
+    {
+        nout << "ERROR: the startup graph has a cycle." << std::endl;
+        return false;
+    }
+
+    for (int n = 0; n < numNodes; ++n)
+    {
+        m_nodes[n].remaining = m_nodes[n].numPrerequisites;
+    }
+    m_mainThreadId = std::this_thread::get_id();
+    m_finished = 0;
+    m_mainReady.clear();
+
+    JobSystem* jobSystemPtr = JobSystem::get_global_ptr();
+    for (int n : ready)
+    {
+        if (m_nodes[n].affinity == A_main_thread)
+        {
+            m_mainReady.push_back(n);
+        }
+        else
+        {
+            jobSystemPtr->submit([this, n]() { run_step(n); });
+        }
+    }
+
+    // Main thread steps in the order they became ready; in between, help
+    // with the others, as JobSystem::wait() does.
+    for (;;)
+    {
+        int node = -1;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_finished == numNodes)
+            {
+                break;
+            }
+            if (!m_mainReady.empty())
+            {
+                node = m_mainReady.front();
+                m_mainReady.erase(m_mainReady.begin());
+            }
+        }
+
+        if (node >= 0)
+        {
+            run_step(node);
+        }
+        else if (!jobSystemPtr->run_one())
+        {
+            std::this_thread::yield();
+        }
+    }
+    return true;
+}
+
+void StartupGraph::run_step(int node)
+{
+    Node& step = m_nodes[node];
+    step.onMainThread = std::this_thread::get_id() == m_mainThreadId;
+    step.start = Clock::now();
+    step.step();
+    step.end = Clock::now();
+    release_successors(node);
+}
+
+void StartupGraph::release_successors(int node)
+{
+    JobSystem* jobSystemPtr = JobSystem::get_global_ptr();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int successor : m_nodes[node].successors)
+    {
+        if (--m_nodes[successor].remaining > 0)
+        {
+            continue;
+        }
+        if (m_nodes[successor].affinity == A_main_thread)
+        {
+            m_mainReady.push_back(successor);
+        }
+        else
+        {
+            jobSystemPtr->submit([this, successor]() { run_step(successor); });
+        }
+    }
+    ++m_finished;
+}
+
+void StartupGraph::print_timeline(std::ostream& out) const
+{
+    double lastMs = 0;
+    size_t nameWidth = 4;
+    for (const Node& node : m_nodes)
+    {
+        lastMs = std::max(lastMs, to_ms(node.end));
+        nameWidth = std::max(nameWidth, node.name.size());
+    }
+
+    out << "startup timeline (start, end and duration in ms since the process started):" << std::endl;
+    for (const Node& node : m_nodes)
+    {
+        const double startMs = to_ms(node.start);
+        const double endMs = to_ms(node.end);
+        std::string bar(TIMELINE_WIDTH, ' ');
+        if (lastMs > 0)
+        {
+            const int first = std::min(TIMELINE_WIDTH - 1, static_cast<int>(startMs / lastMs * TIMELINE_WIDTH));
+            const int last = std::max(first + 1, static_cast<int>(endMs / lastMs * TIMELINE_WIDTH + 0.5));
+            std::fill(bar.begin() + first, bar.begin() + std::min(last, TIMELINE_WIDTH), '#');
+        }
+
+        char times[64];
+        snprintf(times, sizeof(times), "%8.1f %8.1f %8.1f", startMs, endMs, endMs - startMs);
+        out << "  " << node.name << std::string(nameWidth - node.name.size(), ' ') << " "
+            << (node.onMainThread ? "main  " : "worker") << " " << times << " |" << bar << "|" << std::endl;
+    }
+}
+
+void StartupGraph::report_after_first_frame()
+{
+    if (!startup_timeline || m_firstFrameTaskPtr != NULL)
+    {
+        return;
+    }
+
+    // After igLoop, so the frame is rendered by then.
+    m_firstFrameTaskPtr = new GenericAsyncTask("startupReportTask", first_frame_task, this);
+    m_firstFrameTaskPtr->set_sort(100);
+    AsyncTaskManager::get_global_ptr()->add(m_firstFrameTaskPtr);
+}
+
+AsyncTask::DoneStatus StartupGraph::first_frame_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    StartupGraph* graphPtr = static_cast<StartupGraph*>(dataPtr);
+    graphPtr->print_timeline(std::cout);
+    std::cout << "startup: first frame after " << to_ms(Clock::now()) << " ms" << std::endl;
+    graphPtr->m_firstFrameTaskPtr = NULL;
+    return AsyncTask::DS_done;
+}
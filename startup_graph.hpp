@@ -0,0 +1,93 @@
+/*
+ * startup_graph.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * StartupGraph module: runs the startup steps of the game as a dependency
+ * graph. Steps that can run anywhere (font baking, shader and model
+ * loading) go to the JobSystem as soon as their prerequisites are done,
+ * and overlap with each other and with the steps that must run on the
+ * main thread (anything touching the window, events or the scene graph
+ * under render).
+ *
+ * Every step is timed. Once the first frame is rendered, the timeline of
+ * the steps and the time to first frame are printed, for CI to track
+ * (startup-timeline).
+ */
+
+#ifndef STARTUP_GRAPH_HPP_
+#define STARTUP_GRAPH_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <genericAsyncTask.h>
+
+class StartupGraph
+{
+public:
+    typedef std::function<void()> Step;
+
+    enum Affinity
+    {
+        A_any_thread,
+        A_main_thread
+    };
+
+    StartupGraph();
+    ~StartupGraph();
+
+    int add(const std::string& name, Step step, Affinity affinity = A_any_thread);
+    // `step' starts after `prerequisite' is done.
+    void add_dependency(int step, int prerequisite);
+
+    // Main thread. Returns once every step is done, false if the graph has
+    // a cycle (nothing is run then).
+    bool run();
+
+    // Start, end and thread of every step, relative to the start of the
+    // process.
+    void print_timeline(std::ostream& out) const;
+
+    // Prints the timeline once the first frame is rendered, along with the
+    // time to first frame, if startup-timeline is set.
+    void report_after_first_frame();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Node
+    {
+        std::string name;
+        Step step;
+        Affinity affinity;
+        std::vector<int> successors;
+        int numPrerequisites;
+        int remaining;
+        Clock::time_point start;
+        Clock::time_point end;
+        bool onMainThread;
+    };
+
+    void run_step(int node);
+    void release_successors(int node);
+
+    static AsyncTask::DoneStatus first_frame_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    StartupGraph(const StartupGraph&); // to prevent copies
+
+    std::vector<Node> m_nodes;
+    std::mutex m_mutex;                 // guards the fields below during run()
+    std::vector<int> m_mainReady;
+    int m_finished;
+    std::thread::id m_mainThreadId;
+    PT(GenericAsyncTask) m_firstFrameTaskPtr;
+};
+
+#endif /* STARTUP_GRAPH_HPP_ */
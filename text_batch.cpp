@@ -0,0 +1,483 @@
+/*
+ * text_batch.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <algorithm>
+
+#include <asyncTaskManager.h>
+#include <colorAttrib.h>
+#include <cullBinAttrib.h>
+#include <geom.h>
+#include <geomTriangles.h>
+#include <geomVertexWriter.h>
+#include <shaderAttrib.h>
+#include <textFont.h>
+#include <textGlyph.h>
+#include <transparencyAttrib.h>
+
+#include "frame_arena.hpp"
+#include "sdf_text.hpp"
+#include "text_batch.hpp"
+
+namespace
+{
+    // Smallest range handed to a label, in quads. Ranges are powers of two
+    // so that a label growing by a few glyphs usually stays in place.
+    const int MIN_RANGE_QUADS = 8;
+}
+
+bool TextBatch::BucketKey::operator<(const BucketKey& other) const
+{
+    if (fontPtr != other.fontPtr)
+    {
+        return fontPtr < other.fontPtr;
+    }
+    if (drawOrder != other.drawOrder)
+    {
+        return drawOrder < other.drawOrder;
+    }
+    return glyphStatePtr < other.glyphStatePtr;
+}
+
+TextBatch::TextBatch(NodePath parent, const std::string& name)
+    : m_rewrittenLabels(0)
+{
+    m_rootNp = parent.attach_new_node(name);
+
+    // After the game tasks have updated their labels, before cull.
+    m_flushTaskPtr = new GenericAsyncTask("textBatchTask", flush_task, this);
+    m_flushTaskPtr->set_sort(45);
+    AsyncTaskManager::get_global_ptr()->add(m_flushTaskPtr);
+}
+
+TextBatch::~TextBatch()
+{
+    m_flushTaskPtr->remove();
+
+    for (auto& slot : m_labels)
+    {
+        if (slot.labelPtr != NULL)
+        {
+            slot.labelPtr->on_batch_destroyed();
+        }
+    }
+    m_rootNp.remove_node();
+}
+
+int TextBatch::add_label(Label* labelPtr)
+{
+    // preconditions
+    if (labelPtr == NULL)
+    {
+        nout << "ERROR: parameter labelPtr cannot be NULL." << std::endl;
+        return -1;
+    }
+
+    int labelId;
+    if (!m_freeLabels.empty())
+    {
+        labelId = m_freeLabels.back();
+        m_freeLabels.pop_back();
+    }
+    else
+    {
+        labelId = static_cast<int>(m_labels.size());
+        m_labels.push_back(LabelSlot());
+    }
+
+    LabelSlot& slot = m_labels[labelId];
+    slot.labelPtr = labelPtr;
+    slot.dirty = true;
+    slot.visible = false;
+    slot.ranges.clear();
+    m_dirtyLabels.push_back(labelId);
+    return labelId;
+}
+
+void TextBatch::remove_label(int labelId)
+{
+    LabelSlot& slot = m_labels[labelId];
+    for (const Range& range : slot.ranges)
+    {
+        release(range);
+    }
+    slot.ranges.clear();
+    slot.labelPtr = NULL;
+    slot.dirty = false;
+    m_freeLabels.push_back(labelId);
+}
+
+void TextBatch::mark_dirty(int labelId)
+{
+    LabelSlot& slot = m_labels[labelId];
+    if (!slot.dirty)
+    {
+        slot.dirty = true;
+        m_dirtyLabels.push_back(labelId);
+    }
+}
+
+void TextBatch::flush()
+{
+    // Nothing tells the batch when a NodePath hides or moves a label.
+    for (int labelId = 0, labelEnd = static_cast<int>(m_labels.size()); labelId < labelEnd; ++labelId)
+    {
+        const LabelSlot& slot = m_labels[labelId];
+        if (slot.labelPtr != NULL && slot.labelPtr->is_visible() != slot.visible)
+        {
+            mark_dirty(labelId);
+        }
+    }
+
+    m_rewrittenLabels = 0;
+    for (int labelId : m_dirtyLabels)
+    {
+        LabelSlot& slot = m_labels[labelId];
+        if (slot.labelPtr != NULL && slot.dirty)
+        {
+            rewrite_label(slot);
+            slot.dirty = false;
+            ++m_rewrittenLabels;
+        }
+    }
+    m_dirtyLabels.clear();
+}
+
+bool TextBatch::can_batch(const TextNode* propertiesPtr)
+{
+    // The only shader the batch knows is the plain one of SDF fonts:
+    // outlined text is drawn by its front end.
+    const RenderAttrib* shaderAttribPtr = propertiesPtr->get_attrib(ShaderAttrib::get_class_slot());
+    return !propertiesPtr->has_wordwrap() && !propertiesPtr->has_card() && !propertiesPtr->has_frame() &&
+           (shaderAttribPtr == NULL || shaderAttribPtr == SdfText::make_shader_attrib());
+}
+
+NodePath TextBatch::get_root() const
+{
+    return m_rootNp;
+}
+
+TextBatch::Stats TextBatch::get_stats() const
+{
+    Stats stats;
+    stats.numLabels = static_cast<int>(m_labels.size() - m_freeLabels.size());
+    stats.numGeoms = static_cast<int>(m_buckets.size());
+    for (const Bucket& bucket : m_buckets)
+    {
+        stats.numQuads += bucket.numQuads;
+    }
+    stats.rewrittenLabels = m_rewrittenLabels;
+    return stats;
+}
+
+void TextBatch::rewrite_label(LabelSlot& slot)
+{
+    for (auto& quads : m_layoutQuads)
+    {
+        quads.clear();
+    }
+    slot.visible = slot.labelPtr->is_visible();
+    if (can_batch(slot.labelPtr->get_properties()) && slot.visible)
+    {
+        layout_label(*slot.labelPtr);
+    }
+
+    // Rewrite in place when the label still fits in its ranges, move it
+    // elsewhere in the bucket otherwise.
+    FrameVector<char> written(m_buckets.size(), 0);
+    FrameVector<Range> ranges;
+    for (const Range& range : slot.ranges)
+    {
+        const std::vector<Quad>& quads = m_layoutQuads[range.bucket];
+        if (!quads.empty() && static_cast<int>(quads.size()) <= range.capacity)
+        {
+            write_quads(range, quads);
+            ranges.push_back(range);
+            written[range.bucket] = 1;
+        }
+        else
+        {
+            release(range);
+        }
+    }
+
+    for (int bucketId = 0, bucketEnd = static_cast<int>(m_buckets.size()); bucketId < bucketEnd; ++bucketId)
+    {
+        const std::vector<Quad>& quads = m_layoutQuads[bucketId];
+        if (!written[bucketId] && !quads.empty())
+        {
+            Range range = allocate(bucketId, static_cast<int>(quads.size()));
+            write_quads(range, quads);
+            ranges.push_back(range);
+        }
+    }
+    slot.ranges.assign(ranges.begin(), ranges.end());
+}
+
+void TextBatch::layout_label(const Label& label)
+{
+    const TextNode* propertiesPtr = label.get_properties();
+    TextFont* fontPtr = propertiesPtr->get_font();
+    if (fontPtr == NULL)
+    {
+        fontPtr = TextProperties::get_default_font();
+    }
+    if (fontPtr == NULL)
+    {
+        return;
+    }
+
+    const LMatrix4f placement = label.get_placement();
+    const std::wstring text = propertiesPtr->get_wtext();
+    const float scale = propertiesPtr->get_text_scale();
+
+    float alignFactor = 0;
+    if (propertiesPtr->get_align() == TextNode::A_center)
+    {
+        alignFactor = 0.5f;
+    }
+    else if (propertiesPtr->get_align() == TextNode::A_right)
+    {
+        alignFactor = 1;
+    }
+
+    // One line at a time, like TextAssembler without the word wrapping.
+    float y = 0;
+    size_t lineStart = 0;
+    while (lineStart <= text.size())
+    {
+        size_t lineEnd = text.find(L'\n', lineStart);
+        if (lineEnd == std::wstring::npos)
+        {
+            lineEnd = text.size();
+        }
+
+        float width = 0;
+        for (size_t k = lineStart; k < lineEnd; ++k)
+        {
+            CPT(TextGlyph) glyphPtr;
+            if (text[k] == L' ')
+            {
+                width += fontPtr->get_space_advance() * scale;
+            }
+            else if (fontPtr->get_glyph(text[k], glyphPtr) && glyphPtr != NULL)
+            {
+                width += glyphPtr->get_advance() * scale;
+            }
+        }
+
+        float x = -alignFactor * width;
+        for (size_t k = lineStart; k < lineEnd; ++k)
+        {
+            CPT(TextGlyph) glyphPtr;
+            if (text[k] == L' ')
+            {
+                x += fontPtr->get_space_advance() * scale;
+            }
+            else if (fontPtr->get_glyph(text[k], glyphPtr) && glyphPtr != NULL)
+            {
+                add_glyph_quads(propertiesPtr, placement, glyphPtr, x, y);
+                x += glyphPtr->get_advance() * scale;
+            }
+        }
+
+        y -= fontPtr->get_line_height() * scale;
+        lineStart = lineEnd + 1;
+    }
+}
+
+void TextBatch::add_glyph_quads(const TextNode* propertiesPtr, const LMatrix4f& placement,
+                                const TextGlyph* glyphPtr, float x, float y)
+{
+    LVecBase4 dimensions;
+    Quad quad;
+    if (!glyphPtr->get_quad(dimensions, quad.texcoords))
+    {
+        return;
+    }
+
+    TextFont* fontPtr = propertiesPtr->get_font() != NULL ? propertiesPtr->get_font() : TextProperties::get_default_font();
+    const float scale = propertiesPtr->get_text_scale();
+    const int drawOrder = propertiesPtr->get_draw_order();
+
+    auto make_corners = [&](float dx, float dz) {
+        const float left = x + dimensions[0] * scale + dx;
+        const float bottom = y + dimensions[1] * scale + dz;
+        const float right = x + dimensions[2] * scale + dx;
+        const float top = y + dimensions[3] * scale + dz;
+        quad.corners[0] = placement.xform_point(LPoint3f(left, 0, bottom));
+        quad.corners[1] = placement.xform_point(LPoint3f(right, 0, bottom));
+        quad.corners[2] = placement.xform_point(LPoint3f(left, 0, top));
+        quad.corners[3] = placement.xform_point(LPoint3f(right, 0, top));
+    };
+
+    // The shadow goes in a bucket drawn just before the text.
+    if (propertiesPtr->has_shadow())
+    {
+        const LVecBase2f shadow = propertiesPtr->get_shadow();
+        make_corners(shadow[0], -shadow[1]);
+        quad.color = propertiesPtr->get_shadow_color();
+        m_layoutQuads[get_bucket(fontPtr, drawOrder, glyphPtr->get_state())].push_back(quad);
+    }
+
+    make_corners(0, 0);
+    quad.color = propertiesPtr->get_text_color();
+    m_layoutQuads[get_bucket(fontPtr, drawOrder + 1, glyphPtr->get_state())].push_back(quad);
+}
+
+int TextBatch::get_bucket(const TextFont* fontPtr, int drawOrder, const RenderState* glyphStatePtr)
+{
+    BucketKey key = { fontPtr, drawOrder, glyphStatePtr };
+    std::map<BucketKey, int>::const_iterator it = m_bucketIds.find(key);
+    if (it != m_bucketIds.end())
+    {
+        return it->second;
+    }
+
+    PT(GeomVertexData) vdataPtr = new GeomVertexData("text-batch", GeomVertexFormat::get_v3c4t2(), Geom::UH_dynamic);
+    PT(GeomTriangles) trianglesPtr = new GeomTriangles(Geom::UH_dynamic);
+    trianglesPtr->set_index_type(Geom::NT_uint32);
+    PT(Geom) geomPtr = new Geom(vdataPtr);
+    geomPtr->add_primitive(trianglesPtr);
+
+    // The glyph state holds the font page; colors come from the vertices.
+    // Note: batched text always goes to the fixed bin, like the text of
+    // COnscreenText::set_draw_order().
+    CPT(RenderState) statePtr = glyphStatePtr != NULL ? glyphStatePtr : RenderState::make_empty();
+    statePtr = statePtr->add_attrib(ColorAttrib::make_vertex());
+    statePtr = statePtr->add_attrib(CullBinAttrib::make("fixed", drawOrder));
+    statePtr = statePtr->add_attrib(TransparencyAttrib::make(TransparencyAttrib::M_alpha));
+    if (SdfText::is_sdf_font(fontPtr))
+    {
+        statePtr = statePtr->add_attrib(SdfText::make_shader_attrib());
+    }
+
+    Bucket bucket;
+    bucket.geomNodePtr = new GeomNode("text-batch-geom");
+    bucket.geomNodePtr->add_geom(geomPtr, statePtr);
+    bucket.numQuads = 0;
+    m_rootNp.attach_new_node(bucket.geomNodePtr);
+
+    const int bucketId = static_cast<int>(m_buckets.size());
+    m_buckets.push_back(bucket);
+    m_bucketIds[key] = bucketId;
+    m_layoutQuads.resize(m_buckets.size());
+    return bucketId;
+}
+
+TextBatch::Range TextBatch::allocate(int bucketId, int count)
+{
+    Bucket& bucket = m_buckets[bucketId];
+    Range range;
+    range.bucket = bucketId;
+    range.capacity = MIN_RANGE_QUADS;
+    while (range.capacity < count)
+    {
+        range.capacity *= 2;
+    }
+
+    for (size_t k = 0; k < bucket.freeRanges.size(); ++k)
+    {
+        std::pair<int, int>& freeRange = bucket.freeRanges[k];
+        if (freeRange.second >= range.capacity)
+        {
+            range.firstQuad = freeRange.first;
+            freeRange.first += range.capacity;
+            freeRange.second -= range.capacity;
+            if (freeRange.second == 0)
+            {
+                bucket.freeRanges.erase(bucket.freeRanges.begin() + k);
+            }
+            return range;
+        }
+    }
+
+    // Grow the buffer; the new quads are degenerate until written.
+    range.firstQuad = bucket.numQuads;
+    const int numQuads = bucket.numQuads + range.capacity;
+    PT(Geom) geomPtr = bucket.geomNodePtr->modify_geom(0);
+    geomPtr->modify_vertex_data()->set_num_rows(numQuads * 4);
+    PT(GeomPrimitive) trianglesPtr = geomPtr->modify_primitive(0);
+    for (int quad = bucket.numQuads; quad < numQuads; ++quad)
+    {
+        const int first = quad * 4;
+        trianglesPtr->add_vertices(first, first + 1, first + 2);
+        trianglesPtr->add_vertices(first + 2, first + 1, first + 3);
+    }
+    bucket.numQuads = numQuads;
+    return range;
+}
+
+void TextBatch::release(const Range& range)
+{
+    static const std::vector<Quad> noQuads;
+    write_quads(range, noQuads);
+
+    // Merge with the free neighbors, so that labels growing and shrinking
+    // don't cut the buffer in ever smaller pieces.
+    std::vector<std::pair<int, int>>& freeRanges = m_buckets[range.bucket].freeRanges;
+    auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), std::make_pair(range.firstQuad, 0));
+    if (next != freeRanges.begin() && (next - 1)->first + (next - 1)->second == range.firstQuad)
+    {
+        auto previous = next - 1;
+        previous->second += range.capacity;
+        if (next != freeRanges.end() && next->first == range.firstQuad + range.capacity)
+        {
+            previous->second += next->second;
+            freeRanges.erase(next);
+        }
+    }
+    else if (next != freeRanges.end() && next->first == range.firstQuad + range.capacity)
+    {
+        next->first = range.firstQuad;
+        next->second += range.capacity;
+    }
+    else
+    {
+        freeRanges.insert(next, std::make_pair(range.firstQuad, range.capacity));
+    }
+}
+
+void TextBatch::write_quads(const Range& range, const std::vector<Quad>& quads)
+{
+    PT(GeomVertexData) vdataPtr = m_buckets[range.bucket].geomNodePtr->modify_geom(0)->modify_vertex_data();
+    GeomVertexWriter vertex(vdataPtr, InternalName::get_vertex());
+    GeomVertexWriter color(vdataPtr, InternalName::get_color());
+    GeomVertexWriter texcoord(vdataPtr, InternalName::get_texcoord());
+    vertex.set_row(range.firstQuad * 4);
+    color.set_row(range.firstQuad * 4);
+    texcoord.set_row(range.firstQuad * 4);
+
+    for (const Quad& quad : quads)
+    {
+        const LVecBase4f& uv = quad.texcoords;
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            vertex.set_data3f(quad.corners[corner]);
+            color.set_data4f(quad.color);
+        }
+        texcoord.set_data2f(uv[0], uv[1]);
+        texcoord.set_data2f(uv[2], uv[1]);
+        texcoord.set_data2f(uv[0], uv[3]);
+        texcoord.set_data2f(uv[2], uv[3]);
+    }
+
+    // Collapse the rest of the range to nothing.
+    for (int quad = static_cast<int>(quads.size()); quad < range.capacity; ++quad)
+    {
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            vertex.set_data3f(0, 0, 0);
+            color.set_data4f(0, 0, 0, 0);
+            texcoord.set_data2f(0, 0);
+        }
+    }
+}
+
+AsyncTask::DoneStatus TextBatch::flush_task(GenericAsyncTask* taskPtr, void* dataPtr)
+{
+    static_cast<TextBatch*>(dataPtr)->flush();
+    return AsyncTask::DS_cont;
+}
@@ -0,0 +1,143 @@
+/*
+ * text_batch.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * TextBatch module: draws many text labels with a handful of Geoms. The
+ * glyph quads of every label sharing a font page and a draw order are
+ * packed in one dynamic vertex buffer, each label owning a range of it,
+ * and only the ranges of the labels that changed are rewritten, once per
+ * frame before cull.
+ *
+ * Labels are placed in the space of the batch root, whatever their own
+ * NodePath. Their visibility is polled every flush, so a label hidden or
+ * detached through any NodePath (Label::is_visible()) draws nothing but
+ * keeps its place. Freed ranges are merged with their free
+ * neighbors. Word wrapped, carded or framed labels can't be batched, nor
+ * labels with a shader other than the plain SDF text one; their front end
+ * draws them itself (see COnscreenText::set_batch()).
+ */
+
+#ifndef TEXT_BATCH_HPP_
+#define TEXT_BATCH_HPP_
+
+#include <map>
+#include <vector>
+
+#include <genericAsyncTask.h>
+#include <geomNode.h>
+#include <nodePath.h>
+#include <textNode.h>
+
+class TextBatch
+{
+public:
+    // Implemented by the front ends of the labels, such as COnscreenText.
+    class Label
+    {
+    public:
+        virtual ~Label() = default;
+
+        // The text and its look: font, alignment, colors, shadow and draw
+        // order.
+        virtual const TextNode* get_properties() const = 0;
+
+        // From text space to the space of the batch root.
+        virtual LMatrix4f get_placement() const = 0;
+
+        // Hidden or detached labels keep their id but draw nothing. Asked
+        // at every flush.
+        virtual bool is_visible() const = 0;
+
+        // The batch is going away: forget about it.
+        virtual void on_batch_destroyed() = 0;
+    };
+
+    struct Stats
+    {
+        int numLabels = 0;
+        int numGeoms = 0;
+        int numQuads = 0;
+        int rewrittenLabels = 0;    // during the last flush
+    };
+
+    TextBatch(NodePath parent, const std::string& name = "text-batch");
+    ~TextBatch();
+
+    int add_label(Label* labelPtr);
+    void remove_label(int labelId);
+    void mark_dirty(int labelId);
+
+    // Rewrite the ranges of the labels marked dirty, or shown or hidden
+    // since the last flush. Called by the batch's own task every frame.
+    void flush();
+
+    static bool can_batch(const TextNode* propertiesPtr);
+
+    NodePath get_root() const;
+    Stats get_stats() const;
+
+private:
+    struct BucketKey
+    {
+        const TextFont* fontPtr;
+        int drawOrder;
+        const RenderState* glyphStatePtr;   // one per font page
+
+        bool operator<(const BucketKey& other) const;
+    };
+
+    struct Bucket
+    {
+        PT(GeomNode) geomNodePtr;
+        int numQuads;                       // quads allocated in the buffer
+        std::vector<std::pair<int, int>> freeRanges;    // first quad, count; sorted, never adjacent
+    };
+
+    struct Range
+    {
+        int bucket;
+        int firstQuad;
+        int capacity;
+    };
+
+    struct Quad
+    {
+        LPoint3f corners[4];                // bottom left, bottom right, top left, top right
+        LVecBase4f texcoords;               // left, bottom, right, top
+        LColorf color;
+    };
+
+    struct LabelSlot
+    {
+        Label* labelPtr;
+        bool dirty;
+        bool visible;                       // as of its last rewrite
+        std::vector<Range> ranges;
+    };
+
+    void rewrite_label(LabelSlot& slot);
+    void layout_label(const Label& label);
+    void add_glyph_quads(const TextNode* propertiesPtr, const LMatrix4f& placement,
+                         const TextGlyph* glyphPtr, float x, float y);
+    int get_bucket(const TextFont* fontPtr, int drawOrder, const RenderState* glyphStatePtr);
+    Range allocate(int bucketId, int count);
+    void release(const Range& range);
+    void write_quads(const Range& range, const std::vector<Quad>& quads);
+
+    static AsyncTask::DoneStatus flush_task(GenericAsyncTask* taskPtr, void* dataPtr);
+
+    TextBatch(const TextBatch&); // to prevent copies
+
+    NodePath m_rootNp;
+    std::vector<Bucket> m_buckets;
+    std::map<BucketKey, int> m_bucketIds;
+    std::vector<LabelSlot> m_labels;
+    std::vector<int> m_freeLabels;
+    std::vector<int> m_dirtyLabels;
+    std::vector<std::vector<Quad>> m_layoutQuads;   // per bucket, scratch for layout_label()
+    PT(GenericAsyncTask) m_flushTaskPtr;
+    int m_rewrittenLabels;
+};
+
+#endif /* TEXT_BATCH_HPP_ */
@@ -0,0 +1,151 @@
+/*
+ * text_layout_cache.cpp
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <tuple>
+
+#include <configVariableInt.h>
+
+#include "text_layout_cache.hpp"
+
+namespace
+{
+    ConfigVariableInt text_layout_cache_size
+    ("text-layout-cache-size", 256,
+     PRC_DESC("Number of laid out strings kept by the COnscreenText layout "
+              "cache. 0 disables the cache."));
+}
+
+bool TextLayoutCache::Key::operator<(const Key& other) const
+{
+    // Note: the text is compared last, it is the most expensive field.
+    return std::tie(fontPtr, wordwrap, align, textScale, slant, glyphScale, glyphShift, tabWidth,
+                    smallCapsScale, underscoreHeight, textColor, shadowColor, shadowOffset,
+                    cardColor, cardMargins, frameColor, frameMargins, cardDecal, drawOrder, bin, text) <
+           std::tie(other.fontPtr, other.wordwrap, other.align, other.textScale, other.slant, other.glyphScale,
+                    other.glyphShift, other.tabWidth, other.smallCapsScale, other.underscoreHeight,
+                    other.textColor, other.shadowColor, other.shadowOffset, other.cardColor, other.cardMargins,
+                    other.frameColor, other.frameMargins, other.cardDecal, other.drawOrder, other.bin, other.text);
+}
+
+TextLayoutCache* TextLayoutCache::get_global_ptr()
+{
+    static TextLayoutCache cache;
+    return &cache;
+}
+
+TextLayoutCache::TextLayoutCache()
+{
+}
+
+PT(PandaNode) TextLayoutCache::get_layout(TextNode* textNodePtr, const std::wstring& text)
+{
+    // preconditions
+    if (textNodePtr == NULL)
+    {
+        nout << "ERROR: parameter textNodePtr cannot be NULL." << std::endl;
+        return NULL;
+    }
+
+    const int capacity = text_layout_cache_size;
+    Key key = make_key(textNodePtr, text);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EntryMap::iterator it = m_entries.find(key);
+        if (it != m_entries.end())
+        {
+            ++m_stats.hits;
+            m_uses.splice(m_uses.begin(), m_uses, it->second.use);
+            return it->second.nodePtr;
+        }
+        ++m_stats.misses;
+    }
+
+    // Generate outside of the lock; the text node has its own.
+    PT(PandaNode) nodePtr;
+    if (textNodePtr->get_wtext() == text)
+    {
+        nodePtr = textNodePtr->generate();
+    }
+    else
+    {
+        PT(TextNode) layoutNodePtr = new TextNode("layout", *textNodePtr);
+        layoutNodePtr->set_wtext(text);
+        nodePtr = layoutNodePtr->generate();
+    }
+
+    if (capacity <= 0)
+    {
+        return nodePtr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::pair<EntryMap::iterator, bool> inserted = m_entries.insert(EntryMap::value_type(std::move(key), Entry()));
+    if (inserted.second)
+    {
+        m_uses.push_front(&inserted.first->first);
+        inserted.first->second.use = m_uses.begin();
+        inserted.first->second.nodePtr = nodePtr;
+    }
+
+    while (static_cast<int>(m_entries.size()) > capacity)
+    {
+        EntryMap::iterator oldest = m_entries.find(*m_uses.back());
+        m_uses.pop_back();
+        m_entries.erase(oldest);
+    }
+    return inserted.first->second.nodePtr;
+}
+
+int TextLayoutCache::get_num_entries() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_entries.size());
+}
+
+TextLayoutCache::Stats TextLayoutCache::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void TextLayoutCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_uses.clear();
+}
+
+TextLayoutCache::Key TextLayoutCache::make_key(const TextNode* textNodePtr, const std::wstring& text)
+{
+    Key key;
+    key.fontPtr = textNodePtr->get_font();
+    key.text = text;
+    key.wordwrap = textNodePtr->has_wordwrap() ? textNodePtr->get_wordwrap() : 0;
+    key.align = textNodePtr->get_align();
+    key.textScale = textNodePtr->get_text_scale();
+    key.slant = textNodePtr->get_slant();
+    key.glyphScale = textNodePtr->get_glyph_scale();
+    key.glyphShift = textNodePtr->get_glyph_shift();
+    key.tabWidth = textNodePtr->get_tab_width();
+    key.smallCapsScale = textNodePtr->get_small_caps() ? textNodePtr->get_small_caps_scale() : 0;
+    key.underscoreHeight = textNodePtr->get_underscore() ? textNodePtr->get_underscore_height() : -1;
+    key.textColor = textNodePtr->get_text_color();
+    key.shadowColor = textNodePtr->has_shadow() ? textNodePtr->get_shadow_color() : LColorf::zero();
+    key.shadowOffset = textNodePtr->has_shadow() ? LVecBase2f(textNodePtr->get_shadow()) : LVecBase2f::zero();
+    // The card and the frame are TextNode properties, not TextProperties:
+    // a layout TextNode copied from `textNodePtr' has neither.
+    const bool sameText = textNodePtr->get_wtext() == text;
+    const bool card = sameText && textNodePtr->has_card();
+    const bool frame = sameText && textNodePtr->has_frame();
+    key.cardColor = card ? textNodePtr->get_card_color() : LColorf::zero();
+    key.cardMargins = card ? LVecBase4f(textNodePtr->get_card_as_set()) : LVecBase4f::zero();
+    key.frameColor = frame ? textNodePtr->get_frame_color() : LColorf::zero();
+    key.frameMargins = frame ? LVecBase4f(textNodePtr->get_frame_as_set()) : LVecBase4f::zero();
+    key.cardDecal = sameText && textNodePtr->get_card_decal();
+    key.bin = textNodePtr->get_bin();
+    key.drawOrder = textNodePtr->get_draw_order();
+    return key;
+}
@@ -0,0 +1,96 @@
+/*
+ * text_layout_cache.hpp
+ *
+ *  Created on: 2026-10-18
+ *
+ * TextLayoutCache module: keeps the glyph geometry generated by TextNode
+ * for recently displayed strings, so that showing the same text again with
+ * the same look (a counter going back to a previous value, several labels
+ * with the same caption) reuses it instead of laying it out again.
+ *
+ * Entries are keyed by everything that changes the generated geometry:
+ * font, text, wordwrap, alignment, scale, slant, glyph scale and shift,
+ * tab width, small caps, underscore, colors, shadow, card, frame and bin.
+ * The least recently used entries are dropped past text-layout-cache-size.
+ */
+
+#ifndef TEXT_LAYOUT_CACHE_HPP_
+#define TEXT_LAYOUT_CACHE_HPP_
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <pandaNode.h>
+#include <textNode.h>
+
+class TextLayoutCache
+{
+public:
+    struct Stats
+    {
+        int hits = 0;
+        int misses = 0;
+    };
+
+    static TextLayoutCache* get_global_ptr();
+
+    // Returns the geometry of `text' laid out with the properties of
+    // `textNode', generating it on a miss. The returned node is shared:
+    // instance it, don't modify it.
+    PT(PandaNode) get_layout(TextNode* textNodePtr, const std::wstring& text);
+
+    int get_num_entries() const;
+    Stats get_stats() const;
+    void clear();
+
+private:
+    struct Key
+    {
+        const TextFont* fontPtr;
+        std::wstring text;
+        float wordwrap;
+        int align;
+        float textScale;
+        float slant;
+        float glyphScale;
+        float glyphShift;
+        float tabWidth;
+        float smallCapsScale;               // 0 without small caps
+        float underscoreHeight;             // -1 without underscore
+        LColorf textColor;
+        LColorf shadowColor;
+        LVecBase2f shadowOffset;
+        LColorf cardColor;
+        LVecBase4f cardMargins;
+        LColorf frameColor;
+        LVecBase4f frameMargins;
+        bool cardDecal;
+        std::string bin;
+        int drawOrder;
+
+        bool operator<(const Key& other) const;
+    };
+
+    typedef std::list<const Key*> UseList;
+
+    struct Entry
+    {
+        PT(PandaNode) nodePtr;
+        UseList::iterator use;
+    };
+
+    typedef std::map<Key, Entry> EntryMap;
+
+    TextLayoutCache();
+
+    static Key make_key(const TextNode* textNodePtr, const std::wstring& text);
+
+    mutable std::mutex m_mutex;
+    EntryMap m_entries;
+    UseList m_uses;             // most recently used first
+    Stats m_stats;
+};
+
+#endif /* TEXT_LAYOUT_CACHE_HPP_ */